@@ -26,6 +26,7 @@ PYBIND11_MODULE(oead, m) {
   oead::bind::BindAamp(m);
   oead::bind::BindByml(m);
   oead::bind::BindGsheet(m);
+  oead::bind::BindRstb(m);
   oead::bind::BindSarc(m);
   oead::bind::BindYaz0(m);
 }
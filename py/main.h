@@ -31,6 +31,7 @@ void BindAamp(py::module& m);
 void BindByml(py::module& m);
 void BindCommonTypes(py::module& m);
 void BindGsheet(py::module& m);
+void BindRstb(py::module& m);
 void BindSarc(py::module& m);
 void BindYaz0(py::module& m);
 
@@ -26,6 +26,8 @@
 #include <pybind11/pybind11.h>
 
 #include <oead/aamp.h>
+#include <oead/aamp_flat.h>
+#include <oead/aamp_view.h>
 #include "main.h"
 
 OEAD_MAKE_VARIANT_CASTER(oead::aamp::Parameter::Value);
@@ -82,6 +84,31 @@ static void BindAampParameter(py::module& m) {
   py::implicitly_convertible<aamp::Parameter::Value, aamp::Parameter>();
 }
 
+/// Binds the getters that are shared by ParameterIOView::ParameterView and
+/// FlatParameterIO::ParameterEntry.
+template <typename Param>
+static void BindParameterGetters(py::class_<Param>& cl) {
+  cl.def("name", &Param::GetName)
+      .def("type", &Param::GetType)
+      .def("get_bool", &Param::GetBool)
+      .def("get_f32", &Param::GetF32)
+      .def("get_int", &Param::GetInt)
+      .def("get_u32", &Param::GetU32)
+      .def("get_vec2", &Param::GetVec2)
+      .def("get_vec3", &Param::GetVec3)
+      .def("get_vec4", &Param::GetVec4)
+      .def("get_color", &Param::GetColor)
+      .def("get_quat", &Param::GetQuat)
+      .def("get_string", &Param::GetString)
+      // Curves and buffers are returned as memoryviews that refer to the parameter data.
+      .def("get_curves", &Param::GetCurves, py::keep_alive<0, 1>())
+      .def("get_buffer_int", &Param::GetBufferInt, py::keep_alive<0, 1>())
+      .def("get_buffer_f32", &Param::GetBufferF32, py::keep_alive<0, 1>())
+      .def("get_buffer_u32", &Param::GetBufferU32, py::keep_alive<0, 1>())
+      .def("get_buffer_binary", &Param::GetBufferBinary, py::keep_alive<0, 1>())
+      .def("to_parameter", &Param::ToParameter);
+}
+
 void BindAamp(py::module& parent) {
   py::module m = parent.def_submodule("aamp");
 
@@ -127,7 +154,10 @@ void BindAamp(py::module& parent) {
       .def_static("from_binary", &aamp::ParameterIO::FromBinary, "buffer"_a)
       .def_static("from_text", &aamp::ParameterIO::FromText, "yml_text"_a)
       .def("to_binary", &aamp::ParameterIO::ToBinary)
-      .def("to_text", &aamp::ParameterIO::ToText);
+      .def("to_text", &aamp::ParameterIO::ToText, "num_threads"_a = 1,
+           ":param num_threads: Number of threads to use for the lists in param_root "
+           "(0: one per core).",
+           py::call_guard<py::gil_scoped_release>());
 
   BindMap<aamp::ParameterMap>(m, "ParameterMap");
   BindMap<aamp::ParameterObjectMap>(m, "ParameterObjectMap");
@@ -138,9 +168,86 @@ void BindAamp(py::module& parent) {
       .def("__copy__", [](const aamp::NameTable& o) { return aamp::NameTable(o); })
       .def("__deepcopy__", [](const aamp::NameTable& o, py::dict) { return aamp::NameTable(o); })
       .def("get_name", &aamp::NameTable::GetName, "hash"_a, "index"_a, "parent_name_hash"_a)
-      .def("add_name", py::overload_cast<std::string>(&aamp::NameTable::AddName), "name"_a);
+      .def("add_name", py::overload_cast<std::string>(&aamp::NameTable::AddName), "name"_a)
+      .def_readwrite("numbered_name_index_limit", &aamp::NameTable::numbered_name_index_limit)
+      .def("save_numbered_name_index", &aamp::NameTable::SaveNumberedNameIndex)
+      .def("load_numbered_name_index", &aamp::NameTable::LoadNumberedNameIndex, "data"_a);
 
   m.def("get_default_name_table", &aamp::GetDefaultNameTable, py::return_value_policy::reference,
         "Just like in C++, this returns the default instance of the name table. It is modifiable.");
+
+  using View = aamp::ParameterIOView;
+  py::class_<View>(m, "ParameterIOView")
+      .def(py::init<tcb::span<const u8>>(), "data"_a, py::keep_alive<1, 2>())
+      .def_property_readonly("version", &View::GetVersion)
+      .def_property_readonly("type", &View::GetType)
+      .def("get_root", &View::GetRoot, py::keep_alive<0, 1>())
+      .def("find_parameter", &View::FindParameter, "path"_a, py::keep_alive<0, 1>());
+
+  py::class_<View::ListView>(m, "ParameterListView")
+      .def("name", &View::ListView::GetName)
+      .def("num_lists", &View::ListView::NumLists)
+      .def("num_objects", &View::ListView::NumObjects)
+      .def("list", &View::ListView::List, "name"_a, py::keep_alive<0, 1>())
+      .def("object", &View::ListView::Object, "name"_a, py::keep_alive<0, 1>())
+      .def("find_list", &View::ListView::FindList, "name"_a, py::keep_alive<0, 1>())
+      .def("find_object", &View::ListView::FindObject, "name"_a, py::keep_alive<0, 1>())
+      .def("list_at", &View::ListView::ListAt, "index"_a, py::keep_alive<0, 1>())
+      .def("object_at", &View::ListView::ObjectAt, "index"_a, py::keep_alive<0, 1>())
+      .def("to_list", &View::ListView::ToList);
+
+  py::class_<View::ObjectView>(m, "ParameterObjectView")
+      .def("name", &View::ObjectView::GetName)
+      .def("__len__", &View::ObjectView::Size)
+      .def("__getitem__", &View::ObjectView::operator[], "name"_a, py::keep_alive<0, 1>())
+      .def("__contains__", &View::ObjectView::Contains, "name"_a)
+      .def("find", &View::ObjectView::Find, "name"_a, py::keep_alive<0, 1>())
+      .def("parameter_at", &View::ObjectView::ParameterAt, "index"_a, py::keep_alive<0, 1>())
+      .def("to_object", &View::ObjectView::ToObject);
+
+  py::class_<View::ParameterView> param_view_cl(m, "ParameterView");
+  BindParameterGetters(param_view_cl);
+
+  using Flat = aamp::FlatParameterIO;
+  py::class_<Flat> flat_cl(m, "FlatParameterIO");
+  flat_cl.attr("ROOT_LIST_ID") = Flat::RootListId;
+  flat_cl.def_static("from_binary", &Flat::FromBinary, "buffer"_a)
+      .def_static("from_parameter_io", &Flat::FromParameterIO, "pio"_a)
+      .def("to_parameter_io", &Flat::ToParameterIO)
+      .def("to_binary", &Flat::ToBinary)
+      .def_property_readonly("version", &Flat::GetVersion)
+      .def_property_readonly("type", &Flat::GetType)
+      .def("list_at", &Flat::ListAt, "id"_a, py::return_value_policy::reference_internal)
+      .def("object_at", &Flat::ObjectAt, "id"_a, py::return_value_policy::reference_internal)
+      .def("parameter_at", &Flat::ParameterAt, "id"_a,
+           py::return_value_policy::reference_internal)
+      .def("num_lists", [](const Flat& pio) { return pio.GetLists().size(); })
+      .def("num_objects", [](const Flat& pio) { return pio.GetObjects().size(); })
+      .def("num_parameters", [](const Flat& pio) { return pio.GetParameters().size(); })
+      .def("find_list", &Flat::FindList, "list"_a, "name"_a)
+      .def("find_object", &Flat::FindObject, "list"_a, "name"_a)
+      .def("find_parameter",
+           py::overload_cast<Flat::Id, aamp::Name>(&Flat::FindParameter, py::const_),
+           "object"_a, "name"_a)
+      .def("find_parameter",
+           py::overload_cast<std::string_view>(&Flat::FindParameter, py::const_), "path"_a)
+      .def("to_list", &Flat::ToList, "id"_a)
+      .def("to_object", &Flat::ToObject, "id"_a)
+      .def("get_arena_size", &Flat::GetArenaSize);
+
+  py::class_<Flat::ListEntry>(m, "FlatParameterList")
+      .def_readonly("name", &Flat::ListEntry::name)
+      .def_readonly("lists_begin", &Flat::ListEntry::lists_begin)
+      .def_readonly("num_lists", &Flat::ListEntry::num_lists)
+      .def_readonly("objects_begin", &Flat::ListEntry::objects_begin)
+      .def_readonly("num_objects", &Flat::ListEntry::num_objects);
+
+  py::class_<Flat::ObjectEntry>(m, "FlatParameterObject")
+      .def_readonly("name", &Flat::ObjectEntry::name)
+      .def_readonly("parameters_begin", &Flat::ObjectEntry::parameters_begin)
+      .def_readonly("num_parameters", &Flat::ObjectEntry::num_parameters);
+
+  py::class_<Flat::ParameterEntry> flat_param_cl(m, "FlatParameter");
+  BindParameterGetters(flat_param_cl);
 }
 }  // namespace oead::bind
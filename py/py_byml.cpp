@@ -20,13 +20,20 @@
 #include <functional>
 #include <map>
 #include <nonstd/span.h>
+#include <optional>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 
 #include <oead/byml.h>
+#include <oead/byml_diff.h>
+#include <oead/byml_document.h>
+#include <oead/byml_patch.h>
+#include <oead/byml_query.h>
+#include <oead/byml_view.h>
 #include <oead/util/scope_guard.h>
 #include "main.h"
 
@@ -82,16 +89,171 @@ static auto BorrowByml(Callable&& callable) {
   };
 }
 
+/// Casts a node to a Python object that keeps `parent` alive.
+/// This is needed for nodes that are returned inside of lists or tuples, because
+/// py::keep_alive does not work with objects that do not support weak references.
+template <typename Node>
+static py::object CastNode(Node&& node, py::handle parent) {
+  py::object obj = py::cast(std::forward<Node>(node));
+  py::detail::keep_alive_impl(obj, parent);
+  return obj;
+}
+
+/// Forwards visitor events to methods of a Python subclass (begin_array, begin_hash, scalar, end).
+/// Methods that are not defined or that return None are treated as returning Continue.
+class PyBymlVisitor : public BymlVisitor {
+public:
+  Action BeginArray(std::string_view key, size_t size) override {
+    return Call("begin_array", key, size);
+  }
+  Action BeginHash(std::string_view key, size_t size) override {
+    return Call("begin_hash", key, size);
+  }
+  Action Scalar(std::string_view key, const BymlView::Node& node) override {
+    return Call("scalar", key, CastNode(BymlView::Node(node), m_view));
+  }
+  Action End() override { return Call("end"); }
+
+  /// The Python view that is being visited. Nodes that are passed to `scalar` keep it alive.
+  py::handle m_view;
+
+private:
+  template <typename... Args>
+  Action Call(const char* name, Args&&... args) {
+    const py::function fn = py::get_overload(static_cast<const BymlVisitor*>(this), name);
+    if (!fn)
+      return Action::Continue;
+    const py::object result = fn(std::forward<Args>(args)...);
+    return result.is_none() ? Action::Continue : result.cast<Action>();
+  }
+};
+
+/// Binds the read-only node API that is shared by BymlView and BymlDocument.
+/// Child nodes keep their parent (and thus the document) alive.
+template <typename Node>
+static void BindNode(py::class_<Node>& cl) {
+  constexpr bool is_view = std::is_same_v<Node, BymlView::Node>;
+  const auto get_hash_item = [](const Node& node, size_t i) -> std::pair<std::string_view, Node> {
+    if constexpr (is_view)
+      return node.GetHashItem(i);
+    else
+      return {node.GetHash()[i].GetKey(), node.GetHash()[i].value};
+  };
+
+  cl.def("get_type", &Node::GetType)
+      .def("is_null", &Node::IsNull)
+      .def("__len__", &Node::Size)
+      .def(
+          "__getitem__", [](const Node& node, size_t index) { return Node(node[index]); },
+          "index"_a, py::keep_alive<0, 1>())
+      .def(
+          "__getitem__", [](const Node& node, std::string_view key) { return Node(node[key]); },
+          "key"_a, py::keep_alive<0, 1>())
+      .def("__contains__", &Node::Contains, "key"_a)
+      .def(
+          "find",
+          [](const Node& node, std::string_view key) -> std::optional<Node> {
+            if constexpr (is_view) {
+              return node.Find(key);
+            } else {
+              if (const Node* child = node.Find(key))
+                return *child;
+              return std::nullopt;
+            }
+          },
+          "key"_a, py::keep_alive<0, 1>())
+      .def("keys",
+           [get_hash_item](const Node& node) {
+             std::vector<std::string_view> keys;
+             for (size_t i = 0, n = node.Size(); i < n; ++i)
+               keys.emplace_back(get_hash_item(node, i).first);
+             return keys;
+           })
+      .def("items",
+           [get_hash_item](py::handle self) {
+             const Node& node = self.cast<const Node&>();
+             py::list items;
+             for (size_t i = 0, n = node.Size(); i < n; ++i) {
+               auto [key, value] = get_hash_item(node, i);
+               items.append(py::make_tuple(key, CastNode(std::move(value), self)));
+             }
+             return items;
+           })
+      .def("get_string", &Node::GetString)
+      .def("get_binary",
+           [](const Node& node) {
+             const auto data = node.GetBinary();
+             return py::bytes(reinterpret_cast<const char*>(data.data()), data.size());
+           })
+      .def("get_bool", &Node::GetBool)
+      .def("get_int", &Node::GetInt)
+      .def("get_uint", &Node::GetUInt)
+      .def("get_float", &Node::GetFloat)
+      .def("get_int64", &Node::GetInt64)
+      .def("get_uint64", &Node::GetUInt64)
+      .def("get_double", &Node::GetDouble)
+      .def("to_byml", &Node::ToByml, py::return_value_policy::move,
+           ":return: The decoded node (e.g. an Array, a Hash or a str).");
+}
+
 void BindByml(py::module& parent) {
   auto m = parent.def_submodule("byml");
-  m.def("from_binary", &Byml::FromBinary, "buffer"_a, py::return_value_policy::move,
+  m.def("from_binary", &Byml::FromBinary, "buffer"_a, "num_threads"_a = 1,
+        py::return_value_policy::move,
+        ":param num_threads: Number of threads to use for large containers (0: one per core).\n"
         ":return: An Array or a Hash.");
   m.def("from_text", &Byml::FromText, "yml_text"_a, py::return_value_policy::move,
         ":return: An Array or a Hash.");
-  m.def("to_binary", BorrowByml<bool, int>(&Byml::ToBinary), "data"_a, "big_endian"_a,
-        "version"_a = 2);
+  m.def("to_binary",
+        BorrowByml<bool, int, size_t>(
+            py::overload_cast<bool, int, size_t>(&Byml::ToBinary, py::const_)),
+        "data"_a, "big_endian"_a, "version"_a = 2, "num_threads"_a = 1,
+        ":param num_threads: Number of threads to use for large containers (0: one per core).");
+  m.def("to_binary_into",
+        BorrowByml<tcb::span<u8>, bool, int, size_t>(
+            py::overload_cast<tcb::span<u8>, bool, int, size_t>(&Byml::ToBinary, py::const_)),
+        "data"_a, "buffer"_a, "big_endian"_a, "version"_a = 2, "num_threads"_a = 1,
+        ":return: The number of bytes that were written to the buffer.");
+  m.def("get_binary_size", BorrowByml(&Byml::GetBinarySize), "data"_a);
   m.def("to_text", BorrowByml(&Byml::ToText), "data"_a);
 
+  m.def("try_patch_in_place", &byml::TryPatchInPlace, "buffer"_a, "path"_a, "value"_a,
+        ":return: Whether the buffer was patched.");
+  py::class_<byml::InPlacePatcher>(m, "InPlacePatcher")
+      .def(py::init<tcb::span<u8>>(), "buffer"_a, py::keep_alive<1, 2>())
+      .def("try_patch", &byml::InPlacePatcher::TryPatch, "path"_a, "value"_a,
+           ":return: Whether the buffer was patched.");
+  m.def(
+      "patch",
+      [](tcb::span<const u8> buffer, std::string_view path, Byml value) {
+        std::vector<u8> data{buffer.begin(), buffer.end()};
+        byml::Patch(data, path, std::move(value));
+        return data;
+      },
+      "buffer"_a, "path"_a, "value"_a, ":return: The patched document.");
+
+  py::register_exception<byml::MergeConflictError>(m, "MergeConflictError");
+  py::enum_<byml::MergePolicy>(m, "MergePolicy")
+      .value("PreferOurs", byml::MergePolicy::PreferOurs)
+      .value("PreferTheirs", byml::MergePolicy::PreferTheirs)
+      .value("Fail", byml::MergePolicy::Fail);
+  m.def("merge", &byml::Merge, "base"_a, "ours"_a, "theirs"_a,
+        "policy"_a = byml::MergePolicy::PreferTheirs, py::return_value_policy::move);
+
+  py::class_<BymlDiff>(m, "Diff")
+      .def_static("make", &BymlDiff::Make, "base"_a, "modified"_a)
+      .def(
+          "apply",
+          [](const BymlDiff& diff, Byml document) {
+            diff.Apply(document);
+            return document;
+          },
+          "document"_a, ":return: The patched document.")
+      .def("to_byml", &BymlDiff::ToByml, py::return_value_policy::move)
+      .def_static("from_byml", &BymlDiff::FromByml, "data"_a)
+      .def("__len__", [](const BymlDiff& diff) { return diff.GetChanges().size(); })
+      .def(py::self == py::self);
+
   m.def("get_bool", BorrowByml(&Byml::GetBool), "data"_a);
   m.def("get_double", BorrowByml(&Byml::GetDouble), "data"_a);
   m.def("get_float", BorrowByml(&Byml::GetFloat), "data"_a);
@@ -103,5 +265,75 @@ void BindByml(py::module& parent) {
 
   BindVector<Byml::Array>(m, "Array");
   BindMap<Byml::Hash>(m, "Hash");
+
+  py::enum_<Byml::Type>(m, "Type")
+      .value("Null", Byml::Type::Null)
+      .value("String", Byml::Type::String)
+      .value("Binary", Byml::Type::Binary)
+      .value("Array", Byml::Type::Array)
+      .value("Hash", Byml::Type::Hash)
+      .value("Bool", Byml::Type::Bool)
+      .value("Int", Byml::Type::Int)
+      .value("Float", Byml::Type::Float)
+      .value("UInt", Byml::Type::UInt)
+      .value("Int64", Byml::Type::Int64)
+      .value("UInt64", Byml::Type::UInt64)
+      .value("Double", Byml::Type::Double);
+
+  py::class_<BymlView>(m, "View")
+      .def(py::init<tcb::span<const u8>>(), "data"_a, py::keep_alive<1, 2>())
+      .def("get_root", &BymlView::GetRoot, py::keep_alive<0, 1>())
+      .def("get_endianness", &BymlView::GetEndianness)
+      .def("get_version", &BymlView::GetVersion)
+      .def(
+          "visit",
+          [](py::handle self, BymlVisitor& visitor) {
+            auto* py_visitor = dynamic_cast<PyBymlVisitor*>(&visitor);
+            if (!py_visitor)
+              return self.cast<const BymlView&>().Visit(visitor);
+            const py::handle previous_view = std::exchange(py_visitor->m_view, self);
+            util::ScopeGuard guard{[&] { py_visitor->m_view = previous_view; }};
+            self.cast<const BymlView&>().Visit(visitor);
+          },
+          "visitor"_a);
+  py::class_<BymlView::Node> view_node_cl(m, "ViewNode");
+  BindNode(view_node_cl);
+
+  py::class_<BymlQuery>(m, "Query")
+      .def(py::init<std::string_view>(), "query"_a)
+      .def(
+          "execute",
+          [](const BymlQuery& query, py::handle data) {
+            const auto nodes = py::isinstance<BymlView>(data) ?
+                                   query.Execute(data.cast<const BymlView&>()) :
+                                   query.Execute(data.cast<const BymlView::Node&>());
+            py::list result;
+            for (const auto& node : nodes)
+              result.append(CastNode(node, data));
+            return result;
+          },
+          "data"_a, ":param data: A View or a ViewNode.\n:return: A list of ViewNodes.");
+
+  py::class_<BymlVisitor, PyBymlVisitor> visitor_cl(m, "Visitor");
+  visitor_cl.def(py::init<>());
+  py::enum_<BymlVisitor::Action>(visitor_cl, "Action")
+      .value("Continue", BymlVisitor::Action::Continue)
+      .value("Skip", BymlVisitor::Action::Skip)
+      .value("Stop", BymlVisitor::Action::Stop);
+
+  py::class_<BymlDocument>(m, "Document")
+      .def_static("from_binary", &BymlDocument::FromBinary, "data"_a)
+      .def_static("from_byml", BorrowByml(&BymlDocument::FromByml), "data"_a)
+      .def("to_byml", &BymlDocument::ToByml, py::return_value_policy::move)
+      .def("to_binary", &BymlDocument::ToBinary, "big_endian"_a, "version"_a = 2)
+      .def_static("from_snapshot", &BymlDocument::FromSnapshot, "data"_a,
+                  "verify_checksum"_a = true, py::keep_alive<0, 1>())
+      .def("to_snapshot", &BymlDocument::ToSnapshot)
+      .def(
+          "get_root", [](const BymlDocument& doc) { return doc.GetRoot(); },
+          py::keep_alive<0, 1>())
+      .def("get_arena_size", &BymlDocument::GetArenaSize);
+  py::class_<BymlDocument::Node> document_node_cl(m, "DocumentNode");
+  BindNode(document_node_cl);
 }
 }  // namespace oead::bind
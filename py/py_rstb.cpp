@@ -0,0 +1,81 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <nonstd/span.h>
+#include <string_view>
+
+#include <oead/rstb.h>
+#include <oead/sarc.h>
+#include "main.h"
+
+OEAD_MAKE_OPAQUE("CrcMap", decltype(oead::rstb::ResourceSizeTable::crc_map));
+OEAD_MAKE_OPAQUE("NameMap", decltype(oead::rstb::ResourceSizeTable::name_map));
+
+namespace oead::bind {
+
+void BindRstb(py::module& parent) {
+  auto m = parent.def_submodule("rstb");
+
+  py::class_<rstb::ResourceSizeTable> cl(m, "ResourceSizeTable");
+  BindMap<decltype(rstb::ResourceSizeTable::crc_map)>(cl, "CrcMap");
+  BindMap<decltype(rstb::ResourceSizeTable::name_map)>(cl, "NameMap");
+  cl.def(py::init<>())
+      .def(py::self == py::self)
+      .def_static("from_binary", &rstb::ResourceSizeTable::FromBinary, "data"_a, "endian"_a)
+      .def("to_binary", &rstb::ResourceSizeTable::ToBinary, "endian"_a)
+      .def("get_size", &rstb::ResourceSizeTable::GetSize, "name"_a)
+      .def("set_size", &rstb::ResourceSizeTable::SetSize, "name"_a, "size"_a)
+      .def("delete_entry", &rstb::ResourceSizeTable::DeleteEntry, "name"_a)
+      .def("__contains__", &rstb::ResourceSizeTable::Contains, "name"_a)
+      .def_readwrite("crc_map", &rstb::ResourceSizeTable::crc_map)
+      .def_readwrite("name_map", &rstb::ResourceSizeTable::name_map);
+
+  py::class_<rstb::FactoryInfo>(m, "FactoryInfo")
+      .def_readonly("name", &rstb::FactoryInfo::name)
+      .def_readonly("size_nx", &rstb::FactoryInfo::size_nx)
+      .def_readonly("size_wiiu", &rstb::FactoryInfo::size_wiiu)
+      .def_readonly("alignment", &rstb::FactoryInfo::alignment)
+      .def_readonly("parse_size_nx", &rstb::FactoryInfo::parse_size_nx)
+      .def_readonly("parse_size_wiiu", &rstb::FactoryInfo::parse_size_wiiu)
+      .def_readonly("multiplier", &rstb::FactoryInfo::multiplier)
+      .def_readonly("constant", &rstb::FactoryInfo::constant);
+
+  py::class_<rstb::ArchiveEntry>(m, "ArchiveEntry")
+      .def_readonly("name", &rstb::ArchiveEntry::name)
+      .def_readonly("size", &rstb::ArchiveEntry::size)
+      .def("__repr__", [](const rstb::ArchiveEntry& entry) {
+        return "rstb.ArchiveEntry({}, {})"_s.format(entry.name, entry.size);
+      });
+
+  m.def("get_factory_info", &rstb::GetFactoryInfo, "extension"_a,
+        py::return_value_policy::reference);
+  m.def("get_canonical_name", &rstb::GetCanonicalName, "name"_a);
+  m.def("estimate_size",
+        py::overload_cast<std::string_view, tcb::span<const u8>, util::Endianness, bool>(
+            &rstb::EstimateSize),
+        "name"_a, "data"_a, "endian"_a, "allow_heuristics"_a = false);
+  m.def("estimate_size",
+        py::overload_cast<std::string_view, size_t, util::Endianness, bool>(&rstb::EstimateSize),
+        "name"_a, "file_size"_a, "endian"_a, "allow_heuristics"_a = false);
+  m.def("estimate_archive_sizes", &rstb::EstimateArchiveSizes, "archive"_a, "endian"_a,
+        "allow_heuristics"_a = false, "num_threads"_a = 0,
+        py::call_guard<py::gil_scoped_release>());
+}
+
+}  // namespace oead::bind
@@ -62,9 +62,30 @@ constexpr auto OeadGetSpanCasterName() {
   return _("Span[") + detail::concat(make_caster<T>::name) + _("]");
 }
 
+template <size_t N>
+struct type_caster<oead::CompactString<N>> {
+  static handle cast(const oead::CompactString<N>& src, return_value_policy policy,
+                     handle parent) {
+    return make_caster<std::string_view>::cast(std::string_view(src), policy, parent);
+  }
+
+  bool load(handle src, bool convert) {
+    make_caster<std::string_view> caster;
+    if (!caster.load(src, convert))
+      return false;
+    value = cast_op<std::string_view>(caster);
+    return true;
+  }
+
+  PYBIND11_TYPE_CASTER(oead::CompactString<N>, _("str"));
+};
+
 template <typename T>
 struct type_caster<tcb::span<T>> {
   static handle cast(tcb::span<T> span, return_value_policy, handle) {
+    // Python requires a non-null pointer, even for empty memoryviews.
+    if (span.data() == nullptr)
+      return py::memoryview::from_memory(static_cast<const void*>(""), 0).release();
     return py::memoryview::from_memory(span.data(), ssize_t(span.size_bytes())).release();
   }
 
@@ -34,6 +34,8 @@ class CMakeBuild(build_ext):
         extdir = os.path.abspath(os.path.dirname(self.get_ext_fullpath(ext.name)))
         cmake_args = ['-DCMAKE_LIBRARY_OUTPUT_DIRECTORY=' + extdir,
                       '-DPYTHON_EXECUTABLE=' + sys.executable]
+        # Extra CMake options, e.g. OEAD_CMAKE_ARGS="-DOEAD_BYML_FLAT_HASH=ON".
+        cmake_args += os.getenv('OEAD_CMAKE_ARGS', '').split()
 
         cfg = 'Debug' if debug else 'Release'
         build_args = [f'-j{os.cpu_count()}', '--config', cfg]
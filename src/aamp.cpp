@@ -19,11 +19,14 @@
 
 #include <oead/aamp.h>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/container/inlined_vector.h>
 #include <absl/strings/str_format.h>
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <limits>
+#include <optional>
 #include <queue>
 #include "absl/container/flat_hash_set.h"
 
@@ -32,219 +35,95 @@
 #include <oead/util/bit_utils.h>
 #include <oead/util/iterator_utils.h>
 #include <oead/util/type_utils.h>
+#include "aamp_res.h"
 
 namespace oead::aamp {
 
-constexpr std::array<char, 4> HeaderMagic = {'A', 'A', 'M', 'P'};
-
-enum class HeaderFlag : u32 {
-  LittleEndian = 1 << 0,
-  Utf8 = 1 << 1,
-};
-
-struct ResHeader {
-  std::array<char, 4> magic;
-  util::LeInt<u32> version;
-  util::Flags<HeaderFlag> flags;
-  util::LeInt<u32> file_size;
-  util::LeInt<u32> pio_version;
-  /// Offset to parameter IO (relative to 0x30)
-  util::LeInt<u32> offset_to_pio;
-  /// Number of lists (including parameter IO)
-  util::LeInt<u32> num_lists;
-  util::LeInt<u32> num_objects;
-  util::LeInt<u32> num_parameters;
-  util::LeInt<u32> data_section_size;
-  util::LeInt<u32> string_section_size;
-  util::LeInt<u32> unk_section_size;
-};
-static_assert(sizeof(ResHeader) == 0x30);
-
-template <typename T, size_t Factor = 4>
-struct CompactOffset {
-  static constexpr size_t MaxDistance = [] {
-    if constexpr (util::IsAnyOfType<T, U24<false>, U24<true>>())
-      return Factor * (1 << 24);
-    else
-      return Factor * std::numeric_limits<typename NumberType<T>::type>::max();
-  }();
-
-  constexpr CompactOffset() = default;
-  constexpr CompactOffset(size_t value) { Set(value); }
-  constexpr size_t Get() const { return size_t(raw_value) * Factor; }
-  constexpr void Set(size_t x) {
-    if (x % Factor != 0 || x > MaxDistance)
-      throw std::invalid_argument("Offset is not representable");
-    raw_value = x / Factor;
-  }
-
-private:
-  T raw_value;
-};
-
-struct ResParameter {
-  util::LeInt<u32> name_crc32;
-  CompactOffset<U24<false>> data_rel_offset;
-  Parameter::Type type;
-};
-static_assert(sizeof(ResParameter) == 8);
-
-struct ResParameterObj {
-  util::LeInt<u32> name_crc32;
-  CompactOffset<util::LeInt<u16>> parameters_rel_offset;
-  util::LeInt<u16> num_parameters;
-};
-static_assert(sizeof(ResParameterObj) == 8);
-
-struct ResParameterList {
-  util::LeInt<u32> name_crc32;
-  CompactOffset<util::LeInt<u16>> lists_rel_offset;
-  util::LeInt<u16> num_lists;
-  CompactOffset<util::LeInt<u16>> objects_rel_offset;
-  util::LeInt<u16> num_objects;
-};
-static_assert(sizeof(ResParameterList) == 0xc);
+template <typename T, typename T2>
+static void WriteBuffer(util::BinaryWriterBase<T2>& writer, const std::vector<T>& v) {
+  writer.Write(u32(v.size()));
+  writer.template WriteArray<T>(v);
+}
 
-class Parser {
+/// Index of the parameter data that has already been written, which is used to deduplicate
+/// data without scanning the whole data section for every parameter.
+///
+/// Every 4-byte aligned position is indexed by the 4 and the 8 bytes that start there.
+/// Positions that have the same key are chained in ascending order, so the first match is
+/// always the same as the one a linear scan would find.
+class DataIndex {
 public:
-  Parser(tcb::span<const u8> data) : m_reader{data, util::Endianness::Little} {
-    if (data.size() < sizeof(ResHeader))
-      throw InvalidDataError("Invalid header");
-
-    if (m_reader.Read<decltype(ResHeader::magic)>() != HeaderMagic)
-      throw InvalidDataError("Invalid magic");
-
-    const auto version = *m_reader.Read<u32>(offsetof(ResHeader, version));
-    if (version != 2)
-      throw InvalidDataError("Only version 2 parameter archives are supported");
-
-    auto flags = *m_reader.Read<util::Flags<HeaderFlag>>(offsetof(ResHeader, flags));
-    if (!flags[HeaderFlag::LittleEndian])
-      throw InvalidDataError("Only little endian parameter archives are supported");
-    if (!flags[HeaderFlag::Utf8])
-      throw InvalidDataError("Only UTF-8 parameter archives are supported");
+  explicit DataIndex(size_t start) : m_start{start}, m_end4{start}, m_end8{start} {}
+
+  /// Index the positions that are now fully covered by the buffer.
+  void Update(tcb::span<const u8> buffer) {
+    for (; m_end4 + 4 <= buffer.size(); m_end4 += 4)
+      Add(m_chains4, m_next4, Load<u32>(buffer.data() + m_end4));
+    for (; m_end8 + 8 <= buffer.size(); m_end8 += 4)
+      Add(m_chains8, m_next8, Load<u64>(buffer.data() + m_end8));
   }
 
-  ParameterIO Parse() {
-    const auto offset_to_pio = *m_reader.Read<u32>(offsetof(ResHeader, offset_to_pio));
-    auto&& [root_name, root] = ParseList(sizeof(ResHeader) + offset_to_pio);
-    if (root_name != ParameterIO::ParamRootKey.hash)
-      throw InvalidDataError("No param_root");
-    ParameterIO pio;
-    pio.version = *m_reader.Read<u32>(offsetof(ResHeader, pio_version));
-    pio.type = m_reader.ReadString(sizeof(ResHeader));
-    pio.objects = std::move(root.objects);
-    pio.lists = std::move(root.lists);
-    return pio;
+  /// Returns the lowest indexed position before `limit` at which the buffer contains `data`.
+  /// `data` must be at least 4 bytes long.
+  std::optional<size_t> Find(tcb::span<const u8> buffer, tcb::span<const u8> data,
+                             size_t limit) const {
+    if (data.size() >= 8)
+      return Find(m_chains8, m_next8, Load<u64>(data.data()), buffer, data, limit);
+    return Find(m_chains4, m_next4, Load<u32>(data.data()), buffer, data, limit);
   }
 
 private:
-  std::pair<u32, Parameter> ParseParameter(u32 offset) {
-    const auto info = m_reader.Read<ResParameter>(offset).value();
-    const auto crc32 = info.name_crc32;
-    const auto data_offset = offset + info.data_rel_offset.Get();
-
-    switch (info.type) {
-    case Parameter::Type::Bool:
-      return {crc32, m_reader.Read<u32>(data_offset).value() != 0};
-    case Parameter::Type::F32:
-      // There's some trickery going on in the parse function -- floats can
-      // in some cases get multiplied by some factor.
-      // That is currently ignored and the data is loaded as is.
-      return {crc32, m_reader.Read<f32>(data_offset).value()};
-    case Parameter::Type::Int:
-      return {crc32, m_reader.Read<int>(data_offset).value()};
-    case Parameter::Type::Vec2:
-      return {crc32, m_reader.Read<Vector2f>(data_offset).value()};
-    case Parameter::Type::Vec3:
-      return {crc32, m_reader.Read<Vector3f>(data_offset).value()};
-    case Parameter::Type::Vec4:
-      return {crc32, m_reader.Read<Vector4f>(data_offset).value()};
-    case Parameter::Type::Color:
-      return {crc32, m_reader.Read<Color4f>(data_offset).value()};
-    case Parameter::Type::String32:
-      return {crc32, FixedSafeString<32>(m_reader.ReadString(data_offset, 32))};
-    case Parameter::Type::String64:
-      return {crc32, FixedSafeString<64>(m_reader.ReadString(data_offset, 64))};
-    case Parameter::Type::Curve1:
-      return {crc32, m_reader.Read<std::array<Curve, 1>>(data_offset).value()};
-    case Parameter::Type::Curve2:
-      return {crc32, m_reader.Read<std::array<Curve, 2>>(data_offset).value()};
-    case Parameter::Type::Curve3:
-      return {crc32, m_reader.Read<std::array<Curve, 3>>(data_offset).value()};
-    case Parameter::Type::Curve4:
-      return {crc32, m_reader.Read<std::array<Curve, 4>>(data_offset).value()};
-    case Parameter::Type::BufferInt:
-      return {crc32, ParseBuffer<int>(data_offset)};
-    case Parameter::Type::BufferF32:
-      return {crc32, ParseBuffer<f32>(data_offset)};
-    case Parameter::Type::String256:
-      return {crc32, FixedSafeString<256>(m_reader.ReadString(data_offset, 256))};
-    case Parameter::Type::Quat:
-      // Quat parameters receive additional processing after being loaded:
-      // depending on what parameters are passed to the apply function,
-      // there may be linear interpolation going on.
-      // That is also being ignored by this implementation.
-      return {crc32, m_reader.Read<Quatf>(data_offset).value()};
-    case Parameter::Type::U32:
-      return {crc32, m_reader.Read<U32>(data_offset).value()};
-    case Parameter::Type::BufferU32:
-      return {crc32, ParseBuffer<u32>(data_offset)};
-    case Parameter::Type::BufferBinary:
-      return {crc32, ParseBuffer<u8>(data_offset)};
-    case Parameter::Type::StringRef:
-      return {crc32, m_reader.ReadString(data_offset)};
-    default:
-      throw InvalidDataError("Unexpected parameter type");
-    }
-  }
-
-  template <typename T>
-  std::vector<T> ParseBuffer(u32 data_offset) {
-    const size_t size = m_reader.Read<u32>(data_offset - 4).value();
-    std::vector<T> buffer;
-    buffer.reserve(size);
-    for (size_t i = 0; i < size; ++i)
-      buffer.emplace_back(m_reader.Read<T>().value());
-    return buffer;
+  static constexpr u32 None = 0xffffffff;
+
+  struct Chain {
+    u32 first;
+    u32 last;
+  };
+
+  template <typename Key>
+  static Key Load(const u8* data) {
+    Key key;
+    std::memcpy(&key, data, sizeof(key));
+    return key;
   }
 
-  std::pair<u32, ParameterObject> ParseObject(u32 offset) {
-    const auto info = m_reader.Read<ResParameterObj>(offset).value();
-    const auto offset_to_params = offset + info.parameters_rel_offset.Get();
-
-    ParameterObject object;
-    object.params.reserve(info.num_parameters);
-    for (size_t i = 0; i < info.num_parameters; ++i)
-      object.params.emplace(ParseParameter(offset_to_params + sizeof(ResParameter) * i));
-    return {info.name_crc32, std::move(object)};
+  template <typename Key>
+  static void Add(absl::flat_hash_map<Key, Chain>& chains, std::vector<u32>& next, Key key) {
+    const u32 index = u32(next.size());
+    next.push_back(None);
+    const auto [it, inserted] = chains.try_emplace(key, Chain{index, index});
+    if (!inserted) {
+      next[it->second.last] = index;
+      it->second.last = index;
+    }
   }
 
-  std::pair<u32, ParameterList> ParseList(u32 offset) {
-    const auto info = m_reader.Read<ResParameterList>(offset).value();
-    const auto offset_to_lists = offset + info.lists_rel_offset.Get();
-    const auto offset_to_objects = offset + info.objects_rel_offset.Get();
-
-    ParameterList list;
-    list.lists.reserve(info.num_lists);
-    list.objects.reserve(info.num_objects);
-    for (size_t i = 0; i < info.num_lists; ++i)
-      list.lists.emplace(ParseList(offset_to_lists + sizeof(ResParameterList) * i));
-    for (size_t i = 0; i < info.num_objects; ++i)
-      list.objects.emplace(ParseObject(offset_to_objects + sizeof(ResParameterObj) * i));
-    return {info.name_crc32, std::move(list)};
+  template <typename Key>
+  std::optional<size_t> Find(const absl::flat_hash_map<Key, Chain>& chains,
+                             const std::vector<u32>& next, Key key, tcb::span<const u8> buffer,
+                             tcb::span<const u8> data, size_t limit) const {
+    const auto it = chains.find(key);
+    if (it == chains.end())
+      return std::nullopt;
+    for (u32 i = it->second.first; i != None; i = next[i]) {
+      const size_t offset = m_start + 4 * size_t(i);
+      if (offset >= limit || offset + data.size() > buffer.size())
+        break;
+      if (std::equal(data.begin(), data.end(), buffer.begin() + offset))
+        return offset;
+    }
+    return std::nullopt;
   }
 
-  util::BinaryReader m_reader;
+  size_t m_start;
+  size_t m_end4;
+  size_t m_end8;
+  absl::flat_hash_map<u32, Chain> m_chains4;
+  absl::flat_hash_map<u64, Chain> m_chains8;
+  std::vector<u32> m_next4;
+  std::vector<u32> m_next8;
 };
 
-template <typename T, typename T2>
-static void WriteBuffer(util::BinaryWriterBase<T2>& writer, const std::vector<T>& v) {
-  writer.Write(u32(v.size()));
-  for (const auto& x : v)
-    writer.Write(x);
-}
-
 struct WriteContext {
 public:
   void WriteLists(const ParameterIO& pio) {
@@ -334,9 +213,9 @@ public:
   }
 
   void WriteDataSection() {
-    const size_t lookup_start_offset = writer.Tell();
+    DataIndex index{writer.Tell()};
     for (const Parameter& param : parameters_to_write)
-      WriteParameterData(param, lookup_start_offset);
+      WriteParameterData(param, index);
     writer.AlignUp(4);
   }
 
@@ -346,7 +225,7 @@ public:
     writer.AlignUp(4);
   }
 
-  void WriteParameterData(const Parameter& param, size_t lookup_start_offset) {
+  void WriteParameterData(const Parameter& param, DataIndex& index) {
     if (IsStringType(param.GetType()))
       throw std::logic_error("WriteParameterData called with string parameter");
 
@@ -362,20 +241,17 @@ public:
         [&](const auto& v) { temp_writer.Write(v); });
 
     const size_t parent_offset = offsets.at(&param);
-    size_t data_offset = writer.Tell() + (IsBufferType(param.GetType()) ? 4 : 0);
-    bool found = false;
-
-    for (size_t offset = lookup_start_offset;
-         offset + temp_writer.Buffer().size() <= writer.Buffer().size() &&
-         offset - parent_offset < (1 << 24) * 4;
-         offset += 4) {
-      if (std::equal(temp_writer.Buffer().begin(), temp_writer.Buffer().end(),
-                     writer.Buffer().begin() + offset)) {
-        data_offset = offset;
-        found = true;
-        break;
-      }
-    }
+    // Buffer parameters point to the data that follows the buffer size.
+    const size_t data_start = IsBufferType(param.GetType()) ? 4 : 0;
+    size_t data_offset = writer.Tell() + data_start;
+
+    // Relative offsets are stored as 24-bit word counts.
+    index.Update(writer.Buffer());
+    const tcb::span<const u8> data{temp_writer.Buffer().data(), temp_writer.Buffer().size()};
+    const auto existing_offset = index.Find(writer.Buffer(), data, parent_offset + (1 << 24) * 4);
+    const bool found = existing_offset.has_value();
+    if (found)
+      data_offset = *existing_offset + data_start;
 
     // Write the data offset in the parent parameter structure.
     writer.RunAt(parent_offset + offsetof(ResParameter, data_rel_offset), [&](size_t) {
@@ -0,0 +1,581 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <absl/strings/str_split.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+
+#include <oead/aamp_flat.h>
+#include <oead/errors.h>
+#include <oead/util/binary_reader.h>
+#include "aamp_res.h"
+
+namespace oead::aamp {
+
+struct FlatParameterIOBuilder {
+  using Id = FlatParameterIO::Id;
+  using ParameterEntry = FlatParameterIO::ParameterEntry;
+
+  explicit FlatParameterIOBuilder(FlatParameterIO& pio) : pio{pio}, arena{pio.m_arena} {}
+
+  /// Append count default-constructed entries to a table (and its lookup table)
+  /// and return the ID of the first one.
+  template <typename T>
+  static Id Append(std::vector<T>& table, FlatParameterIO::Index& index, size_t count) {
+    const size_t begin = table.size();
+    table.resize(begin + count);
+    index.resize(begin + count);
+    return Id(begin);
+  }
+
+  static Name NameOf(const FlatParameterIO::ListEntry& entry) { return entry.name; }
+  static Name NameOf(const FlatParameterIO::ObjectEntry& entry) { return entry.name; }
+  static Name NameOf(const ParameterEntry& entry) { return entry.GetName(); }
+
+  /// Fill in and sort the lookup table entries for the children of a parent.
+  template <typename T>
+  static void BuildIndex(const std::vector<T>& table, FlatParameterIO::Index& index, Id begin,
+                         u32 count) {
+    for (Id id = begin; id < begin + count; ++id)
+      index[id] = {NameOf(table[id]).hash, id};
+    // Sorting by ID as well means that only the first child is found if several children have
+    // the same name, just like with a ParameterIO.
+    const auto compare = [](const auto& a, const auto& b) {
+      return std::tie(a.hash, a.id) < std::tie(b.hash, b.id);
+    };
+    std::sort(index.begin() + begin, index.begin() + begin + count, compare);
+  }
+
+  template <typename T>
+  static void SetValue(ParameterEntry& entry, Parameter::Type type, const T& value) {
+    static_assert(sizeof(T) <= sizeof(entry.m_value.value));
+    entry.m_type = type;
+    std::memcpy(entry.m_value.value.data(), &value, sizeof(T));
+  }
+
+  void SetString(ParameterEntry& entry, Parameter::Type type, std::string_view str) {
+    entry.m_type = type;
+    entry.m_size = u32(str.size());
+    entry.m_value.data = arena.CopyString(str).data();
+  }
+
+  template <typename T>
+  void SetData(ParameterEntry& entry, Parameter::Type type, const void* data, size_t count,
+               util::Endianness endian) {
+    entry.m_type = type;
+    entry.m_size = u32(count);
+    if (count == 0) {
+      entry.m_value.data = nullptr;
+      return;
+    }
+    void* copy = arena.Allocate(sizeof(T) * count, alignof(T));
+    util::detail::CopyArrayAndSwapIfNeeded<T>(copy, data, count, endian);
+    entry.m_value.data = copy;
+  }
+
+  // Building from binary data.
+
+  template <typename T>
+  T Read(size_t offset) {
+    const auto value = reader.Read<T>(offset);
+    if (!value)
+      throw InvalidDataError("Out of bounds read");
+    return *value;
+  }
+
+  std::string_view ReadString(size_t offset, std::optional<size_t> max_len = std::nullopt) {
+    // Even empty strings have a null terminator.
+    if (offset >= reader.span().size())
+      throw InvalidDataError("Out of bounds read");
+    return reader.ReadString<std::string_view>(offset, max_len);
+  }
+
+  template <typename T>
+  void ReadData(ParameterEntry& entry, Parameter::Type type, size_t offset, size_t count) {
+    const auto data = reader.span();
+    if (offset > data.size() || count > (data.size() - offset) / sizeof(T))
+      throw InvalidDataError("Out of bounds read");
+    SetData<T>(entry, type, data.data() + offset, count, reader.Endian());
+  }
+
+  template <typename T>
+  void ReadBuffer(ParameterEntry& entry, Parameter::Type type, u32 data_offset) {
+    // The buffer size is stored just before the data.
+    ReadData<T>(entry, type, data_offset, Read<u32>(data_offset - 4));
+  }
+
+  void ParseParameter(Id id, u32 offset) {
+    const auto info = Read<ResParameter>(offset);
+    const u32 data_offset = offset + info.data_rel_offset.Get();
+    ParameterEntry& entry = pio.m_parameters[id];
+    entry.m_name = u32(info.name_crc32);
+
+    switch (info.type) {
+    case Parameter::Type::Bool:
+      return SetValue(entry, info.type, Read<u32>(data_offset) != 0);
+    case Parameter::Type::F32:
+      return SetValue(entry, info.type, Read<f32>(data_offset));
+    case Parameter::Type::Int:
+      return SetValue(entry, info.type, Read<int>(data_offset));
+    case Parameter::Type::Vec2:
+      return SetValue(entry, info.type, Read<Vector2f>(data_offset));
+    case Parameter::Type::Vec3:
+      return SetValue(entry, info.type, Read<Vector3f>(data_offset));
+    case Parameter::Type::Vec4:
+      return SetValue(entry, info.type, Read<Vector4f>(data_offset));
+    case Parameter::Type::Color:
+      return SetValue(entry, info.type, Read<Color4f>(data_offset));
+    case Parameter::Type::Quat:
+      return SetValue(entry, info.type, Read<Quatf>(data_offset));
+    case Parameter::Type::U32:
+      return SetValue(entry, info.type, Read<u32>(data_offset));
+    case Parameter::Type::String32:
+      return SetString(entry, info.type, ReadString(data_offset, 32));
+    case Parameter::Type::String64:
+      return SetString(entry, info.type, ReadString(data_offset, 64));
+    case Parameter::Type::String256:
+      return SetString(entry, info.type, ReadString(data_offset, 256));
+    case Parameter::Type::StringRef:
+      return SetString(entry, info.type, ReadString(data_offset));
+    case Parameter::Type::Curve1:
+      return ReadData<Curve>(entry, info.type, data_offset, 1);
+    case Parameter::Type::Curve2:
+      return ReadData<Curve>(entry, info.type, data_offset, 2);
+    case Parameter::Type::Curve3:
+      return ReadData<Curve>(entry, info.type, data_offset, 3);
+    case Parameter::Type::Curve4:
+      return ReadData<Curve>(entry, info.type, data_offset, 4);
+    case Parameter::Type::BufferInt:
+      return ReadBuffer<int>(entry, info.type, data_offset);
+    case Parameter::Type::BufferF32:
+      return ReadBuffer<f32>(entry, info.type, data_offset);
+    case Parameter::Type::BufferU32:
+      return ReadBuffer<u32>(entry, info.type, data_offset);
+    case Parameter::Type::BufferBinary:
+      return ReadBuffer<u8>(entry, info.type, data_offset);
+    default:
+      throw InvalidDataError("Unexpected parameter type");
+    }
+  }
+
+  void ParseObject(Id id, u32 offset) {
+    const auto info = Read<ResParameterObj>(offset);
+    const u32 parameters_offset = offset + info.parameters_rel_offset.Get();
+    const Id parameters_begin =
+        Append(pio.m_parameters, pio.m_parameter_index, info.num_parameters);
+    pio.m_objects[id] = {u32(info.name_crc32), parameters_begin, info.num_parameters};
+
+    for (u32 i = 0; i < info.num_parameters; ++i)
+      ParseParameter(parameters_begin + i, parameters_offset + sizeof(ResParameter) * i);
+    BuildIndex(pio.m_parameters, pio.m_parameter_index, parameters_begin, info.num_parameters);
+  }
+
+  void ParseList(Id id, u32 offset) {
+    const auto info = Read<ResParameterList>(offset);
+    const u32 lists_offset = offset + info.lists_rel_offset.Get();
+    const u32 objects_offset = offset + info.objects_rel_offset.Get();
+    const Id lists_begin = Append(pio.m_lists, pio.m_list_index, info.num_lists);
+    const Id objects_begin = Append(pio.m_objects, pio.m_object_index, info.num_objects);
+    pio.m_lists[id] = {u32(info.name_crc32), lists_begin, info.num_lists, objects_begin,
+                       info.num_objects};
+
+    for (u32 i = 0; i < info.num_objects; ++i)
+      ParseObject(objects_begin + i, objects_offset + sizeof(ResParameterObj) * i);
+    BuildIndex(pio.m_objects, pio.m_object_index, objects_begin, info.num_objects);
+    for (u32 i = 0; i < info.num_lists; ++i)
+      ParseList(lists_begin + i, lists_offset + sizeof(ResParameterList) * i);
+    BuildIndex(pio.m_lists, pio.m_list_index, lists_begin, info.num_lists);
+  }
+
+  // Building from a ParameterIO.
+
+  template <typename T>
+  void CopyData(ParameterEntry& entry, Parameter::Type type, const T& container) {
+    SetData<typename T::value_type>(entry, type, container.data(), container.size(),
+                                    util::detail::GetPlatformEndianness());
+  }
+
+  void BuildParameter(Id id, Name name, const Parameter& param) {
+    ParameterEntry& entry = pio.m_parameters[id];
+    entry.m_name = name;
+
+    const auto type = param.GetType();
+    switch (type) {
+    case Parameter::Type::Bool:
+      return SetValue(entry, type, param.Get<Parameter::Type::Bool>());
+    case Parameter::Type::F32:
+      return SetValue(entry, type, param.Get<Parameter::Type::F32>());
+    case Parameter::Type::Int:
+      return SetValue(entry, type, param.Get<Parameter::Type::Int>());
+    case Parameter::Type::Vec2:
+      return SetValue(entry, type, param.Get<Parameter::Type::Vec2>());
+    case Parameter::Type::Vec3:
+      return SetValue(entry, type, param.Get<Parameter::Type::Vec3>());
+    case Parameter::Type::Vec4:
+      return SetValue(entry, type, param.Get<Parameter::Type::Vec4>());
+    case Parameter::Type::Color:
+      return SetValue(entry, type, param.Get<Parameter::Type::Color>());
+    case Parameter::Type::Quat:
+      return SetValue(entry, type, param.Get<Parameter::Type::Quat>());
+    case Parameter::Type::U32:
+      return SetValue(entry, type, u32(param.Get<Parameter::Type::U32>()));
+    case Parameter::Type::String32:
+    case Parameter::Type::String64:
+    case Parameter::Type::String256:
+    case Parameter::Type::StringRef:
+      return SetString(entry, type, param.GetStringView());
+    case Parameter::Type::Curve1:
+      return CopyData(entry, type, param.Get<Parameter::Type::Curve1>());
+    case Parameter::Type::Curve2:
+      return CopyData(entry, type, param.Get<Parameter::Type::Curve2>());
+    case Parameter::Type::Curve3:
+      return CopyData(entry, type, param.Get<Parameter::Type::Curve3>());
+    case Parameter::Type::Curve4:
+      return CopyData(entry, type, param.Get<Parameter::Type::Curve4>());
+    case Parameter::Type::BufferInt:
+      return CopyData(entry, type, param.Get<Parameter::Type::BufferInt>());
+    case Parameter::Type::BufferF32:
+      return CopyData(entry, type, param.Get<Parameter::Type::BufferF32>());
+    case Parameter::Type::BufferU32:
+      return CopyData(entry, type, param.Get<Parameter::Type::BufferU32>());
+    case Parameter::Type::BufferBinary:
+      return CopyData(entry, type, param.Get<Parameter::Type::BufferBinary>());
+    }
+  }
+
+  void BuildObject(Id id, Name name, const ParameterObject& object) {
+    const u32 num_parameters = u32(object.params.size());
+    const Id parameters_begin = Append(pio.m_parameters, pio.m_parameter_index, num_parameters);
+    pio.m_objects[id] = {name, parameters_begin, num_parameters};
+
+    Id child = parameters_begin;
+    for (const auto& [param_name, param] : object.params)
+      BuildParameter(child++, param_name, param);
+    BuildIndex(pio.m_parameters, pio.m_parameter_index, parameters_begin, num_parameters);
+  }
+
+  void BuildList(Id id, Name name, const ParameterList& list) {
+    const u32 num_lists = u32(list.lists.size());
+    const u32 num_objects = u32(list.objects.size());
+    const Id lists_begin = Append(pio.m_lists, pio.m_list_index, num_lists);
+    const Id objects_begin = Append(pio.m_objects, pio.m_object_index, num_objects);
+    pio.m_lists[id] = {name, lists_begin, num_lists, objects_begin, num_objects};
+
+    Id child = objects_begin;
+    for (const auto& [object_name, object] : list.objects)
+      BuildObject(child++, object_name, object);
+    BuildIndex(pio.m_objects, pio.m_object_index, objects_begin, num_objects);
+    child = lists_begin;
+    for (const auto& [list_name, child_list] : list.lists)
+      BuildList(child++, list_name, child_list);
+    BuildIndex(pio.m_lists, pio.m_list_index, lists_begin, num_lists);
+  }
+
+  FlatParameterIO& pio;
+  util::MonotonicArena& arena;
+  util::BinaryReader reader;
+};
+
+FlatParameterIO FlatParameterIO::FromBinary(tcb::span<const u8> data) {
+  // Validates the header.
+  Parser{data};
+
+  FlatParameterIO pio;
+  FlatParameterIOBuilder builder{pio};
+  auto& reader = builder.reader;
+  reader = {data, util::Endianness::Little};
+
+  // The header has the total number of structures, so every table is only allocated once.
+  // The counts are capped so that invalid headers cannot cause huge allocations.
+  const auto reserve = [&](auto& table, Index& index, size_t count_offset, size_t entry_size) {
+    const size_t count =
+        std::min<size_t>(builder.Read<u32>(count_offset), data.size() / entry_size);
+    table.reserve(count);
+    index.reserve(count);
+  };
+  reserve(pio.m_lists, pio.m_list_index, offsetof(ResHeader, num_lists),
+          sizeof(ResParameterList));
+  reserve(pio.m_objects, pio.m_object_index, offsetof(ResHeader, num_objects),
+          sizeof(ResParameterObj));
+  reserve(pio.m_parameters, pio.m_parameter_index, offsetof(ResHeader, num_parameters),
+          sizeof(ResParameter));
+
+  pio.m_version = builder.Read<u32>(offsetof(ResHeader, pio_version));
+  pio.m_type = pio.m_arena.CopyString(builder.ReadString(sizeof(ResHeader)));
+
+  const u32 root_offset = sizeof(ResHeader) + builder.Read<u32>(offsetof(ResHeader, offset_to_pio));
+  builder.Append(pio.m_lists, pio.m_list_index, 1);
+  builder.ParseList(RootListId, root_offset);
+  if (pio.m_lists[RootListId].name != ParameterIO::ParamRootKey)
+    throw InvalidDataError("No param_root");
+  return pio;
+}
+
+FlatParameterIO FlatParameterIO::FromParameterIO(const ParameterIO& pio) {
+  FlatParameterIO flat;
+  FlatParameterIOBuilder builder{flat};
+  flat.m_version = pio.version;
+  flat.m_type = flat.m_arena.CopyString(pio.type);
+  builder.Append(flat.m_lists, flat.m_list_index, 1);
+  builder.BuildList(RootListId, ParameterIO::ParamRootKey, pio);
+  return flat;
+}
+
+ParameterIO FlatParameterIO::ToParameterIO() const {
+  ParameterIO pio;
+  pio.version = m_version;
+  pio.type = m_type;
+  static_cast<ParameterList&>(pio) = ToList(RootListId);
+  return pio;
+}
+
+const FlatParameterIO::ListEntry& FlatParameterIO::ListAt(Id id) const {
+  if (id >= m_lists.size())
+    throw std::out_of_range("Invalid list ID");
+  return m_lists[id];
+}
+
+const FlatParameterIO::ObjectEntry& FlatParameterIO::ObjectAt(Id id) const {
+  if (id >= m_objects.size())
+    throw std::out_of_range("Invalid object ID");
+  return m_objects[id];
+}
+
+const FlatParameterIO::ParameterEntry& FlatParameterIO::ParameterAt(Id id) const {
+  if (id >= m_parameters.size())
+    throw std::out_of_range("Invalid parameter ID");
+  return m_parameters[id];
+}
+
+std::optional<FlatParameterIO::Id> FlatParameterIO::Find(const Index& index, Id begin, u32 count,
+                                                         Name name) {
+  const auto end = index.begin() + begin + count;
+  const auto it = std::lower_bound(
+      index.begin() + begin, end, name.hash,
+      [](const IndexEntry& entry, u32 hash) { return entry.hash < hash; });
+  if (it == end || it->hash != name.hash)
+    return std::nullopt;
+  return it->id;
+}
+
+std::optional<FlatParameterIO::Id> FlatParameterIO::FindList(Id list, Name name) const {
+  const ListEntry& entry = ListAt(list);
+  return Find(m_list_index, entry.lists_begin, entry.num_lists, name);
+}
+
+std::optional<FlatParameterIO::Id> FlatParameterIO::FindObject(Id list, Name name) const {
+  const ListEntry& entry = ListAt(list);
+  return Find(m_object_index, entry.objects_begin, entry.num_objects, name);
+}
+
+std::optional<FlatParameterIO::Id> FlatParameterIO::FindParameter(Id object, Name name) const {
+  const ObjectEntry& entry = ObjectAt(object);
+  return Find(m_parameter_index, entry.parameters_begin, entry.num_parameters, name);
+}
+
+std::optional<FlatParameterIO::Id> FlatParameterIO::FindParameter(std::string_view path) const {
+  const std::vector<std::string_view> components = absl::StrSplit(path, '/');
+  if (components.size() < 2)
+    return std::nullopt;
+
+  Id list = RootListId;
+  for (size_t i = 0; i < components.size() - 2; ++i) {
+    const auto child = FindList(list, components[i]);
+    if (!child)
+      return std::nullopt;
+    list = *child;
+  }
+  const auto object = FindObject(list, components[components.size() - 2]);
+  if (!object)
+    return std::nullopt;
+  return FindParameter(*object, components.back());
+}
+
+ParameterList FlatParameterIO::ToList(Id id) const {
+  const ListEntry& entry = ListAt(id);
+  ParameterList list;
+  list.objects.reserve(entry.num_objects);
+  list.lists.reserve(entry.num_lists);
+  for (Id i = entry.objects_begin; i < entry.objects_begin + entry.num_objects; ++i)
+    list.objects.emplace(m_objects[i].name, ToObject(i));
+  for (Id i = entry.lists_begin; i < entry.lists_begin + entry.num_lists; ++i)
+    list.lists.emplace(m_lists[i].name, ToList(i));
+  return list;
+}
+
+ParameterObject FlatParameterIO::ToObject(Id id) const {
+  const ObjectEntry& entry = ObjectAt(id);
+  ParameterObject object;
+  object.params.reserve(entry.num_parameters);
+  for (Id i = entry.parameters_begin; i < entry.parameters_begin + entry.num_parameters; ++i)
+    object.params.emplace(m_parameters[i].GetName(), m_parameters[i].ToParameter());
+  return object;
+}
+
+template <typename T>
+T FlatParameterIO::ParameterEntry::GetValue(Parameter::Type type) const {
+  if (m_type != type)
+    throw TypeError("Unexpected parameter type");
+  T value;
+  std::memcpy(&value, m_value.value.data(), sizeof(T));
+  return value;
+}
+
+template <typename T>
+tcb::span<const T> FlatParameterIO::ParameterEntry::GetData(Parameter::Type type) const {
+  if (m_type != type)
+    throw TypeError("Unexpected parameter type");
+  return {static_cast<const T*>(m_value.data), m_size};
+}
+
+bool FlatParameterIO::ParameterEntry::GetBool() const {
+  return GetValue<bool>(Parameter::Type::Bool);
+}
+
+f32 FlatParameterIO::ParameterEntry::GetF32() const {
+  return GetValue<f32>(Parameter::Type::F32);
+}
+
+int FlatParameterIO::ParameterEntry::GetInt() const {
+  return GetValue<int>(Parameter::Type::Int);
+}
+
+u32 FlatParameterIO::ParameterEntry::GetU32() const {
+  return GetValue<u32>(Parameter::Type::U32);
+}
+
+Vector2f FlatParameterIO::ParameterEntry::GetVec2() const {
+  return GetValue<Vector2f>(Parameter::Type::Vec2);
+}
+
+Vector3f FlatParameterIO::ParameterEntry::GetVec3() const {
+  return GetValue<Vector3f>(Parameter::Type::Vec3);
+}
+
+Vector4f FlatParameterIO::ParameterEntry::GetVec4() const {
+  return GetValue<Vector4f>(Parameter::Type::Vec4);
+}
+
+Color4f FlatParameterIO::ParameterEntry::GetColor() const {
+  return GetValue<Color4f>(Parameter::Type::Color);
+}
+
+Quatf FlatParameterIO::ParameterEntry::GetQuat() const {
+  return GetValue<Quatf>(Parameter::Type::Quat);
+}
+
+std::string_view FlatParameterIO::ParameterEntry::GetString() const {
+  if (!IsStringType(m_type))
+    throw TypeError("Unexpected parameter type");
+  return {static_cast<const char*>(m_value.data), m_size};
+}
+
+tcb::span<const Curve> FlatParameterIO::ParameterEntry::GetCurves() const {
+  switch (m_type) {
+  case Parameter::Type::Curve1:
+  case Parameter::Type::Curve2:
+  case Parameter::Type::Curve3:
+  case Parameter::Type::Curve4:
+    return {static_cast<const Curve*>(m_value.data), m_size};
+  default:
+    throw TypeError("Unexpected parameter type");
+  }
+}
+
+tcb::span<const int> FlatParameterIO::ParameterEntry::GetBufferInt() const {
+  return GetData<int>(Parameter::Type::BufferInt);
+}
+
+tcb::span<const f32> FlatParameterIO::ParameterEntry::GetBufferF32() const {
+  return GetData<f32>(Parameter::Type::BufferF32);
+}
+
+tcb::span<const u32> FlatParameterIO::ParameterEntry::GetBufferU32() const {
+  return GetData<u32>(Parameter::Type::BufferU32);
+}
+
+tcb::span<const u8> FlatParameterIO::ParameterEntry::GetBufferBinary() const {
+  return GetData<u8>(Parameter::Type::BufferBinary);
+}
+
+template <size_t N>
+static Parameter MakeCurves(tcb::span<const Curve> curves) {
+  auto array = std::make_unique<std::array<Curve, N>>();
+  std::copy(curves.begin(), curves.end(), array->begin());
+  return Parameter{std::move(array)};
+}
+
+template <typename T>
+static Parameter MakeBuffer(tcb::span<const T> buffer) {
+  return std::make_unique<std::vector<T>>(buffer.begin(), buffer.end());
+}
+
+Parameter FlatParameterIO::ParameterEntry::ToParameter() const {
+  switch (m_type) {
+  case Parameter::Type::Bool:
+    return GetBool();
+  case Parameter::Type::F32:
+    return GetF32();
+  case Parameter::Type::Int:
+    return GetInt();
+  case Parameter::Type::Vec2:
+    return GetVec2();
+  case Parameter::Type::Vec3:
+    return GetVec3();
+  case Parameter::Type::Vec4:
+    return GetVec4();
+  case Parameter::Type::Color:
+    return GetColor();
+  case Parameter::Type::Quat:
+    return GetQuat();
+  case Parameter::Type::U32:
+    return U32(GetU32());
+  case Parameter::Type::String32:
+    return FixedSafeString<32>(GetString());
+  case Parameter::Type::String64:
+    return FixedSafeString<64>(GetString());
+  case Parameter::Type::String256:
+    return FixedSafeString<256>(GetString());
+  case Parameter::Type::StringRef:
+    return GetString();
+  case Parameter::Type::Curve1:
+    return MakeCurves<1>(GetCurves());
+  case Parameter::Type::Curve2:
+    return MakeCurves<2>(GetCurves());
+  case Parameter::Type::Curve3:
+    return MakeCurves<3>(GetCurves());
+  case Parameter::Type::Curve4:
+    return MakeCurves<4>(GetCurves());
+  case Parameter::Type::BufferInt:
+    return MakeBuffer(GetBufferInt());
+  case Parameter::Type::BufferF32:
+    return MakeBuffer(GetBufferF32());
+  case Parameter::Type::BufferU32:
+    return MakeBuffer(GetBufferU32());
+  case Parameter::Type::BufferBinary:
+    return MakeBuffer(GetBufferBinary());
+  }
+  throw TypeError("Unexpected parameter type");
+}
+
+}  // namespace oead::aamp
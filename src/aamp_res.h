@@ -0,0 +1,239 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <oead/aamp.h>
+#include <oead/errors.h>
+#include <oead/types.h>
+#include <oead/util/binary_reader.h>
+#include <oead/util/bit_utils.h>
+#include <oead/util/type_utils.h>
+
+/// Binary format structures and helpers that are shared by the AAMP parser, writer and view.
+namespace oead::aamp {
+
+constexpr std::array<char, 4> HeaderMagic = {'A', 'A', 'M', 'P'};
+
+enum class HeaderFlag : u32 {
+  LittleEndian = 1 << 0,
+  Utf8 = 1 << 1,
+};
+
+struct ResHeader {
+  std::array<char, 4> magic;
+  util::LeInt<u32> version;
+  util::Flags<HeaderFlag> flags;
+  util::LeInt<u32> file_size;
+  util::LeInt<u32> pio_version;
+  /// Offset to parameter IO (relative to 0x30)
+  util::LeInt<u32> offset_to_pio;
+  /// Number of lists (including parameter IO)
+  util::LeInt<u32> num_lists;
+  util::LeInt<u32> num_objects;
+  util::LeInt<u32> num_parameters;
+  util::LeInt<u32> data_section_size;
+  util::LeInt<u32> string_section_size;
+  util::LeInt<u32> unk_section_size;
+};
+static_assert(sizeof(ResHeader) == 0x30);
+
+template <typename T, size_t Factor = 4>
+struct CompactOffset {
+  static constexpr size_t MaxDistance = [] {
+    if constexpr (util::IsAnyOfType<T, U24<false>, U24<true>>())
+      return Factor * (1 << 24);
+    else
+      return Factor * std::numeric_limits<typename NumberType<T>::type>::max();
+  }();
+
+  constexpr CompactOffset() = default;
+  constexpr CompactOffset(size_t value) { Set(value); }
+  constexpr size_t Get() const { return size_t(raw_value) * Factor; }
+  constexpr void Set(size_t x) {
+    if (x % Factor != 0 || x > MaxDistance)
+      throw std::invalid_argument("Offset is not representable");
+    raw_value = x / Factor;
+  }
+
+private:
+  T raw_value;
+};
+
+struct ResParameter {
+  util::LeInt<u32> name_crc32;
+  CompactOffset<U24<false>> data_rel_offset;
+  Parameter::Type type;
+};
+static_assert(sizeof(ResParameter) == 8);
+
+struct ResParameterObj {
+  util::LeInt<u32> name_crc32;
+  CompactOffset<util::LeInt<u16>> parameters_rel_offset;
+  util::LeInt<u16> num_parameters;
+};
+static_assert(sizeof(ResParameterObj) == 8);
+
+struct ResParameterList {
+  util::LeInt<u32> name_crc32;
+  CompactOffset<util::LeInt<u16>> lists_rel_offset;
+  util::LeInt<u16> num_lists;
+  CompactOffset<util::LeInt<u16>> objects_rel_offset;
+  util::LeInt<u16> num_objects;
+};
+static_assert(sizeof(ResParameterList) == 0xc);
+
+class Parser {
+public:
+  Parser(tcb::span<const u8> data) : m_reader{data, util::Endianness::Little} {
+    if (data.size() < sizeof(ResHeader))
+      throw InvalidDataError("Invalid header");
+
+    if (m_reader.Read<decltype(ResHeader::magic)>() != HeaderMagic)
+      throw InvalidDataError("Invalid magic");
+
+    const auto version = *m_reader.Read<u32>(offsetof(ResHeader, version));
+    if (version != 2)
+      throw InvalidDataError("Only version 2 parameter archives are supported");
+
+    auto flags = *m_reader.Read<util::Flags<HeaderFlag>>(offsetof(ResHeader, flags));
+    if (!flags[HeaderFlag::LittleEndian])
+      throw InvalidDataError("Only little endian parameter archives are supported");
+    if (!flags[HeaderFlag::Utf8])
+      throw InvalidDataError("Only UTF-8 parameter archives are supported");
+  }
+
+  ParameterIO Parse() {
+    const auto offset_to_pio = *m_reader.Read<u32>(offsetof(ResHeader, offset_to_pio));
+    auto&& [root_name, root] = ParseList(sizeof(ResHeader) + offset_to_pio);
+    if (root_name != ParameterIO::ParamRootKey.hash)
+      throw InvalidDataError("No param_root");
+    ParameterIO pio;
+    pio.version = *m_reader.Read<u32>(offsetof(ResHeader, pio_version));
+    pio.type = m_reader.ReadString(sizeof(ResHeader));
+    pio.objects = std::move(root.objects);
+    pio.lists = std::move(root.lists);
+    return pio;
+  }
+
+  std::pair<u32, Parameter> ParseParameter(u32 offset) {
+    const auto info = m_reader.Read<ResParameter>(offset).value();
+    const auto crc32 = info.name_crc32;
+    const auto data_offset = offset + info.data_rel_offset.Get();
+
+    switch (info.type) {
+    case Parameter::Type::Bool:
+      return {crc32, m_reader.Read<u32>(data_offset).value() != 0};
+    case Parameter::Type::F32:
+      // There's some trickery going on in the parse function -- floats can
+      // in some cases get multiplied by some factor.
+      // That is currently ignored and the data is loaded as is.
+      return {crc32, m_reader.Read<f32>(data_offset).value()};
+    case Parameter::Type::Int:
+      return {crc32, m_reader.Read<int>(data_offset).value()};
+    case Parameter::Type::Vec2:
+      return {crc32, m_reader.Read<Vector2f>(data_offset).value()};
+    case Parameter::Type::Vec3:
+      return {crc32, m_reader.Read<Vector3f>(data_offset).value()};
+    case Parameter::Type::Vec4:
+      return {crc32, m_reader.Read<Vector4f>(data_offset).value()};
+    case Parameter::Type::Color:
+      return {crc32, m_reader.Read<Color4f>(data_offset).value()};
+    case Parameter::Type::String32:
+      return {crc32,
+              FixedSafeString<32>(m_reader.ReadString<std::string_view>(data_offset, 32))};
+    case Parameter::Type::String64:
+      return {crc32,
+              FixedSafeString<64>(m_reader.ReadString<std::string_view>(data_offset, 64))};
+    case Parameter::Type::Curve1:
+      return {crc32, m_reader.Read<std::array<Curve, 1>>(data_offset).value()};
+    case Parameter::Type::Curve2:
+      return {crc32, m_reader.Read<std::array<Curve, 2>>(data_offset).value()};
+    case Parameter::Type::Curve3:
+      return {crc32, m_reader.Read<std::array<Curve, 3>>(data_offset).value()};
+    case Parameter::Type::Curve4:
+      return {crc32, m_reader.Read<std::array<Curve, 4>>(data_offset).value()};
+    case Parameter::Type::BufferInt:
+      return {crc32, ParseBuffer<int>(data_offset)};
+    case Parameter::Type::BufferF32:
+      return {crc32, ParseBuffer<f32>(data_offset)};
+    case Parameter::Type::String256:
+      return {crc32,
+              FixedSafeString<256>(m_reader.ReadString<std::string_view>(data_offset, 256))};
+    case Parameter::Type::Quat:
+      // Quat parameters receive additional processing after being loaded:
+      // depending on what parameters are passed to the apply function,
+      // there may be linear interpolation going on.
+      // That is also being ignored by this implementation.
+      return {crc32, m_reader.Read<Quatf>(data_offset).value()};
+    case Parameter::Type::U32:
+      return {crc32, m_reader.Read<U32>(data_offset).value()};
+    case Parameter::Type::BufferU32:
+      return {crc32, ParseBuffer<u32>(data_offset)};
+    case Parameter::Type::BufferBinary:
+      return {crc32, ParseBuffer<u8>(data_offset)};
+    case Parameter::Type::StringRef:
+      return {crc32, m_reader.ReadString<std::string_view>(data_offset)};
+    default:
+      throw InvalidDataError("Unexpected parameter type");
+    }
+  }
+
+  std::pair<u32, ParameterObject> ParseObject(u32 offset) {
+    const auto info = m_reader.Read<ResParameterObj>(offset).value();
+    const auto offset_to_params = offset + info.parameters_rel_offset.Get();
+
+    ParameterObject object;
+    object.params.reserve(info.num_parameters);
+    for (size_t i = 0; i < info.num_parameters; ++i)
+      object.params.emplace(ParseParameter(offset_to_params + sizeof(ResParameter) * i));
+    return {info.name_crc32, std::move(object)};
+  }
+
+  std::pair<u32, ParameterList> ParseList(u32 offset) {
+    const auto info = m_reader.Read<ResParameterList>(offset).value();
+    const auto offset_to_lists = offset + info.lists_rel_offset.Get();
+    const auto offset_to_objects = offset + info.objects_rel_offset.Get();
+
+    ParameterList list;
+    list.lists.reserve(info.num_lists);
+    list.objects.reserve(info.num_objects);
+    for (size_t i = 0; i < info.num_lists; ++i)
+      list.lists.emplace(ParseList(offset_to_lists + sizeof(ResParameterList) * i));
+    for (size_t i = 0; i < info.num_objects; ++i)
+      list.objects.emplace(ParseObject(offset_to_objects + sizeof(ResParameterObj) * i));
+    return {info.name_crc32, std::move(list)};
+  }
+
+private:
+  template <typename T>
+  std::vector<T> ParseBuffer(u32 data_offset) {
+    const size_t size = m_reader.Read<u32>(data_offset - 4).value();
+    return m_reader.ReadArray<T>(size).value();
+  }
+
+  util::BinaryReader m_reader;
+};
+
+}  // namespace oead::aamp
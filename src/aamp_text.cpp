@@ -18,20 +18,26 @@
  */
 
 #include <absl/algorithm/container.h>
+#include <absl/container/node_hash_map.h>
 #include <absl/strings/match.h>
 #include <absl/strings/str_format.h>
+#include <algorithm>
 #include <array>
+#include <mutex>
+#include <shared_mutex>
 #include <tuple>
 
 #include <c4/std/string.hpp>
 #include <ryml.hpp>
-#include "../lib/libyaml/include/yaml.h"
 
 #include <cmrc/cmrc.hpp>
 
 #include <oead/aamp.h>
 #include <oead/errors.h>
+#include <oead/util/binary_reader.h>
 #include <oead/util/iterator_utils.h>
+#include <oead/util/magic_utils.h>
+#include <oead/util/parallel.h>
 #include <oead/util/string_utils.h>
 #include <oead/util/variant_utils.h>
 #include "yaml.h"
@@ -40,7 +46,127 @@ CMRC_DECLARE(oead::res);
 
 namespace oead::aamp {
 
-NameTable::NameTable(bool with_botw_strings) {
+/// Maps hashes of numbered names (formatted with every number below a limit) to the
+/// name and number that produced them.
+struct NameTable::NumberedNameIndex {
+  struct Entry {
+    u32 hash;
+    u32 name_index;
+    u32 number;
+
+    bool operator<(const Entry& other) const {
+      return std::tie(hash, name_index, number) <
+             std::tie(other.hash, other.name_index, other.number);
+    }
+  };
+
+  struct CacheHeader {
+    std::array<char, 8> magic;
+    u32 version;
+    /// Hash of the list of numbered names.
+    u32 names_hash;
+    u32 limit;
+    u32 num_entries;
+    /// CRC32 of the entries.
+    u32 checksum;
+    u32 reserved;
+    OEAD_DEFINE_FIELDS(CacheHeader, magic, version, names_hash, limit, num_entries, checksum,
+                       reserved);
+  };
+  static_assert(sizeof(CacheHeader) == 0x20);
+  static constexpr auto CacheMagic = util::MakeMagic("AAMPNIDX");
+  static constexpr u32 CacheVersion = 1;
+
+  /// Initialises the index unless that has already been done. If `cached_entries` is set,
+  /// those entries are used instead of formatting every name.
+  /// \return whether the index was initialised by this call.
+  bool Init(const NameTable& table, int limit_, std::vector<Entry>* cached_entries = nullptr) {
+    bool initialised = false;
+    std::call_once(init_flag, [&] {
+      initialised = true;
+      limit = std::max(limit_, 0);
+      names_hash = HashNames(table.numbered_names);
+      formats.reserve(table.numbered_names.size());
+      for (std::string_view name : table.numbered_names)
+        formats.emplace_back(absl::ParsedFormat<'d'>::New(name));
+
+      if (cached_entries) {
+        entries = std::move(*cached_entries);
+        return;
+      }
+
+      for (u32 name_index = 0; name_index < formats.size(); ++name_index) {
+        if (!formats[name_index])
+          continue;
+        for (int i = 0; i < limit; ++i) {
+          const u32 hash = util::crc32(absl::StrFormat(*formats[name_index], i));
+          entries.push_back({hash, name_index, u32(i)});
+        }
+      }
+      std::sort(entries.begin(), entries.end());
+    });
+    return initialised;
+  }
+
+  static u32 HashNames(const std::vector<std::string_view>& names) {
+    std::string data;
+    for (std::string_view name : names) {
+      data += name;
+      data += '\n';
+    }
+    return util::crc32(data);
+  }
+
+  std::once_flag init_flag;
+  int limit = 0;
+  u32 names_hash = 0;
+  /// Parsed numbered names (null for invalid format strings).
+  std::vector<std::unique_ptr<absl::ParsedFormat<'d'>>> formats;
+  /// Sorted by hash, then in the order in which candidates were tested before the index existed.
+  std::vector<Entry> entries;
+};
+
+/// Learned names are sharded by hash so that threads that look up or add different names
+/// rarely contend for the same lock. Node-based maps keep the strings at a stable address,
+/// so views that were handed out stay valid when other names are added.
+struct NameTable::LearnedNames {
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    absl::node_hash_map<u32, std::string> names;
+  };
+
+  LearnedNames() = default;
+  LearnedNames(const LearnedNames& other) {
+    for (size_t i = 0; i < shards.size(); ++i) {
+      std::shared_lock lock{other.shards[i].mutex};
+      shards[i].names = other.shards[i].names;
+    }
+  }
+
+  Shard& GetShard(u32 hash) { return shards[hash % shards.size()]; }
+
+  std::optional<std::string_view> Find(u32 hash) {
+    Shard& shard = GetShard(hash);
+    std::shared_lock lock{shard.mutex};
+    if (const auto it = shard.names.find(hash); it != shard.names.end())
+      return it->second;
+    return std::nullopt;
+  }
+
+  std::string_view Add(u32 hash, std::string name) {
+    Shard& shard = GetShard(hash);
+    std::unique_lock lock{shard.mutex};
+    // If another thread has added the name in the meantime, its string is kept.
+    const auto& [it, added] = shard.names.try_emplace(hash, std::move(name));
+    return it->second;
+  }
+
+  std::array<Shard, 16> shards;
+};
+
+NameTable::NameTable(bool with_botw_strings)
+    : m_learned_names{std::make_unique<LearnedNames>()},
+      m_numbered_name_index{std::make_shared<NumberedNameIndex>()} {
   if (!with_botw_strings)
     return;
 
@@ -59,14 +185,33 @@ NameTable::NameTable(bool with_botw_strings) {
                           [&](std::string_view name) { numbered_names.emplace_back(name); });
 }
 
+NameTable::NameTable(const NameTable& other)
+    : names{other.names}, numbered_names{other.numbered_names},
+      numbered_name_index_limit{other.numbered_name_index_limit},
+      m_learned_names{std::make_unique<LearnedNames>(*other.m_learned_names)},
+      m_numbered_name_index{other.m_numbered_name_index} {}
+
+NameTable& NameTable::operator=(const NameTable& other) {
+  if (this != &other) {
+    names = other.names;
+    numbered_names = other.numbered_names;
+    numbered_name_index_limit = other.numbered_name_index_limit;
+    m_learned_names = std::make_unique<LearnedNames>(*other.m_learned_names);
+    m_numbered_name_index = other.m_numbered_name_index;
+  }
+  return *this;
+}
+
+NameTable::~NameTable() = default;
+
 std::optional<std::string_view> NameTable::GetName(u32 hash, int index, u32 parent_name_hash) {
   using namespace std::string_view_literals;
 
   if (const auto it = names.find(hash); it != names.end())
     return it->second;
 
-  if (const auto it = owned_names.find(hash); it != owned_names.end())
-    return it->second;
+  if (const auto name = m_learned_names->Find(hash))
+    return name;
 
   // Try to guess the name from the parent structure if possible.
   if (const auto it = names.find(parent_name_hash); it != names.end()) {
@@ -103,11 +248,24 @@ std::optional<std::string_view> NameTable::GetName(u32 hash, int index, u32 pare
   }
 
   // Last resort: test all numbered names.
-  for (std::string_view name : numbered_names) {
-    for (int i = 0; i < index + 2; ++i) {
-      auto format = absl::ParsedFormat<'d'>::New(name);
-      if (!format)
-        break;
+  const auto& numbered = GetNumberedNameIndex();
+  const int max_number = index + 2;
+  if (max_number <= numbered.limit) {
+    auto entry = std::lower_bound(numbered.entries.begin(), numbered.entries.end(),
+                                  NumberedNameIndex::Entry{hash, 0, 0});
+    for (; entry != numbered.entries.end() && entry->hash == hash; ++entry) {
+      const int number = entry->number;
+      if (number < max_number)
+        return AddName(hash, absl::StrFormat(*numbered.formats[entry->name_index], number));
+    }
+    return std::nullopt;
+  }
+
+  // The index does not cover the requested range, so fall back to formatting every candidate.
+  for (const auto& format : numbered.formats) {
+    if (!format)
+      continue;
+    for (int i = 0; i < max_number; ++i) {
       auto candidate = absl::StrFormat(*format, i);
       if (util::crc32(candidate) == hash)
         return AddName(hash, std::move(candidate));
@@ -117,9 +275,77 @@ std::optional<std::string_view> NameTable::GetName(u32 hash, int index, u32 pare
   return std::nullopt;
 }
 
+const NameTable::NumberedNameIndex& NameTable::GetNumberedNameIndex() const {
+  m_numbered_name_index->Init(*this, numbered_name_index_limit);
+  return *m_numbered_name_index;
+}
+
+std::vector<u8> NameTable::SaveNumberedNameIndex() const {
+  const auto& numbered = GetNumberedNameIndex();
+
+  util::BinaryWriter writer{util::Endianness::Little};
+  NumberedNameIndex::CacheHeader header{};
+  writer.Seek(sizeof(header));
+  for (const auto& entry : numbered.entries) {
+    writer.Write(entry.hash);
+    writer.Write(entry.name_index);
+    writer.Write(entry.number);
+  }
+
+  header.magic = NumberedNameIndex::CacheMagic;
+  header.version = NumberedNameIndex::CacheVersion;
+  header.names_hash = numbered.names_hash;
+  header.limit = numbered.limit;
+  header.num_entries = numbered.entries.size();
+  header.checksum = util::crc32(writer.Buffer().data() + sizeof(header),
+                                writer.Buffer().size() - sizeof(header));
+  writer.Seek(0);
+  writer.Write(header);
+  return writer.Finalize();
+}
+
+bool NameTable::LoadNumberedNameIndex(tcb::span<const u8> data) {
+  util::BinaryReader reader{data, util::Endianness::Little};
+  const auto header = reader.Read<NumberedNameIndex::CacheHeader>();
+  if (!header || header->magic != NumberedNameIndex::CacheMagic)
+    throw InvalidDataError("Invalid numbered name index magic");
+
+  if (header->version != NumberedNameIndex::CacheVersion ||
+      header->names_hash != NumberedNameIndex::HashNames(numbered_names) ||
+      header->limit != u32(std::max(numbered_name_index_limit, 0))) {
+    return false;
+  }
+
+  const auto entries_data = data.subspan(sizeof(*header));
+  if (entries_data.size() != size_t(header->num_entries) * 3 * sizeof(u32))
+    throw InvalidDataError("Invalid numbered name index size");
+  if (util::crc32(entries_data.data(), entries_data.size()) != header->checksum)
+    throw InvalidDataError("Invalid numbered name index checksum");
+
+  // Names that are not valid format strings are never formatted, so entries must not refer
+  // to them.
+  std::vector<bool> is_valid_format(numbered_names.size());
+  for (size_t i = 0; i < numbered_names.size(); ++i)
+    is_valid_format[i] = absl::ParsedFormat<'d'>::New(numbered_names[i]) != nullptr;
+
+  std::vector<NumberedNameIndex::Entry> entries(header->num_entries);
+  for (auto& entry : entries) {
+    entry.hash = *reader.Read<u32>();
+    entry.name_index = *reader.Read<u32>();
+    entry.number = *reader.Read<u32>();
+    if (entry.name_index >= numbered_names.size() || !is_valid_format[entry.name_index] ||
+        entry.number >= header->limit) {
+      throw InvalidDataError("Invalid numbered name index entry");
+    }
+  }
+  if (!std::is_sorted(entries.begin(), entries.end()))
+    throw InvalidDataError("Numbered name index is not sorted");
+
+  return m_numbered_name_index->Init(*this, numbered_name_index_limit, &entries);
+}
+
 std::string_view NameTable::AddName(u32 hash, std::string name) {
-  const auto& [it, added] = owned_names.emplace(hash, std::move(name));
-  return it->second;
+  return m_learned_names->Add(hash, std::move(name));
 }
 
 void NameTable::AddNameReference(std::string_view name) {
@@ -301,49 +527,66 @@ ParameterIO ParameterIO::FromText(std::string_view yml_text) {
 
 class TextEmitter {
 public:
+  explicit TextEmitter(size_t num_threads = 1) : m_num_threads{num_threads} {}
+
   std::string Emit(const ParameterIO& pio) {
-    m_extra_name_table = {};
+    m_extra_name_table = std::make_shared<NameTable>(false);
     BuildExtraNameTable(pio);
-
-    yaml_event_t event;
-
-    yaml_stream_start_event_initialize(&event, YAML_UTF8_ENCODING);
-    emitter.Emit(event);
-
-    yaml_document_start_event_initialize(&event, nullptr, nullptr, nullptr, 1);
-    emitter.Emit(event);
-
     EmitParameterIO(pio);
-
-    yaml_document_end_event_initialize(&event, 1);
-    emitter.Emit(event);
-
-    yaml_stream_end_event_initialize(&event);
-    emitter.Emit(event);
-    return std::move(emitter.GetOutput());
+    return emitter.Finish();
   }
 
 private:
+  /// Creates an emitter for an item of a list that is emitted by a worker thread.
+  TextEmitter(std::shared_ptr<NameTable> extra_name_table,
+              std::vector<std::optional<std::string_view>>&& resolved_names,
+              yml::Emitter&& emitter_)
+      : m_extra_name_table{std::move(extra_name_table)},
+        m_resolved_names{std::move(resolved_names)}, emitter{std::move(emitter_)} {}
+
   /// Populates the extra name table with strings from the given parameter IO.
   void BuildExtraNameTable(const ParameterList& list) {
     for (const auto& [obj_name, obj] : list.objects) {
       for (const auto& [param_name, param] : obj.params) {
         if (IsStringType(param.GetType()))
-          m_extra_name_table.AddNameReference(param.GetStringView());
+          m_extra_name_table->AddNameReference(param.GetStringView());
       }
     }
     for (const auto& [sub_list_name, sub_list] : list.lists)
       BuildExtraNameTable(sub_list);
   }
 
+  std::optional<std::string_view> ResolveName(Name name, int index, Name parent_name) {
+    if (const auto name_str = m_extra_name_table->GetName(name, index, parent_name))
+      return name_str;
+    return GetDefaultNameTable().GetName(name, index, parent_name);
+  }
+
+  /// Resolves names in the same order as EmitParameterList.
+  void ResolveNames(const ParameterList& plist, Name parent_name,
+                    std::vector<std::optional<std::string_view>>& names) {
+    size_t i = 0;
+    for (const auto& [name, object] : plist.objects) {
+      names.emplace_back(ResolveName(name, i++, parent_name));
+      size_t j = 0;
+      for (const auto& [param_name, param] : object.params)
+        names.emplace_back(ResolveName(param_name, j++, name));
+    }
+    i = 0;
+    for (const auto& [name, list] : plist.lists) {
+      names.emplace_back(ResolveName(name, i++, parent_name));
+      ResolveNames(list, name, names);
+    }
+  }
+
   void EmitName(Name name, int index, Name parent_name) {
-    NameTable& table = GetDefaultNameTable();
-    if (const auto name_str = m_extra_name_table.GetName(name, index, parent_name))
-      emitter.EmitString(*name_str);
-    else if (const auto name_str = table.GetName(name, index, parent_name))
+    const auto name_str = m_resolved_names.empty() ?
+                              ResolveName(name, index, parent_name) :
+                              m_resolved_names[m_next_resolved_name++];
+    if (name_str)
       emitter.EmitString(*name_str);
     else
-      emitter.EmitInt(name);
+      emitter.EmitInt(name.hash);
   }
 
   void EmitParameter(const Parameter& param) {
@@ -369,11 +612,11 @@ private:
         [&](U32 v) { emitter.EmitInt(v, "!u"); },
         [&](const std::vector<u32>& v) { emitter.EmitSimpleSequence<u32>(v, "!buffer_u32"); },
         [&](const std::vector<u8>& v) { emitter.EmitSimpleSequence<u8>(v, "!buffer_binary"); },
-        [&](const std::string& v) { emitter.EmitString(v); });
+        [&](const Parameter::String& v) { emitter.EmitString(v); });
   }
 
   void EmitParameterObject(const ParameterObject& pobject, Name parent_name) {
-    yml::LibyamlEmitter::MappingScope scope{emitter, "!obj", YAML_BLOCK_MAPPING_STYLE};
+    yml::Emitter::MappingScope scope{emitter, "!obj", yml::Emitter::Style::Block};
     size_t i = 0;
     for (const auto& [name, param] : pobject.params) {
       EmitName(name, i++, parent_name);
@@ -381,12 +624,12 @@ private:
     }
   }
 
-  void EmitParameterList(const ParameterList& plist, Name parent_name) {
-    yml::LibyamlEmitter::MappingScope scope{emitter, "!list", YAML_BLOCK_MAPPING_STYLE};
+  void EmitParameterList(const ParameterList& plist, Name parent_name, bool parallel = false) {
+    yml::Emitter::MappingScope scope{emitter, "!list", yml::Emitter::Style::Block};
 
     emitter.EmitString("objects");
     {
-      yml::LibyamlEmitter::MappingScope subscope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+      yml::Emitter::MappingScope subscope{emitter, {}, yml::Emitter::Style::Block};
       size_t i = 0;
       for (const auto& [name, object] : plist.objects) {
         EmitName(name, i++, parent_name);
@@ -396,17 +639,51 @@ private:
 
     emitter.EmitString("lists");
     {
-      yml::LibyamlEmitter::MappingScope subscope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
-      size_t i = 0;
-      for (const auto& [name, list] : plist.lists) {
-        EmitName(name, i++, parent_name);
-        EmitParameterList(list, name);
+      yml::Emitter::MappingScope subscope{emitter, {}, yml::Emitter::Style::Block};
+      if (parallel && m_num_threads != 1 && plist.lists.size() >= 2) {
+        EmitListsInParallel(plist, parent_name);
+      } else {
+        size_t i = 0;
+        for (const auto& [name, list] : plist.lists) {
+          EmitName(name, i++, parent_name);
+          EmitParameterList(list, name);
+        }
       }
     }
   }
 
+  /// Emits every child list (and its name) with a separate emitter on a worker thread,
+  /// then concatenates the results. The output is identical to that of a serial emission.
+  void EmitListsInParallel(const ParameterList& plist, Name parent_name) {
+    // Guessed names are added to the name tables and can affect later guesses, so names are
+    // resolved in the serial order before anything is emitted.
+    std::vector<std::vector<std::optional<std::string_view>>> names(plist.lists.size());
+    std::vector<yml::Emitter> forks;
+    forks.reserve(plist.lists.size());
+    for (size_t i = 0; i < plist.lists.size(); ++i) {
+      const auto& [name, list] = *std::next(plist.lists.begin(), i);
+      names[i].emplace_back(ResolveName(name, i, parent_name));
+      ResolveNames(list, name, names[i]);
+      forks.emplace_back(emitter.Fork());
+    }
+
+    util::ParallelFor(
+        plist.lists.size(),
+        [&](size_t i) {
+          const auto& [name, list] = *std::next(plist.lists.begin(), i);
+          TextEmitter child{m_extra_name_table, std::move(names[i]), std::move(forks[i])};
+          child.EmitName(name, i, parent_name);
+          child.EmitParameterList(list, name);
+          forks[i] = std::move(child.emitter);
+        },
+        m_num_threads);
+
+    for (yml::Emitter& fork : forks)
+      emitter.Join(std::move(fork));
+  }
+
   void EmitParameterIO(const ParameterIO& pio) {
-    yml::LibyamlEmitter::MappingScope scope{emitter, "!io", YAML_BLOCK_MAPPING_STYLE};
+    yml::Emitter::MappingScope scope{emitter, "!io", yml::Emitter::Style::Block};
 
     emitter.EmitString("version");
     emitter.EmitInt(pio.version);
@@ -415,14 +692,11 @@ private:
     emitter.EmitString(pio.type);
 
     emitter.EmitString("param_root");
-    EmitParameterList(pio, ParameterIO::ParamRootKey);
+    EmitParameterList(pio, ParameterIO::ParamRootKey, true);
   }
 
   void EmitCurves(tcb::span<const Curve> curves) {
-    yaml_event_t event;
-    yaml_sequence_start_event_initialize(&event, nullptr, (const u8*)"!curve", 0,
-                                         YAML_FLOW_SEQUENCE_STYLE);
-    emitter.Emit(event);
+    emitter.BeginSequence("!curve", yml::Emitter::Style::Flow);
 
     for (const Curve& curve : curves) {
       emitter.EmitInt(curve.a);
@@ -431,16 +705,20 @@ private:
         emitter.EmitFloat(v);
     }
 
-    yaml_sequence_end_event_initialize(&event);
-    emitter.Emit(event);
+    emitter.EndSequence();
   }
 
-  NameTable m_extra_name_table{false};
-  yml::LibyamlEmitterWithStorage<std::string> emitter;
+  size_t m_num_threads = 1;
+  /// Strings from the parameter IO. Shared with the emitters of worker threads.
+  std::shared_ptr<NameTable> m_extra_name_table;
+  /// Names that were resolved ahead of time, in emission order (only for worker threads).
+  std::vector<std::optional<std::string_view>> m_resolved_names;
+  size_t m_next_resolved_name = 0;
+  yml::Emitter emitter;
 };
 
-std::string ParameterIO::ToText() const {
-  TextEmitter emitter;
+std::string ParameterIO::ToText(size_t num_threads) const {
+  TextEmitter emitter{num_threads};
   return emitter.Emit(*this);
 }
 
@@ -0,0 +1,299 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <absl/strings/str_split.h>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <oead/aamp_view.h>
+#include <oead/errors.h>
+#include <oead/util/swap.h>
+#include "aamp_res.h"
+
+namespace oead::aamp {
+
+ParameterIOView::ParameterIOView(tcb::span<const u8> data) {
+  // Validates the header.
+  Parser{data};
+  m_reader = {data, util::Endianness::Little};
+  m_root_offset = sizeof(ResHeader) + Read<u32>(offsetof(ResHeader, offset_to_pio));
+  m_version = Read<u32>(offsetof(ResHeader, pio_version));
+  m_type = m_reader.ReadString<std::string_view>(sizeof(ResHeader));
+}
+
+template <typename T>
+T ParameterIOView::Read(size_t offset) const {
+  auto reader = m_reader;
+  const auto value = reader.Read<T>(offset);
+  if (!value)
+    throw InvalidDataError("Out of bounds read");
+  return *value;
+}
+
+ParameterIOView::ListView ParameterIOView::GetRoot() const {
+  ListView root{this, m_root_offset};
+  if (root.GetName() != ParameterIO::ParamRootKey)
+    throw InvalidDataError("No param_root");
+  return root;
+}
+
+std::optional<ParameterIOView::ParameterView>
+ParameterIOView::FindParameter(std::string_view path) const {
+  const std::vector<std::string_view> components = absl::StrSplit(path, '/');
+  if (components.size() < 2)
+    return std::nullopt;
+
+  ListView list = GetRoot();
+  for (size_t i = 0; i < components.size() - 2; ++i) {
+    const auto child = list.FindList(components[i]);
+    if (!child)
+      return std::nullopt;
+    list = *child;
+  }
+  const auto object = list.FindObject(components[components.size() - 2]);
+  if (!object)
+    return std::nullopt;
+  return object->Find(components.back());
+}
+
+ParameterIOView::ListView::ListView(const ParameterIOView* view, u32 offset)
+    : m_view{view}, m_offset{offset}, m_name{u32(0)} {
+  const auto info = view->Read<ResParameterList>(offset);
+  m_name = u32(info.name_crc32);
+  m_lists_offset = offset + info.lists_rel_offset.Get();
+  m_objects_offset = offset + info.objects_rel_offset.Get();
+  m_num_lists = info.num_lists;
+  m_num_objects = info.num_objects;
+}
+
+ParameterIOView::ListView ParameterIOView::ListView::List(Name name) const {
+  const auto list = FindList(name);
+  if (!list)
+    throw std::out_of_range("No such list");
+  return *list;
+}
+
+ParameterIOView::ObjectView ParameterIOView::ListView::Object(Name name) const {
+  const auto object = FindObject(name);
+  if (!object)
+    throw std::out_of_range("No such object");
+  return *object;
+}
+
+std::optional<ParameterIOView::ListView> ParameterIOView::ListView::FindList(Name name) const {
+  for (u32 i = 0; i < m_num_lists; ++i) {
+    const u32 offset = m_lists_offset + sizeof(ResParameterList) * i;
+    if (m_view->Read<u32>(offset + offsetof(ResParameterList, name_crc32)) == name.hash)
+      return ListView{m_view, offset};
+  }
+  return std::nullopt;
+}
+
+std::optional<ParameterIOView::ObjectView>
+ParameterIOView::ListView::FindObject(Name name) const {
+  for (u32 i = 0; i < m_num_objects; ++i) {
+    const u32 offset = m_objects_offset + sizeof(ResParameterObj) * i;
+    if (m_view->Read<u32>(offset + offsetof(ResParameterObj, name_crc32)) == name.hash)
+      return ObjectView{m_view, offset};
+  }
+  return std::nullopt;
+}
+
+ParameterIOView::ListView ParameterIOView::ListView::ListAt(size_t index) const {
+  if (index >= m_num_lists)
+    throw std::out_of_range("Invalid list index");
+  return ListView{m_view, u32(m_lists_offset + sizeof(ResParameterList) * index)};
+}
+
+ParameterIOView::ObjectView ParameterIOView::ListView::ObjectAt(size_t index) const {
+  if (index >= m_num_objects)
+    throw std::out_of_range("Invalid object index");
+  return ObjectView{m_view, u32(m_objects_offset + sizeof(ResParameterObj) * index)};
+}
+
+ParameterList ParameterIOView::ListView::ToList() const {
+  return Parser{m_view->GetData()}.ParseList(m_offset).second;
+}
+
+ParameterIOView::ObjectView::ObjectView(const ParameterIOView* view, u32 offset)
+    : m_view{view}, m_offset{offset}, m_name{u32(0)} {
+  const auto info = view->Read<ResParameterObj>(offset);
+  m_name = u32(info.name_crc32);
+  m_parameters_offset = offset + info.parameters_rel_offset.Get();
+  m_num_parameters = info.num_parameters;
+}
+
+ParameterIOView::ParameterView ParameterIOView::ObjectView::operator[](Name name) const {
+  const auto param = Find(name);
+  if (!param)
+    throw std::out_of_range("No such parameter");
+  return *param;
+}
+
+std::optional<ParameterIOView::ParameterView>
+ParameterIOView::ObjectView::Find(Name name) const {
+  for (u32 i = 0; i < m_num_parameters; ++i) {
+    const u32 offset = m_parameters_offset + sizeof(ResParameter) * i;
+    if (m_view->Read<u32>(offset + offsetof(ResParameter, name_crc32)) == name.hash)
+      return ParameterView{m_view, offset};
+  }
+  return std::nullopt;
+}
+
+ParameterIOView::ParameterView ParameterIOView::ObjectView::ParameterAt(size_t index) const {
+  if (index >= m_num_parameters)
+    throw std::out_of_range("Invalid parameter index");
+  return ParameterView{m_view, u32(m_parameters_offset + sizeof(ResParameter) * index)};
+}
+
+ParameterObject ParameterIOView::ObjectView::ToObject() const {
+  return Parser{m_view->GetData()}.ParseObject(m_offset).second;
+}
+
+ParameterIOView::ParameterView::ParameterView(const ParameterIOView* view, u32 offset)
+    : m_view{view}, m_offset{offset}, m_name{u32(0)} {
+  const auto info = view->Read<ResParameter>(offset);
+  m_name = u32(info.name_crc32);
+  m_data_offset = offset + info.data_rel_offset.Get();
+  m_type = info.type;
+}
+
+void ParameterIOView::ParameterView::CheckType(Parameter::Type type) const {
+  if (m_type != type)
+    throw TypeError("Unexpected parameter type");
+}
+
+template <typename T>
+T ParameterIOView::ParameterView::Read(Parameter::Type type) const {
+  CheckType(type);
+  return m_view->Read<T>(m_data_offset);
+}
+
+bool ParameterIOView::ParameterView::GetBool() const {
+  return Read<u32>(Parameter::Type::Bool) != 0;
+}
+
+f32 ParameterIOView::ParameterView::GetF32() const {
+  return Read<f32>(Parameter::Type::F32);
+}
+
+int ParameterIOView::ParameterView::GetInt() const {
+  return Read<int>(Parameter::Type::Int);
+}
+
+u32 ParameterIOView::ParameterView::GetU32() const {
+  return Read<u32>(Parameter::Type::U32);
+}
+
+Vector2f ParameterIOView::ParameterView::GetVec2() const {
+  return Read<Vector2f>(Parameter::Type::Vec2);
+}
+
+Vector3f ParameterIOView::ParameterView::GetVec3() const {
+  return Read<Vector3f>(Parameter::Type::Vec3);
+}
+
+Vector4f ParameterIOView::ParameterView::GetVec4() const {
+  return Read<Vector4f>(Parameter::Type::Vec4);
+}
+
+Color4f ParameterIOView::ParameterView::GetColor() const {
+  return Read<Color4f>(Parameter::Type::Color);
+}
+
+Quatf ParameterIOView::ParameterView::GetQuat() const {
+  return Read<Quatf>(Parameter::Type::Quat);
+}
+
+std::string_view ParameterIOView::ParameterView::GetString() const {
+  const auto& reader = m_view->m_reader;
+  if (m_data_offset > reader.span().size())
+    throw InvalidDataError("Out of bounds read");
+  switch (m_type) {
+  case Parameter::Type::String32:
+    return reader.ReadString<std::string_view>(m_data_offset, 32);
+  case Parameter::Type::String64:
+    return reader.ReadString<std::string_view>(m_data_offset, 64);
+  case Parameter::Type::String256:
+    return reader.ReadString<std::string_view>(m_data_offset, 256);
+  case Parameter::Type::StringRef:
+    return reader.ReadString<std::string_view>(m_data_offset);
+  default:
+    throw TypeError("Unexpected parameter type");
+  }
+}
+
+template <typename T>
+tcb::span<const T> ParameterIOView::ParameterView::GetSpan(u32 offset, size_t size) const {
+  const auto data = m_view->GetData();
+  if (offset > data.size() || size > (data.size() - offset) / sizeof(T))
+    throw InvalidDataError("Out of bounds read");
+  const u8* ptr = data.data() + offset;
+  if (reinterpret_cast<uintptr_t>(ptr) % alignof(T) != 0)
+    throw std::invalid_argument("Parameter data is not suitably aligned");
+  if (util::detail::GetPlatformEndianness() != util::Endianness::Little)
+    throw std::runtime_error("Parameter data can only be viewed on little endian platforms");
+  return {reinterpret_cast<const T*>(ptr), size};
+}
+
+tcb::span<const Curve> ParameterIOView::ParameterView::GetCurves() const {
+  switch (m_type) {
+  case Parameter::Type::Curve1:
+    return GetSpan<Curve>(m_data_offset, 1);
+  case Parameter::Type::Curve2:
+    return GetSpan<Curve>(m_data_offset, 2);
+  case Parameter::Type::Curve3:
+    return GetSpan<Curve>(m_data_offset, 3);
+  case Parameter::Type::Curve4:
+    return GetSpan<Curve>(m_data_offset, 4);
+  default:
+    throw TypeError("Unexpected parameter type");
+  }
+}
+
+template <typename T>
+tcb::span<const T> ParameterIOView::ParameterView::GetBuffer(Parameter::Type type) const {
+  CheckType(type);
+  // The buffer size is stored just before the data.
+  return GetSpan<T>(m_data_offset, m_view->Read<u32>(m_data_offset - 4));
+}
+
+tcb::span<const int> ParameterIOView::ParameterView::GetBufferInt() const {
+  return GetBuffer<int>(Parameter::Type::BufferInt);
+}
+
+tcb::span<const f32> ParameterIOView::ParameterView::GetBufferF32() const {
+  return GetBuffer<f32>(Parameter::Type::BufferF32);
+}
+
+tcb::span<const u32> ParameterIOView::ParameterView::GetBufferU32() const {
+  return GetBuffer<u32>(Parameter::Type::BufferU32);
+}
+
+tcb::span<const u8> ParameterIOView::ParameterView::GetBufferBinary() const {
+  return GetBuffer<u8>(Parameter::Type::BufferBinary);
+}
+
+Parameter ParameterIOView::ParameterView::ToParameter() const {
+  return Parser{m_view->GetData()}.ParseParameter(m_offset).second;
+}
+
+}  // namespace oead::aamp
@@ -22,118 +22,32 @@
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <limits>
 #include <map>
+#include <memory>
 #include <string_view>
+#include <utility>
 
 #include <oead/byml.h>
 #include <oead/util/align.h>
 #include <oead/util/binary_reader.h>
 #include <oead/util/bit_utils.h>
 #include <oead/util/iterator_utils.h>
+#include <oead/util/parallel.h>
 #include <oead/util/variant_utils.h>
+#include "byml_res.h"
 
 namespace oead {
 
 namespace byml {
 
-struct ResHeader {
-  /// “BY” (big endian) or “YB” (little endian).
-  std::array<char, 2> magic;
-  /// Format version (2 or 3).
-  u16 version;
-  /// Offset to the hash key table, relative to start (usually 0x010)
-  /// May be 0 if no hash nodes are used. Must be a string table node (0xc2).
-  u32 hash_key_table_offset;
-  /// Offset to the string table, relative to start. May be 0 if no strings are used.
-  /// Must be a string table node (0xc2).
-  u32 string_table_offset;
-  /// Offset to the root node, relative to start. May be 0 if the document is totally empty.
-  /// Must be either an array node (0xc0) or a hash node (0xc1).
-  u32 root_node_offset;
-};
-static_assert(sizeof(ResHeader) == 0x10);
-
-enum class NodeType : u8 {
-  String = 0xa0,
-  Binary = 0xa1,
-  Array = 0xc0,
-  Hash = 0xc1,
-  StringTable = 0xc2,
-  Bool = 0xd0,
-  Int = 0xd1,
-  Float = 0xd2,
-  UInt = 0xd3,
-  Int64 = 0xd4,
-  UInt64 = 0xd5,
-  Double = 0xd6,
-  Null = 0xff,
-};
-
-constexpr NodeType GetNodeType(Byml::Type type) {
-  constexpr std::array map{
-      NodeType::Null, NodeType::String, NodeType::Binary, NodeType::Array,
-      NodeType::Hash, NodeType::Bool,   NodeType::Int,    NodeType::Float,
-      NodeType::UInt, NodeType::Int64,  NodeType::UInt64, NodeType::Double,
-  };
-  return map[u8(type)];
-}
-
-template <typename T = NodeType>
-constexpr bool IsContainerType(T type) {
-  return type == T::Array || type == T::Hash;
-}
-
-template <typename T = NodeType>
-constexpr bool IsLongType(T type) {
-  return type == T::Int64 || type == T::UInt64 || type == T::Double;
-}
-
-template <typename T = NodeType>
-constexpr bool IsNonInlineType(T type) {
-  return IsContainerType(type) || IsLongType(type) || type == T::Binary;
-}
-
-constexpr bool IsValidVersion(int version) {
-  return 2 <= version && version <= 4;
-}
-
-class StringTableParser {
-public:
-  StringTableParser() = default;
-  StringTableParser(util::BinaryReader& reader, u32 offset) : m_offset{offset} {
-    if (offset == 0)
-      return;
-    const auto type = reader.Read<NodeType>(offset);
-    const auto num_entries = reader.ReadU24();
-    if (!type || *type != NodeType::StringTable || !num_entries)
-      throw InvalidDataError("Invalid string table");
-    m_size = *num_entries;
-  }
-
-  std::string GetString(util::BinaryReader& reader, u32 idx) const {
-    if (idx >= m_size)
-      throw std::out_of_range("Invalid string table entry index");
-
-    const auto rel_offset = reader.Read<u32>(m_offset + 4 + 4 * idx);
-    // This is safe even for idx = N - 1 since the offset array has N+1 elements.
-    const auto next_rel_offset = reader.Read<u32>();
-    if (!rel_offset || !next_rel_offset)
-      throw InvalidDataError("Invalid string table: failed to read offsets");
-    if (*next_rel_offset < *rel_offset)
-      throw InvalidDataError("Invalid string table: inconsistent offsets");
-
-    const size_t max_len = *next_rel_offset - *rel_offset;
-    return reader.ReadString(m_offset + *rel_offset, max_len);
-  }
-
-private:
-  u32 m_offset = 0;
-  u32 m_size = 0;
-};
+/// Containers with at least this many children are parsed or serialized in parallel
+/// (if enabled).
+constexpr u32 ParallelThreshold = 256;
 
 class Parser {
 public:
-  Parser(tcb::span<const u8> data) {
+  Parser(tcb::span<const u8> data, size_t num_threads = 1) : m_num_threads{num_threads} {
     if (data.size() < sizeof(ResHeader))
       throw InvalidDataError("Invalid header");
 
@@ -149,10 +63,10 @@ public:
     if (!IsValidVersion(version))
       throw InvalidDataError("Unexpected version");
 
-    m_hash_key_table = StringTableParser(
+    m_hash_key_table = std::make_shared<StringTablePool>(
         m_reader, *m_reader.Read<u32>(offsetof(ResHeader, hash_key_table_offset)));
-    m_string_table =
-        StringTableParser(m_reader, *m_reader.Read<u32>(offsetof(ResHeader, string_table_offset)));
+    m_string_table = std::make_shared<StringTablePool>(
+        m_reader, *m_reader.Read<u32>(offsetof(ResHeader, string_table_offset)));
     m_root_node_offset = *m_reader.Read<u32>(offsetof(ResHeader, root_node_offset));
   }
 
@@ -163,6 +77,36 @@ public:
   }
 
 private:
+  bool ShouldParseInParallel(u32 size) const {
+    return m_num_threads != 1 && size >= ParallelThreshold;
+  }
+
+  /// Parses the children of a large container in parallel and returns them in order.
+  /// parse(parser, i) must parse child i.
+  ///
+  /// Children are split into chunks, each of which is parsed by a separate parser because
+  /// readers are not thread-safe. String tables are shared. Nested containers are always
+  /// parsed serially so that threads are only spawned once per large container.
+  template <typename Fn>
+  std::vector<Byml> ParseChildrenInParallel(u32 size, Fn parse) const {
+    std::vector<Byml> results(size);
+    const size_t num_threads = m_num_threads == 0 ? util::GetDefaultNumThreads() : m_num_threads;
+    // Use more chunks than threads to balance the load, as children may vary in size.
+    const size_t num_chunks = std::min<size_t>(size, num_threads * 4);
+    util::ParallelFor(
+        num_chunks,
+        [&](size_t chunk) {
+          Parser parser = *this;
+          parser.m_num_threads = 1;
+          const size_t begin = size * chunk / num_chunks;
+          const size_t end = size * (chunk + 1) / num_chunks;
+          for (size_t i = begin; i < end; ++i)
+            results[i] = parse(parser, u32(i));
+        },
+        num_threads);
+    return results;
+  }
+
   Byml ParseValueNode(u32 offset, NodeType type) {
     const auto raw = m_reader.Read<u32>(offset);
     if (!raw)
@@ -177,12 +121,14 @@ private:
 
     switch (type) {
     case NodeType::String:
-      return Byml{m_string_table.GetString(m_reader, *raw)};
+      return Byml{m_string_table->GetString(*raw)};
     case NodeType::Binary: {
       const u32 data_offset = *raw;
       const u32 size = m_reader.Read<u32>(data_offset).value();
-      return Byml{std::vector<u8>(m_reader.span().begin() + data_offset + 4,
-                                  m_reader.span().begin() + data_offset + 4 + size)};
+      auto data = m_reader.ReadArray<u8>(size);
+      if (!data)
+        throw InvalidDataError("Invalid binary node");
+      return Byml{std::move(*data)};
     }
     case NodeType::Bool:
       return *raw != 0;
@@ -211,25 +157,46 @@ private:
     return ParseValueNode(offset, type);
   }
 
+  Byml ParseArrayItem(u32 offset, u32 size, u32 i) {
+    const u32 values_offset = offset + 4 + util::AlignUp(size, 4);
+    const auto type = m_reader.Read<NodeType>(offset + 4 + i);
+    return ParseContainerChildNode(values_offset + 4 * i, type.value());
+  }
+
   Byml ParseArrayNode(u32 offset, u32 size) {
+    if (ShouldParseInParallel(size)) {
+      return Byml{ParseChildrenInParallel(size, [offset, size](Parser& parser, u32 i) {
+        return parser.ParseArrayItem(offset, size, i);
+      })};
+    }
+
     Byml::Array result;
     result.reserve(size);
-    const u32 values_offset = offset + 4 + util::AlignUp(size, 4);
-    for (u32 i = 0; i < size; ++i) {
-      const auto type = m_reader.Read<NodeType>(offset + 4 + i);
-      result.emplace_back(ParseContainerChildNode(values_offset + 4 * i, type.value()));
-    }
+    for (u32 i = 0; i < size; ++i)
+      result.emplace_back(ParseArrayItem(offset, size, i));
     return Byml{std::move(result)};
   }
 
   Byml ParseHashNode(u32 offset, u32 size) {
-    Byml::Hash result;
-    for (u32 i = 0; i < size; ++i) {
+    const auto get_key = [&](u32 i) {
+      const auto name_idx = m_reader.ReadU24(offset + 4 + 8 * i);
+      return m_hash_key_table->GetString(name_idx.value());
+    };
+    const auto parse_value = [offset](Parser& parser, u32 i) {
       const u32 entry_offset = offset + 4 + 8 * i;
-      const auto name_idx = m_reader.ReadU24(entry_offset);
-      const auto type = m_reader.Read<NodeType>(entry_offset + 3);
-      result.emplace(m_hash_key_table.GetString(m_reader, name_idx.value()),
-                     ParseContainerChildNode(entry_offset + 4, type.value()));
+      const auto type = parser.m_reader.Read<NodeType>(entry_offset + 3);
+      return parser.ParseContainerChildNode(entry_offset + 4, type.value());
+    };
+
+    Byml::Hash result;
+    // Entries are sorted by key, so inserting at the end avoids searching the tree.
+    if (ShouldParseInParallel(size)) {
+      auto values = ParseChildrenInParallel(size, parse_value);
+      for (u32 i = 0; i < size; ++i)
+        result.emplace_hint(result.end(), get_key(i), std::move(values[i]));
+    } else {
+      for (u32 i = 0; i < size; ++i)
+        result.emplace_hint(result.end(), get_key(i), parse_value(*this, i));
     }
     return Byml{std::move(result)};
   }
@@ -251,9 +218,11 @@ private:
   }
 
   util::BinaryReader m_reader;
-  StringTableParser m_hash_key_table;
-  StringTableParser m_string_table;
+  std::shared_ptr<const StringTablePool> m_hash_key_table;
+  std::shared_ptr<const StringTablePool> m_string_table;
   u32 m_root_node_offset;
+  /// 0 means one thread per hardware thread; 1 disables parallel parsing.
+  size_t m_num_threads;
 };
 
 template <typename Value, typename T>
@@ -266,209 +235,527 @@ std::vector<Value> SortMapKeys(const T& map) {
   return keys;
 }
 
+inline size_t CombineHashes(size_t a, size_t b) {
+  return absl::Hash<std::pair<size_t, size_t>>{}({a, b});
+}
+
 struct WriteContext {
-  WriteContext(const Byml& root, util::Endianness endianness) : writer{endianness} {
-    size_t num_non_inline_nodes = 0;
-    const auto traverse = [&](auto self, const Byml& data) -> void {
-      const Byml::Type type = data.GetType();
-      if (IsNonInlineType(type))
-        ++num_non_inline_nodes;
-      switch (type) {
-      case Byml::Type::String:
-        string_table.Add(data.GetString());
-        break;
-      case Byml::Type::Array:
-        for (const auto& value : data.GetArray())
-          self(self, value);
-        break;
-      case Byml::Type::Hash:
-        for (const auto& [key, value] : data.GetHash()) {
-          hash_key_table.Add(key);
-          self(self, value);
-        }
-        break;
-      default:
-        break;
-      }
-    };
-    traverse(traverse, root);
-    non_inline_node_data.reserve(num_non_inline_nodes);
+  explicit WriteContext(const Byml& root, size_t num_threads = 1)
+      : root{root}, num_threads{num_threads == 0 ? util::GetDefaultNumThreads() : num_threads} {
+    if (this->num_threads != 1)
+      FindParallelContainers(root);
+    ComputeHashes();
     hash_key_table.Build();
     string_table.Build();
+    Layout(root);
   }
 
-  void WriteValueNode(const Byml& data) {
-    switch (data.GetType()) {
-    case Byml::Type::Null:
-      return writer.Write<u32>(0);
-    case Byml::Type::String:
-      return writer.Write<u32>(string_table.GetIndex(data.GetString()));
-    case Byml::Type::Binary:
-      writer.Write(static_cast<u32>(data.GetBinary().size()));
-      writer.WriteBytes(data.GetBinary());
+  /// Returns the exact size of the serialized document.
+  size_t GetSize() const { return size; }
+
+  /// Serialize the document. The buffer must be GetSize() bytes long and zero-initialised.
+  void Write(tcb::span<u8> buffer, util::Endianness endianness, int version) const {
+    Emitter emitter{*this, {buffer, endianness}};
+    emitter.Write(version);
+  }
+
+private:
+  struct StringTable {
+    explicit operator bool() const { return !sorted_strings.empty(); }
+    size_t Size() const { return sorted_strings.size(); }
+    void Add(std::string_view string) { map.emplace(string, 0); }
+    void Merge(const StringTable& other) {
+      for (const auto& [string, index] : other.map)
+        Add(string);
+    }
+    u32 GetIndex(std::string_view string) const { return map.at(string); }
+
+    /// Build the sorted vector of strings and sets indices in the map.
+    void Build() {
+      sorted_strings = SortMapKeys<std::string_view>(map);
+      for (const auto& [i, key] : util::Enumerate(sorted_strings))
+        map[key] = i;
+      binary_size = sizeof(u32) * (1 + Size() + 1);
+      for (const auto string : sorted_strings)
+        binary_size += string.size() + 1;
+    }
+
+    // We use a hash map here to get fast insertions and fast lookups in hot paths,
+    // and because we only need a sorted list of strings for two operations.
+    absl::flat_hash_map<std::string_view, u32> map;
+    std::vector<std::string_view> sorted_strings;
+    /// Size of the string table node (excluding alignment padding).
+    size_t binary_size = 0;
+  };
+
+  /// A non-inline node with its precomputed structural hash.
+  /// Nodes are only compared if their hashes are equal.
+  struct NonInlineNodeKey {
+    const Byml* data;
+    size_t hash;
+
+    bool operator==(const NonInlineNodeKey& other) const {
+      return hash == other.hash && *data == *other.data;
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const NonInlineNodeKey& key) {
+      return H::combine(std::move(h), key.hash);
+    }
+  };
+
+  /// Calls fn(i, item) for every item of an array or every value of a hash.
+  template <typename Fn>
+  static void ForEachItem(const Byml& data, Fn fn) {
+    size_t i = 0;
+    if (data.GetType() == Byml::Type::Array) {
+      for (const auto& item : data.GetArray())
+        fn(i++, item);
+    } else {
+      for (const auto& [key, value] : data.GetHash())
+        fn(i++, value);
+    }
+  }
+
+  // Large containers (typically the root array of a map unit or of ActorInfo) can be processed
+  // in parallel: their children are hashed and emitted by worker threads. The layout pass is
+  // always serial, so the output is identical to that of a serial write.
+
+  /// A container whose children are hashed and emitted in parallel.
+  struct ParallelContainer {
+    std::vector<const Byml*> items;
+    /// Structural hashes of the items.
+    std::vector<size_t> item_hashes;
+    /// Offset of each item that was placed in this container (0 for other items)
+    /// and the position of its slot range in slot_offsets.
+    std::vector<std::pair<u32, size_t>> placements;
+    /// Offset and slot_offsets position after all items have been laid out.
+    size_t end_offset = 0;
+    size_t end_slot = 0;
+  };
+
+  /// Finds containers that are large enough to be processed in parallel. Containers that are
+  /// nested in such a container are always processed serially.
+  void FindParallelContainers(const Byml& data) {
+    if (!IsContainerType(data.GetType()))
+      return;
+    const size_t size = data.GetType() == Byml::Type::Array ? data.GetArray().size() :
+                                                              data.GetHash().size();
+    if (size < ParallelThreshold) {
+      ForEachItem(data, [&](size_t, const Byml& item) { FindParallelContainers(item); });
       return;
-    case Byml::Type::Bool:
-      return writer.Write<u32>(data.GetBool());
-    case Byml::Type::Int:
-      return writer.Write(data.GetInt());
-    case Byml::Type::Float:
-      return writer.Write(data.GetFloat());
-    case Byml::Type::UInt:
-      return writer.Write(data.GetUInt());
-    case Byml::Type::Int64:
-      return writer.Write(data.GetInt64());
-    case Byml::Type::UInt64:
-      return writer.Write(data.GetUInt64());
-    case Byml::Type::Double:
-      return writer.Write(data.GetDouble());
-    default:
-      throw std::logic_error("Unexpected value node type");
     }
+    parallel_container_indices.emplace(&data, parallel_containers.size());
+    auto& container = parallel_containers.emplace_back();
+    container.items.reserve(size);
+    ForEachItem(data, [&](size_t, const Byml& item) { container.items.push_back(&item); });
+    container.item_hashes.resize(size);
+    container.placements.resize(size);
   }
 
-  struct NonInlineNode {
-    size_t offset_in_container;
-    const Byml* data;
+  const ParallelContainer* GetParallelContainer(const Byml& data) const {
+    if (parallel_containers.empty())
+      return nullptr;
+    const auto it = parallel_container_indices.find(&data);
+    return it == parallel_container_indices.end() ? nullptr : &parallel_containers[it->second];
+  }
+
+  ParallelContainer* GetParallelContainer(const Byml& data) {
+    return const_cast<ParallelContainer*>(std::as_const(*this).GetParallelContainer(data));
+  }
+
+  /// Returns the number of chunks the items of a parallel container are split into.
+  /// More chunks than threads are used to balance the load, as items may vary in size.
+  size_t GetNumChunks(const ParallelContainer& container) const {
+    return std::min(container.items.size(), num_threads * 4);
+  }
+
+  /// Calls fn(chunk, begin, end) for every chunk of items, in parallel.
+  template <typename Fn>
+  void ForEachChunk(const ParallelContainer& container, Fn fn) const {
+    const size_t size = container.items.size();
+    const size_t num_chunks = GetNumChunks(container);
+    util::ParallelFor(
+        num_chunks,
+        [&](size_t chunk) {
+          fn(chunk, size * chunk / num_chunks, size * (chunk + 1) / num_chunks);
+        },
+        num_threads);
+  }
+
+  struct HashState {
+    StringTable hash_key_table;
+    StringTable string_table;
+    std::vector<std::pair<const Byml*, size_t>> node_hashes;
   };
 
-  void WriteContainerNode(const Byml& data) {
-    std::vector<NonInlineNode> non_inline_nodes;
+  /// Computes the structural hash of a node and adds all strings to the string tables.
+  /// Hashes are computed bottom-up in a single pass, so that deduplicating non-inline nodes
+  /// does not require hashing entire subtrees again for every ancestor.
+  /// If use_parallel_containers is true, precomputed item hashes are used for parallel containers.
+  size_t HashNode(const Byml& data, HashState& state, bool use_parallel_containers) const {
+    const Byml::Type type = data.GetType();
+    const ParallelContainer* container =
+        use_parallel_containers ? GetParallelContainer(data) : nullptr;
+    const auto hash_item = [&](size_t i, const Byml& item) {
+      return container ? container->item_hashes[i] :
+                         HashNode(item, state, use_parallel_containers);
+    };
 
-    const auto write_container_item = [&](const Byml& item) {
-      if (IsNonInlineType(item.GetType())) {
-        non_inline_nodes.push_back({writer.Tell(), &item});
-        writer.Write<u32>(0);
-      } else {
-        WriteValueNode(item);
+    size_t hash;
+    switch (type) {
+    case Byml::Type::String:
+      state.string_table.Add(data.GetString());
+      hash = absl::Hash<Byml>{}(data);
+      break;
+    case Byml::Type::Array: {
+      hash = absl::Hash<Byml::Type>{}(type);
+      size_t i = 0;
+      for (const auto& value : data.GetArray())
+        hash = CombineHashes(hash, hash_item(i++, value));
+      break;
+    }
+    case Byml::Type::Hash: {
+      hash = absl::Hash<Byml::Type>{}(type);
+      size_t i = 0;
+      for (const auto& [key, value] : data.GetHash()) {
+        state.hash_key_table.Add(key);
+        hash = CombineHashes(hash, absl::Hash<std::string_view>{}(key));
+        hash = CombineHashes(hash, hash_item(i++, value));
       }
+      break;
+    }
+    default:
+      hash = absl::Hash<Byml>{}(data);
+      break;
+    }
+    if (IsNonInlineType(type))
+      state.node_hashes.emplace_back(&data, hash);
+    return hash;
+  }
+
+  void ComputeHashes() {
+    // Hash the items of parallel containers first (in parallel), then everything else.
+    std::vector<HashState> shards;
+    for (auto& container : parallel_containers) {
+      const size_t first_shard = shards.size();
+      shards.resize(first_shard + GetNumChunks(container));
+      ForEachChunk(container, [&](size_t chunk, size_t begin, size_t end) {
+        HashState& state = shards[first_shard + chunk];
+        for (size_t i = begin; i < end; ++i)
+          container.item_hashes[i] = HashNode(*container.items[i], state, false);
+      });
+    }
+
+    HashState state;
+    HashNode(root, state, true);
+
+    size_t num_node_hashes = state.node_hashes.size();
+    for (const auto& shard : shards)
+      num_node_hashes += shard.node_hashes.size();
+    node_hashes.reserve(num_node_hashes);
+    node_hashes.insert(state.node_hashes.begin(), state.node_hashes.end());
+    hash_key_table = std::move(state.hash_key_table);
+    string_table = std::move(state.string_table);
+    for (const auto& shard : shards) {
+      node_hashes.insert(shard.node_hashes.begin(), shard.node_hashes.end());
+      hash_key_table.Merge(shard.hash_key_table);
+      string_table.Merge(shard.string_table);
+    }
+  }
+
+  static size_t GetValueNodeSize(const Byml& data) {
+    if (data.GetType() == Byml::Type::Binary)
+      return sizeof(u32) + data.GetBinary().size();
+    return sizeof(u64);
+  }
+
+  // Layout pass: this assigns an offset to every non-inline node and computes the file size,
+  // so that everything can then be written sequentially without any back-patching.
+  //
+  // Non-inline nodes are placed right after the container that first references them,
+  // in the order they appear in the container. Each container reserves a contiguous range of
+  // slot_offsets for its non-inline children; the emit pass consumes these ranges in the same
+  // (pre-)order.
+
+  void Layout(const Byml& root) {
+    size_t offset = sizeof(ResHeader);
+    if (root.GetType() == Byml::Type::Null) {
+      size = offset;
+      return;
+    }
+
+    if (hash_key_table) {
+      hash_key_table_offset = offset;
+      offset = util::AlignUp(offset + hash_key_table.binary_size, 4);
+    }
+    if (string_table) {
+      string_table_offset = offset;
+      offset = util::AlignUp(offset + string_table.binary_size, 4);
+    }
+    root_node_offset = offset;
+
+    non_inline_node_data.reserve(node_hashes.size());
+    slot_offsets.reserve(node_hashes.size());
+    LayoutContainerNode(root, offset);
+    // The document is not padded after the last node.
+    size = offset;
+    if (size > std::numeric_limits<u32>::max())
+      throw std::length_error("Document is too large");
+  }
+
+  void LayoutContainerNode(const Byml& data, size_t& offset) {
+    size_t num_non_inline_children = 0;
+    const auto count_item = [&](const Byml& item) {
+      if (IsNonInlineType(item.GetType()))
+        ++num_non_inline_children;
     };
 
     switch (data.GetType()) {
     case Byml::Type::Array: {
       const auto& array = data.GetArray();
-      writer.Write(NodeType::Array);
-      writer.WriteU24(array.size());
+      offset = util::AlignUp(offset + 4 + array.size(), 4) + 4 * array.size();
       for (const auto& item : array)
-        writer.Write(GetNodeType(item.GetType()));
-      writer.AlignUp(4);
-      for (const auto& item : array)
-        write_container_item(item);
+        count_item(item);
       break;
     }
     case Byml::Type::Hash: {
       const auto& hash = data.GetHash();
-      writer.Write(NodeType::Hash);
-      writer.WriteU24(hash.size());
-      for (const auto& [key, value] : hash) {
-        const auto type = GetNodeType(value.GetType());
-        writer.WriteU24(hash_key_table.GetIndex(key));
-        writer.Write(type);
-        write_container_item(value);
-      }
+      offset += 4 + 8 * hash.size();
+      for (const auto& [key, value] : hash)
+        count_item(value);
       break;
     }
     default:
       throw std::invalid_argument("Invalid container node type");
     }
 
-    for (const NonInlineNode& node : non_inline_nodes) {
-      const auto it = non_inline_node_data.find(*node.data);
-      if (it != non_inline_node_data.end()) {
-        // This node has already been written. Reuse its data.
-        writer.RunAt(node.offset_in_container, [&](size_t) { writer.Write<u32>(it->second); });
-      } else {
-        const size_t offset = writer.Tell();
-        writer.RunAt(node.offset_in_container, [&](size_t) { writer.Write<u32>(offset); });
-        non_inline_node_data.emplace(*node.data, offset);
-        if (IsContainerType(node.data->GetType()))
-          WriteContainerNode(*node.data);
-        else
-          WriteValueNode(*node.data);
-      }
+    const size_t base = slot_offsets.size();
+    slot_offsets.resize(base + num_non_inline_children);
+
+    ParallelContainer* container = GetParallelContainer(data);
+    size_t slot_idx = base;
+    ForEachItem(data, [&](size_t i, const Byml& item) {
+      if (!IsNonInlineType(item.GetType()))
+        return;
+      const NonInlineNodeKey key{&item, node_hashes.at(&item)};
+      const auto [it, inserted] = non_inline_node_data.try_emplace(key, u32(offset));
+      // If the node has already been placed, its data is reused.
+      slot_offsets[slot_idx++] = it->second;
+      if (!inserted)
+        return;
+      if (container)
+        container->placements[i] = {u32(offset), slot_offsets.size()};
+      if (IsContainerType(item.GetType()))
+        LayoutContainerNode(item, offset);
+      else
+        offset += GetValueNodeSize(item);
+    });
+
+    if (container) {
+      container->end_offset = offset;
+      container->end_slot = slot_offsets.size();
     }
   }
 
-  struct StringTable {
-    explicit operator bool() const { return !sorted_strings.empty(); }
-    size_t Size() const { return sorted_strings.size(); }
-    void Add(std::string_view string) { map.emplace(string, 0); }
-    u32 GetIndex(std::string_view string) const { return map.at(string); }
+  // Emit pass.
 
-    /// Build the sorted vector of strings and sets indices in the map.
-    void Build() {
-      sorted_strings = SortMapKeys<std::string_view>(map);
-      for (const auto& [i, key] : util::Enumerate(sorted_strings))
-        map[key] = i;
+  struct Emitter {
+    void Write(int version) {
+      writer.Write(writer.Endian() == util::Endianness::Big ? "BY" : "YB");
+      writer.Write<u16>(version);
+      writer.Write<u32>(ctx.hash_key_table_offset);
+      writer.Write<u32>(ctx.string_table_offset);
+      writer.Write<u32>(ctx.root_node_offset);
+
+      if (ctx.root_node_offset == 0)
+        return;
+
+      if (ctx.hash_key_table)
+        WriteStringTable(ctx.hash_key_table);
+      if (ctx.string_table)
+        WriteStringTable(ctx.string_table);
+
+      WriteContainerNode(ctx.root);
     }
 
-    // We use a hash map here to get fast insertions and fast lookups in hot paths,
-    // and because we only need a sorted list of strings for two operations.
-    absl::flat_hash_map<std::string_view, u32> map;
-    std::vector<std::string_view> sorted_strings;
-  };
+    void WriteStringTable(const StringTable& table) {
+      writer.Write(NodeType::StringTable);
+      writer.WriteU24(table.Size());
+
+      // String offsets (relative to the start of the table), then the strings.
+      std::vector<u32> offsets;
+      offsets.reserve(table.Size() + 1);
+      u32 string_offset = sizeof(u32) * (1 + table.Size() + 1);
+      for (const auto string : table.sorted_strings) {
+        offsets.push_back(string_offset);
+        string_offset += string.size() + 1;
+      }
+      offsets.push_back(string_offset);
+      writer.WriteArray<u32>(offsets);
+      for (const auto string : table.sorted_strings)
+        writer.WriteCStr(string);
+
+      writer.AlignUp(4);
+    }
+
+    void WriteValueNode(const Byml& data) {
+      switch (data.GetType()) {
+      case Byml::Type::Null:
+        return writer.Write<u32>(0);
+      case Byml::Type::String:
+        return writer.Write<u32>(ctx.string_table.GetIndex(data.GetString()));
+      case Byml::Type::Binary:
+        writer.Write(static_cast<u32>(data.GetBinary().size()));
+        writer.WriteBytes(data.GetBinary());
+        return;
+      case Byml::Type::Bool:
+        return writer.Write<u32>(data.GetBool());
+      case Byml::Type::Int:
+        return writer.Write(data.GetInt());
+      case Byml::Type::Float:
+        return writer.Write(data.GetFloat());
+      case Byml::Type::UInt:
+        return writer.Write(data.GetUInt());
+      case Byml::Type::Int64:
+        return writer.Write(data.GetInt64());
+      case Byml::Type::UInt64:
+        return writer.Write(data.GetUInt64());
+      case Byml::Type::Double:
+        return writer.Write(data.GetDouble());
+      default:
+        throw std::logic_error("Unexpected value node type");
+      }
+    }
+
+    void WriteContainerNode(const Byml& data) {
+      const size_t base = slot_cursor;
+      const auto write_container_item = [&](const Byml& item) {
+        if (IsNonInlineType(item.GetType()))
+          writer.Write<u32>(ctx.slot_offsets[slot_cursor++]);
+        else
+          WriteValueNode(item);
+      };
+
+      switch (data.GetType()) {
+      case Byml::Type::Array: {
+        const auto& array = data.GetArray();
+        writer.Write(NodeType::Array);
+        writer.WriteU24(array.size());
+        for (const auto& item : array)
+          writer.Write(GetNodeType(item.GetType()));
+        writer.AlignUp(4);
+        for (const auto& item : array)
+          write_container_item(item);
+        break;
+      }
+      case Byml::Type::Hash: {
+        const auto& hash = data.GetHash();
+        writer.Write(NodeType::Hash);
+        writer.WriteU24(hash.size());
+        for (const auto& [key, value] : hash) {
+          writer.WriteU24(ctx.hash_key_table.GetIndex(key));
+          writer.Write(GetNodeType(value.GetType()));
+          write_container_item(value);
+        }
+        break;
+      }
+      default:
+        throw std::invalid_argument("Invalid container node type");
+      }
 
-  void WriteStringTable(const StringTable& table) {
-    const size_t base = writer.Tell();
-    writer.Write(NodeType::StringTable);
-    writer.WriteU24(table.Size());
+      if (const ParallelContainer* container = ctx.GetParallelContainer(data)) {
+        WriteParallelContainerChildren(*container);
+        return;
+      }
 
-    // String offsets.
-    const size_t offset_table_offset = writer.Tell();
-    writer.Seek(writer.Tell() + sizeof(u32) * (table.Size() + 1));
+      // Write non-inline children that are placed here (i.e. that were not deduplicated).
+      size_t i = base;
+      ForEachItem(data, [&](size_t, const Byml& item) {
+        if (!IsNonInlineType(item.GetType()) || ctx.slot_offsets[i++] != writer.Tell())
+          return;
+        WriteNonInlineNode(item);
+      });
+    }
 
-    for (const auto& [i, string] : util::Enumerate(table.sorted_strings)) {
-      writer.WriteCurrentOffsetAt<u32>(offset_table_offset + sizeof(u32) * i, base);
-      writer.WriteCStr(string);
+    void WriteNonInlineNode(const Byml& data) {
+      if (IsContainerType(data.GetType()))
+        WriteContainerNode(data);
+      else
+        WriteValueNode(data);
     }
 
-    writer.WriteCurrentOffsetAt<u32>(offset_table_offset + sizeof(u32) * table.Size(), base);
-    writer.AlignUp(4);
-  }
+    /// Every placed child has a known offset and slot range, and writes to a separate part
+    /// of the buffer, so children can be written by several threads at the same time.
+    void WriteParallelContainerChildren(const ParallelContainer& container) {
+      ctx.ForEachChunk(container, [&](size_t, size_t begin, size_t end) {
+        Emitter emitter{ctx, writer};
+        for (size_t i = begin; i < end; ++i) {
+          const auto [offset, slot_idx] = container.placements[i];
+          if (offset == 0)
+            continue;
+          emitter.writer.Seek(offset);
+          emitter.slot_cursor = slot_idx;
+          emitter.WriteNonInlineNode(*container.items[i]);
+        }
+      });
+      writer.Seek(container.end_offset);
+      slot_cursor = container.end_slot;
+    }
 
-  util::BinaryWriter writer;
+    const WriteContext& ctx;
+    util::SpanWriter writer;
+    size_t slot_cursor = 0;
+  };
+
+  const Byml& root;
+  size_t num_threads;
+  std::vector<ParallelContainer> parallel_containers;
+  absl::flat_hash_map<const Byml*, size_t> parallel_container_indices;
   StringTable hash_key_table;
   StringTable string_table;
-  absl::flat_hash_map<std::reference_wrapper<const Byml>, u32> non_inline_node_data;
+  absl::flat_hash_map<const Byml*, size_t> node_hashes;
+  absl::flat_hash_map<NonInlineNodeKey, u32> non_inline_node_data;
+  /// Offsets of non-inline nodes, in the order in which they are referenced by containers.
+  std::vector<u32> slot_offsets;
+  u32 hash_key_table_offset = 0;
+  u32 string_table_offset = 0;
+  u32 root_node_offset = 0;
+  size_t size = 0;
 };
 
 }  // namespace byml
 
-Byml Byml::FromBinary(tcb::span<const u8> data) {
-  byml::Parser parser{data};
+Byml Byml::FromBinary(tcb::span<const u8> data, size_t num_threads) {
+  byml::Parser parser{data, num_threads};
   return parser.Parse();
 }
 
-std::vector<u8> Byml::ToBinary(bool big_endian, int version) const {
+size_t Byml::GetBinarySize() const {
+  return byml::WriteContext{*this}.GetSize();
+}
+
+std::vector<u8> Byml::ToBinary(bool big_endian, int version, size_t num_threads) const {
   if (!byml::IsValidVersion(version))
     throw std::invalid_argument("Invalid version");
 
-  byml::WriteContext ctx{*this, big_endian ? util::Endianness::Big : util::Endianness::Little};
-
-  // Header
-  ctx.writer.Write(ctx.writer.Endian() == util::Endianness::Big ? "BY" : "YB");
-  ctx.writer.Write<u16>(version);
-  ctx.writer.Write<u32>(0);  // Hash key table offset.
-  ctx.writer.Write<u32>(0);  // String table offset.
-  ctx.writer.Write<u32>(0);  // Root node offset.
-
-  if (GetType() == Byml::Type::Null)
-    return ctx.writer.Finalize();
-
-  if (ctx.hash_key_table) {
-    ctx.writer.WriteCurrentOffsetAt<u32>(offsetof(byml::ResHeader, hash_key_table_offset));
-    ctx.WriteStringTable(ctx.hash_key_table);
-  }
+  const byml::WriteContext ctx{*this, num_threads};
+  std::vector<u8> buffer(ctx.GetSize());
+  ctx.Write(buffer, big_endian ? util::Endianness::Big : util::Endianness::Little, version);
+  return buffer;
+}
 
-  if (ctx.string_table) {
-    ctx.writer.WriteCurrentOffsetAt<u32>(offsetof(byml::ResHeader, string_table_offset));
-    ctx.WriteStringTable(ctx.string_table);
-  }
+size_t Byml::ToBinary(tcb::span<u8> buffer, bool big_endian, int version,
+                      size_t num_threads) const {
+  if (!byml::IsValidVersion(version))
+    throw std::invalid_argument("Invalid version");
 
-  ctx.writer.WriteCurrentOffsetAt<u32>(offsetof(byml::ResHeader, root_node_offset));
-  ctx.writer.AlignUp(4);
-  ctx.WriteContainerNode(*this);
-  ctx.writer.AlignUp(4);
-  return ctx.writer.Finalize();
+  const byml::WriteContext ctx{*this, num_threads};
+  if (buffer.size() < ctx.GetSize())
+    throw std::invalid_argument("Buffer is too small");
+  buffer = buffer.first(ctx.GetSize());
+  std::fill(buffer.begin(), buffer.end(), 0);
+  ctx.Write(buffer, big_endian ? util::Endianness::Big : util::Endianness::Little, version);
+  return buffer.size();
 }
 
 Byml::Hash& Byml::GetHash() {
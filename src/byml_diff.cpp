@@ -0,0 +1,664 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/hash/hash.h>
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include <oead/byml_diff.h>
+#include <oead/errors.h>
+#include <oead/util/variant_utils.h>
+
+namespace oead {
+
+namespace {
+
+using Path = std::vector<BymlDiff::PathComponent>;
+
+bool IsContainerType(Byml::Type type) {
+  return type == Byml::Type::Array || type == Byml::Type::Hash;
+}
+
+size_t GetContainerSize(const Byml& node) {
+  return node.GetType() == Byml::Type::Array ? node.GetArray().size() : node.GetHash().size();
+}
+
+inline size_t CombineHashes(size_t a, size_t b) {
+  return absl::Hash<std::pair<size_t, size_t>>{}({a, b});
+}
+
+/// Computes structural hashes. Container hashes are computed once and cached,
+/// so comparing two subtrees is O(1) after the first comparison.
+class StructuralHasher {
+public:
+  size_t operator()(const Byml& node) {
+    const Byml::Type type = node.GetType();
+    if (!IsContainerType(type))
+      return absl::Hash<Byml>{}(node);
+
+    if (const auto it = m_cache.find(&node); it != m_cache.end())
+      return it->second;
+
+    size_t hash = absl::Hash<Byml::Type>{}(type);
+    if (type == Byml::Type::Array) {
+      for (const auto& item : node.GetArray())
+        hash = CombineHashes(hash, (*this)(item));
+    } else {
+      for (const auto& [key, value] : node.GetHash()) {
+        hash = CombineHashes(hash, absl::Hash<std::string_view>{}(key));
+        hash = CombineHashes(hash, (*this)(value));
+      }
+    }
+    m_cache.emplace(&node, hash);
+    return hash;
+  }
+
+  /// Containers with different sizes or structural hashes are unequal. Otherwise, they are
+  /// compared item by item (once per pair of containers) so that a hash collision cannot hide
+  /// a change.
+  bool Equal(const Byml& a, const Byml& b) {
+    if (&a == &b)
+      return true;
+    if (a.GetType() != b.GetType())
+      return false;
+    if (!IsContainerType(a.GetType()))
+      return a == b;
+    if (GetContainerSize(a) != GetContainerSize(b) || (*this)(a) != (*this)(b))
+      return false;
+    if (m_equal_pairs.contains({&a, &b}))
+      return true;
+
+    bool equal;
+    if (a.GetType() == Byml::Type::Array) {
+      const auto& items = a.GetArray();
+      equal = std::equal(items.begin(), items.end(), b.GetArray().begin(),
+                         [&](const Byml& x, const Byml& y) { return Equal(x, y); });
+    } else {
+      const auto& entries = a.GetHash();
+      equal = std::equal(entries.begin(), entries.end(), b.GetHash().begin(),
+                         [&](const auto& x, const auto& y) {
+                           return std::string_view(x.first) == std::string_view(y.first) &&
+                                  Equal(x.second, y.second);
+                         });
+    }
+    if (equal)
+      m_equal_pairs.insert({&a, &b});
+    return equal;
+  }
+
+private:
+  absl::flat_hash_map<const Byml*, size_t> m_cache;
+  absl::flat_hash_set<std::pair<const Byml*, const Byml*>> m_equal_pairs;
+};
+
+/// A range of items in the base array that is replaced by a range of items in the other array.
+struct Hunk {
+  size_t base_begin, base_end;
+  size_t other_begin, other_end;
+
+  size_t BaseSize() const { return base_end - base_begin; }
+  size_t OtherSize() const { return other_end - other_begin; }
+};
+
+/// Edit distance above which the Myers diff gives up and treats the remaining items
+/// as a single hunk. This bounds the time and memory cost for unrelated arrays.
+constexpr int MaxEditDistance = 1024;
+
+/// Returns the pairs of items that are kept (as indices into a and b), in order,
+/// or std::nullopt if the edit distance is larger than MaxEditDistance.
+/// a and b are item hashes; items with equal hashes are only kept if `equal` returns true.
+template <typename Equal>
+std::optional<std::vector<std::pair<size_t, size_t>>>
+MyersDiff(const std::vector<size_t>& a, const std::vector<size_t>& b, Equal equal) {
+  const int n = int(a.size());
+  const int m = int(b.size());
+  const int max_d = std::min(n + m, MaxEditDistance);
+
+  // trace[d] holds the furthest x for each diagonal k in [-d, d] after step d.
+  std::vector<std::vector<int>> trace;
+  std::vector<int> v(2 * max_d + 3);
+  const int offset = max_d + 1;
+  const auto snake = [&](int x, int y) {
+    while (x < n && y < m && a[x] == b[y] && equal(x, y))
+      ++x, ++y;
+    return x;
+  };
+
+  std::optional<int> final_d;
+  for (int d = 0; d <= max_d && !final_d; ++d) {
+    for (int k = -d; k <= d; k += 2) {
+      int x;
+      if (d == 0)
+        x = 0;
+      else if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+        x = v[offset + k + 1];
+      else
+        x = v[offset + k - 1] + 1;
+      x = snake(x, x - k);
+      v[offset + k] = x;
+      if (x >= n && x - k >= m)
+        final_d = d;
+    }
+    trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+  }
+  if (!final_d)
+    return std::nullopt;
+
+  std::vector<std::pair<size_t, size_t>> kept;
+  int x = n, y = m;
+  for (int d = *final_d; d > 0; --d) {
+    const auto& prev = trace[d - 1];
+    const auto prev_v = [&](int k) { return prev[k + d - 1]; };
+    const int k = x - y;
+    const bool down = k == -d || (k != d && prev_v(k - 1) < prev_v(k + 1));
+    const int prev_k = down ? k + 1 : k - 1;
+    const int prev_x = prev_v(prev_k);
+    const int prev_y = prev_x - prev_k;
+    const int mid_x = down ? prev_x : prev_x + 1;
+    const int mid_y = down ? prev_y + 1 : prev_y;
+    while (x > mid_x && y > mid_y)
+      kept.emplace_back(--x, --y);
+    x = prev_x;
+    y = prev_y;
+  }
+  while (x > 0 && y > 0)
+    kept.emplace_back(--x, --y);
+  std::reverse(kept.begin(), kept.end());
+  return kept;
+}
+
+/// Returns the hunks that turn `base` into `other`, in base order.
+std::vector<Hunk> DiffArrays(const Byml::Array& base, const Byml::Array& other,
+                             StructuralHasher& hasher) {
+  const size_t n = base.size();
+  const size_t m = other.size();
+  size_t prefix = 0;
+  while (prefix < n && prefix < m && hasher.Equal(base[prefix], other[prefix]))
+    ++prefix;
+  size_t suffix = 0;
+  while (suffix < n - prefix && suffix < m - prefix &&
+         hasher.Equal(base[n - 1 - suffix], other[m - 1 - suffix])) {
+    ++suffix;
+  }
+
+  std::vector<Hunk> hunks;
+  const Hunk middle{prefix, n - suffix, prefix, m - suffix};
+  if (middle.BaseSize() == 0 || middle.OtherSize() == 0) {
+    if (middle.BaseSize() != 0 || middle.OtherSize() != 0)
+      hunks.push_back(middle);
+    return hunks;
+  }
+
+  std::vector<size_t> a, b;
+  a.reserve(middle.BaseSize());
+  b.reserve(middle.OtherSize());
+  for (size_t i = middle.base_begin; i < middle.base_end; ++i)
+    a.push_back(hasher(base[i]));
+  for (size_t i = middle.other_begin; i < middle.other_end; ++i)
+    b.push_back(hasher(other[i]));
+
+  const auto kept = MyersDiff(a, b, [&](size_t x, size_t y) {
+    return hasher.Equal(base[middle.base_begin + x], other[middle.other_begin + y]);
+  });
+  if (!kept) {
+    hunks.push_back(middle);
+    return hunks;
+  }
+  size_t x = 0, y = 0;
+  const auto add_hunk = [&](size_t next_x, size_t next_y) {
+    if (next_x != x || next_y != y)
+      hunks.push_back({prefix + x, prefix + next_x, prefix + y, prefix + next_y});
+  };
+  for (const auto& [kept_x, kept_y] : *kept) {
+    add_hunk(kept_x, kept_y);
+    x = kept_x + 1;
+    y = kept_y + 1;
+  }
+  add_hunk(a.size(), b.size());
+  return hunks;
+}
+
+std::string FormatPath(const Path& path) {
+  std::string result;
+  for (const auto& component : path) {
+    util::Match(
+        component, [&](const std::string& key) { result += "/" + key; },
+        [&](size_t index) { result += "[" + std::to_string(index) + "]"; });
+  }
+  return result.empty() ? "/" : result;
+}
+
+/// Returns a null node or an empty container. Hashes are cached by node address,
+/// so these must not be temporaries.
+const Byml& GetEmptyNode(Byml::Type type) {
+  static const Byml null;
+  static const Byml empty_array{Byml::Array{}};
+  static const Byml empty_hash{Byml::Hash{}};
+  switch (type) {
+  case Byml::Type::Array:
+    return empty_array;
+  case Byml::Type::Hash:
+    return empty_hash;
+  default:
+    return null;
+  }
+}
+
+class Differ {
+public:
+  std::vector<BymlDiff::Change> Run(const Byml& base, const Byml& modified) {
+    DiffNode(base, modified);
+    return std::move(m_changes);
+  }
+
+private:
+  void AddChange(BymlDiff::Change::Kind kind, Byml value, size_t index = 0, size_t count = 0) {
+    m_changes.push_back({kind, m_path, std::move(value), index, count});
+  }
+
+  void DiffNode(const Byml& base, const Byml& modified) {
+    if (m_hasher.Equal(base, modified))
+      return;
+    if (base.GetType() != modified.GetType() || !IsContainerType(base.GetType())) {
+      AddChange(BymlDiff::Change::Kind::Set, modified);
+      return;
+    }
+    if (base.GetType() == Byml::Type::Hash)
+      DiffHashes(base.GetHash(), modified.GetHash());
+    else
+      DiffArrayItems(base.GetArray(), modified.GetArray());
+  }
+
+  void DiffHashes(const Byml::Hash& base, const Byml::Hash& modified) {
+    auto it = base.begin();
+    auto mod_it = modified.begin();
+    while (it != base.end() || mod_it != modified.end()) {
+      const bool removed = mod_it == modified.end() ||
+                           (it != base.end() && std::string_view(it->first) < mod_it->first);
+      const bool added = !removed && (it == base.end() || it->first != mod_it->first);
+      m_path.emplace_back(removed ? it->first : mod_it->first);
+      if (removed)
+        AddChange(BymlDiff::Change::Kind::Remove, Byml::Null());
+      else if (added)
+        AddChange(BymlDiff::Change::Kind::Set, mod_it->second);
+      else
+        DiffNode(it->second, mod_it->second);
+      m_path.pop_back();
+      if (!added)
+        ++it;
+      if (!removed)
+        ++mod_it;
+    }
+  }
+
+  void DiffArrayItems(const Byml::Array& base, const Byml::Array& modified) {
+    for (const Hunk& hunk : DiffArrays(base, modified, m_hasher)) {
+      if (hunk.BaseSize() == hunk.OtherSize()) {
+        for (size_t i = 0; i < hunk.BaseSize(); ++i) {
+          m_path.emplace_back(hunk.base_begin + i);
+          DiffNode(base[hunk.base_begin + i], modified[hunk.other_begin + i]);
+          m_path.pop_back();
+        }
+        continue;
+      }
+      Byml::Array items{modified.begin() + hunk.other_begin, modified.begin() + hunk.other_end};
+      AddChange(BymlDiff::Change::Kind::Splice, Byml{std::move(items)}, hunk.base_begin,
+                hunk.BaseSize());
+    }
+  }
+
+  StructuralHasher m_hasher;
+  Path m_path;
+  std::vector<BymlDiff::Change> m_changes;
+};
+
+class Merger {
+public:
+  explicit Merger(byml::MergePolicy policy) : m_policy{policy} {}
+
+  Byml MergeNode(const Byml& base, const Byml& ours, const Byml& theirs) {
+    if (m_hasher.Equal(ours, theirs) || m_hasher.Equal(base, theirs))
+      return ours;
+    if (m_hasher.Equal(base, ours))
+      return theirs;
+
+    const Byml::Type type = ours.GetType();
+    if (type == theirs.GetType() && IsContainerType(type)) {
+      // Containers that were added (or whose type was changed) on both sides are merged
+      // as if they were empty in the base document.
+      const Byml& merge_base = base.GetType() == type ? base : GetEmptyNode(type);
+      if (type == Byml::Type::Hash)
+        return MergeHashes(merge_base.GetHash(), ours.GetHash(), theirs.GetHash());
+      return MergeArrays(merge_base.GetArray(), ours.GetArray(), theirs.GetArray());
+    }
+    return ResolveConflict() ? ours : theirs;
+  }
+
+private:
+  /// Returns true if the version from `ours` should be kept.
+  bool ResolveConflict() const {
+    switch (m_policy) {
+    case byml::MergePolicy::PreferOurs:
+      return true;
+    case byml::MergePolicy::PreferTheirs:
+      return false;
+    case byml::MergePolicy::Fail:
+    default:
+      throw byml::MergeConflictError("Merge conflict at " + FormatPath(m_path));
+    }
+  }
+
+  Byml MergeHashes(const Byml::Hash& base, const Byml::Hash& ours, const Byml::Hash& theirs) {
+    Byml::Hash result;
+    auto it = ours.begin();
+    auto their_it = theirs.begin();
+    while (it != ours.end() || their_it != theirs.end()) {
+      const bool only_ours =
+          their_it == theirs.end() ||
+          (it != ours.end() && std::string_view(it->first) < their_it->first);
+      const bool only_theirs = !only_ours && (it == ours.end() || it->first != their_it->first);
+      const std::string& key = only_theirs ? their_it->first : it->first;
+      const auto base_it = base.find(key);
+      const Byml* base_value = base_it == base.end() ? nullptr : &base_it->second;
+
+      m_path.emplace_back(key);
+      std::optional<Byml> value;
+      if (!only_ours && !only_theirs) {
+        value = MergeNode(base_value ? *base_value : GetEmptyNode(Byml::Type::Null), it->second,
+                          their_it->second);
+      } else {
+        // Either added by one side, or removed by the other side.
+        const Byml& present = only_ours ? it->second : their_it->second;
+        if (!base_value)
+          value = present;
+        else if (!m_hasher.Equal(*base_value, present) && ResolveConflict() == only_ours)
+          value = present;
+      }
+      m_path.pop_back();
+
+      if (value)
+        result.emplace_hint(result.end(), key, std::move(*value));
+      if (!only_theirs)
+        ++it;
+      if (!only_ours)
+        ++their_it;
+    }
+    return Byml{std::move(result)};
+  }
+
+  Byml MergeArrays(const Byml::Array& base, const Byml::Array& ours, const Byml::Array& theirs) {
+    const auto our_hunks = DiffArrays(base, ours, m_hasher);
+    const auto their_hunks = DiffArrays(base, theirs, m_hasher);
+
+    // Returns the items that a side has in place of base[begin, end).
+    const auto get_items = [&](const Byml::Array& side, const std::vector<Hunk>& hunks,
+                               size_t first, size_t last, size_t begin, size_t end) {
+      std::vector<const Byml*> items;
+      size_t pos = begin;
+      for (size_t i = first; i < last; ++i) {
+        for (; pos < hunks[i].base_begin; ++pos)
+          items.push_back(&base[pos]);
+        for (size_t j = hunks[i].other_begin; j < hunks[i].other_end; ++j)
+          items.push_back(&side[j]);
+        pos = hunks[i].base_end;
+      }
+      for (; pos < end; ++pos)
+        items.push_back(&base[pos]);
+      return items;
+    };
+
+    Byml::Array result;
+    result.reserve(std::max(ours.size(), theirs.size()));
+    size_t pos = 0;
+    size_t i = 0, j = 0;
+    while (i < our_hunks.size() || j < their_hunks.size()) {
+      // Hunks are processed in base order; pure insertions come first so that an insertion
+      // right before a modified range does not conflict with it.
+      const auto hunk_less = [](const Hunk& a, const Hunk& b) {
+        return std::tie(a.base_begin, a.base_end) < std::tie(b.base_begin, b.base_end);
+      };
+      const bool ours_first =
+          j == their_hunks.size() ||
+          (i < our_hunks.size() && !hunk_less(their_hunks[j], our_hunks[i]));
+      const size_t first_ours = i, first_theirs = j;
+      const Hunk& first = ours_first ? our_hunks[i++] : their_hunks[j++];
+      const size_t begin = first.base_begin;
+      size_t end = first.base_end;
+
+      // Collect all hunks that overlap. Two insertions at the same position also overlap,
+      // since their relative order is ambiguous.
+      const auto overlaps = [&](const Hunk& hunk) {
+        return hunk.base_begin < end ||
+               (begin == end && hunk.base_begin == end && hunk.BaseSize() == 0);
+      };
+      while (true) {
+        if (i < our_hunks.size() && overlaps(our_hunks[i])) {
+          end = std::max(end, our_hunks[i++].base_end);
+        } else if (j < their_hunks.size() && overlaps(their_hunks[j])) {
+          end = std::max(end, their_hunks[j++].base_end);
+        } else {
+          break;
+        }
+      }
+
+      for (; pos < begin; ++pos)
+        result.push_back(base[pos]);
+      pos = end;
+
+      const auto our_items = get_items(ours, our_hunks, first_ours, i, begin, end);
+      const auto their_items = get_items(theirs, their_hunks, first_theirs, j, begin, end);
+      const auto append = [&](const std::vector<const Byml*>& items) {
+        for (const Byml* item : items)
+          result.push_back(*item);
+      };
+      if (first_theirs == j) {
+        append(our_items);
+      } else if (first_ours == i) {
+        append(their_items);
+      } else if (our_items.size() == their_items.size() &&
+                 std::equal(our_items.begin(), our_items.end(), their_items.begin(),
+                            [&](const Byml* a, const Byml* b) { return m_hasher.Equal(*a, *b); })) {
+        append(our_items);
+      } else if (our_items.size() == end - begin && their_items.size() == end - begin) {
+        // Both sides replaced the same items one-for-one: merge them item by item.
+        for (size_t k = 0; k < end - begin; ++k) {
+          m_path.emplace_back(begin + k);
+          result.push_back(MergeNode(base[begin + k], *our_items[k], *their_items[k]));
+          m_path.pop_back();
+        }
+      } else {
+        m_path.emplace_back(begin);
+        append(ResolveConflict() ? our_items : their_items);
+        m_path.pop_back();
+      }
+    }
+    for (; pos < base.size(); ++pos)
+      result.push_back(base[pos]);
+    return Byml{std::move(result)};
+  }
+
+  byml::MergePolicy m_policy;
+  StructuralHasher m_hasher;
+  Path m_path;
+};
+
+[[noreturn]] void ThrowPathError(const BymlDiff::Change& change, size_t depth,
+                                 std::string_view reason) {
+  const Path prefix{change.path.begin(), change.path.begin() + depth};
+  throw std::invalid_argument("Cannot apply diff: " + std::string(reason) + " at " +
+                              FormatPath(prefix));
+}
+
+size_t CheckedIndex(const BymlDiff::Change& change, size_t depth, const Byml::Array& array,
+                    size_t index, bool allow_end = false) {
+  if (index > array.size() || (index == array.size() && !allow_end))
+    ThrowPathError(change, depth, "index out of range");
+  return index;
+}
+
+constexpr std::string_view KindNames[] = {"set", "remove", "splice"};
+
+}  // namespace
+
+BymlDiff BymlDiff::Make(const Byml& base, const Byml& modified) {
+  return BymlDiff{Differ{}.Run(base, modified)};
+}
+
+void BymlDiff::Apply(Byml& document) const {
+  // Indices refer to the original document, so changes are applied in reverse order:
+  // a change never affects the indices of changes that come before it.
+  for (auto change = m_changes.rbegin(); change != m_changes.rend(); ++change) {
+    if (change->kind != Change::Kind::Splice && change->path.empty()) {
+      if (change->kind == Change::Kind::Remove)
+        ThrowPathError(*change, 0, "cannot remove the root node");
+      document = change->value;
+      continue;
+    }
+    const size_t parent_depth =
+        change->kind == Change::Kind::Splice ? change->path.size() : change->path.size() - 1;
+
+    Byml* node = &document;
+    for (size_t depth = 0; depth < parent_depth; ++depth) {
+      node = util::Match(
+          change->path[depth],
+          [&](const std::string& key) {
+            if (node->GetType() != Byml::Type::Hash)
+              ThrowPathError(*change, depth, "expected a hash");
+            const auto it = node->GetHash().find(key);
+            if (it == node->GetHash().end())
+              ThrowPathError(*change, depth + 1, "no such key");
+            return &it->second;
+          },
+          [&](size_t index) {
+            if (node->GetType() != Byml::Type::Array)
+              ThrowPathError(*change, depth, "expected an array");
+            return &node->GetArray()[CheckedIndex(*change, depth + 1, node->GetArray(), index)];
+          });
+    }
+
+    if (change->kind == Change::Kind::Splice) {
+      if (node->GetType() != Byml::Type::Array)
+        ThrowPathError(*change, parent_depth, "expected an array");
+      auto& array = node->GetArray();
+      const size_t index = CheckedIndex(*change, parent_depth, array, change->index, true);
+      if (change->count > array.size() - index)
+        ThrowPathError(*change, parent_depth, "index out of range");
+      const auto& items = change->value.GetArray();
+      array.erase(array.begin() + index, array.begin() + index + change->count);
+      array.insert(array.begin() + index, items.begin(), items.end());
+      continue;
+    }
+
+    util::Match(
+        change->path.back(),
+        [&](const std::string& key) {
+          if (node->GetType() != Byml::Type::Hash)
+            ThrowPathError(*change, parent_depth, "expected a hash");
+          if (change->kind == Change::Kind::Remove)
+            node->GetHash().erase(key);
+          else
+            node->GetHash().insert_or_assign(key, change->value);
+        },
+        [&](size_t index) {
+          if (node->GetType() != Byml::Type::Array)
+            ThrowPathError(*change, parent_depth, "expected an array");
+          auto& array = node->GetArray();
+          CheckedIndex(*change, parent_depth + 1, array, index);
+          if (change->kind == Change::Kind::Remove)
+            array.erase(array.begin() + index);
+          else
+            array[index] = change->value;
+        });
+  }
+}
+
+Byml BymlDiff::ToByml() const {
+  Byml::Array changes;
+  changes.reserve(m_changes.size());
+  for (const Change& change : m_changes) {
+    Byml::Array path;
+    for (const auto& component : change.path) {
+      util::Match(
+          component, [&](const std::string& key) { path.emplace_back(key); },
+          [&](size_t index) { path.emplace_back(U32(index)); });
+    }
+    Byml::Hash item;
+    item.emplace("op", Byml{KindNames[size_t(change.kind)]});
+    item.emplace("path", std::move(path));
+    if (change.kind != Change::Kind::Remove)
+      item.emplace("value", change.value);
+    if (change.kind == Change::Kind::Splice) {
+      item.emplace("index", U32(change.index));
+      item.emplace("count", U32(change.count));
+    }
+    changes.emplace_back(std::move(item));
+  }
+  return Byml{std::move(changes)};
+}
+
+BymlDiff BymlDiff::FromByml(const Byml& data) try {
+  std::vector<Change> changes;
+  for (const Byml& item : data.GetArray()) {
+    const auto& hash = item.GetHash();
+    Change change{};
+    const std::string_view op = hash.at("op").GetString();
+    const auto kind = std::find(std::begin(KindNames), std::end(KindNames), op);
+    if (kind == std::end(KindNames))
+      throw InvalidDataError("Invalid diff: unknown op: " + std::string(op));
+    change.kind = Change::Kind(kind - std::begin(KindNames));
+
+    for (const Byml& component : hash.at("path").GetArray()) {
+      if (component.GetType() == Byml::Type::String)
+        change.path.emplace_back(std::string(component.GetString()));
+      else
+        change.path.emplace_back(size_t(component.GetUInt()));
+    }
+    if (change.kind != Change::Kind::Remove)
+      change.value = hash.at("value");
+    if (change.kind == Change::Kind::Splice) {
+      if (change.value.GetType() != Byml::Type::Array)
+        throw InvalidDataError("Invalid diff: splice value must be an array");
+      change.index = hash.at("index").GetUInt();
+      change.count = hash.at("count").GetUInt();
+    }
+    changes.push_back(std::move(change));
+  }
+  return BymlDiff{std::move(changes)};
+} catch (const TypeError& e) {
+  throw InvalidDataError(std::string("Invalid diff: ") + e.what());
+} catch (const std::out_of_range& e) {
+  throw InvalidDataError(std::string("Invalid diff: missing key: ") + e.what());
+}
+
+namespace byml {
+
+Byml Merge(const Byml& base, const Byml& ours, const Byml& theirs, MergePolicy policy) {
+  return Merger{policy}.MergeNode(base, ours, theirs);
+}
+
+}  // namespace byml
+
+}  // namespace oead
@@ -0,0 +1,765 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string>
+#include <tuple>
+
+#include <oead/byml_document.h>
+#include <oead/errors.h>
+#include <oead/util/align.h>
+#include <oead/util/binary_reader.h>
+#include <oead/util/bit_utils.h>
+#include <oead/util/hash.h>
+#include <oead/util/magic_utils.h>
+#include "byml_res.h"
+
+namespace oead {
+
+namespace {
+
+/// Header of a document snapshot. The document data (starting with the root node) follows it.
+struct SnapshotHeader {
+  std::array<char, 8> magic;
+  /// 0x01020304 in the byte order of the platform that created the snapshot.
+  u32 byte_order_mark;
+  u16 version;
+  u8 node_size;
+  u8 hash_entry_size;
+  /// Size of the document data.
+  u64 data_size;
+  /// CRC32 of the document data.
+  u32 checksum;
+  u32 reserved;
+};
+static_assert(sizeof(SnapshotHeader) == 0x20);
+
+constexpr auto SnapshotMagic = util::MakeMagic("BYMLSNAP");
+constexpr u32 SnapshotByteOrderMark = 0x01020304;
+/// Must be incremented whenever the layout of nodes changes.
+constexpr u16 SnapshotVersion = 1;
+
+}  // namespace
+
+struct BymlDocumentBuilder {
+  using Node = BymlDocument::Node;
+  using HashEntry = BymlDocument::HashEntry;
+
+  explicit BymlDocumentBuilder(BymlDocument& doc) : arena{doc.m_arena} {}
+
+  /// Copy every string of a decoded table into the arena, once.
+  std::vector<std::string_view> InternTable(const byml::StringTablePool& pool) {
+    std::vector<std::string_view> strings;
+    strings.reserve(pool.Size());
+    for (u32 i = 0; i < pool.Size(); ++i)
+      strings.emplace_back(Intern(pool.GetString(i)));
+    return strings;
+  }
+
+  std::string_view Intern(std::string_view str) {
+    if (const auto it = interned_strings.find(str); it != interned_strings.end())
+      return *it;
+    const std::string_view copy = arena.CopyString(str);
+    interned_strings.emplace(copy);
+    return copy;
+  }
+
+  static void SetKey(HashEntry& entry, std::string_view key) {
+    entry.key_data = key.data();
+    entry.key_size = u32(key.size());
+  }
+
+  static void SetString(Node& node, std::string_view str) {
+    node.m_type = Byml::Type::String;
+    node.m_size = u32(str.size());
+    node.SetPointer(str.data());
+  }
+
+  void SetBinary(Node& node, tcb::span<const u8> data) {
+    node.m_type = Byml::Type::Binary;
+    node.m_size = u32(data.size());
+    node.SetPointer(arena.CopyBytes(data).data());
+  }
+
+  // Building from binary data.
+
+  void ParseValueNode(Node& node, u32 offset, byml::NodeType type) {
+    const auto raw = reader.Read<u32>(offset);
+    if (!raw)
+      throw InvalidDataError("Invalid value node");
+
+    const auto read_long_value = [this, raw] {
+      const auto long_value = reader.Read<u64>(*raw);
+      if (!long_value)
+        throw InvalidDataError("Invalid value node: failed to read long value");
+      return *long_value;
+    };
+
+    switch (type) {
+    case byml::NodeType::String:
+      if (*raw >= strings.size())
+        throw std::out_of_range("Invalid string table entry index");
+      return SetString(node, strings[*raw]);
+    case byml::NodeType::Binary: {
+      const u32 size = reader.Read<u32>(*raw).value();
+      const auto data = reader.span();
+      if (data.size() - *raw - 4 < size)
+        throw InvalidDataError("Invalid binary node");
+      return SetBinary(node, data.subspan(*raw + 4, size));
+    }
+    case byml::NodeType::Bool:
+      node.m_type = Byml::Type::Bool;
+      node.m_value.b = *raw != 0;
+      return;
+    case byml::NodeType::Int:
+      node.m_type = Byml::Type::Int;
+      node.m_value.s32_ = s32(*raw);
+      return;
+    case byml::NodeType::Float:
+      node.m_type = Byml::Type::Float;
+      node.m_value.f32_ = util::BitCast<f32>(*raw);
+      return;
+    case byml::NodeType::UInt:
+      node.m_type = Byml::Type::UInt;
+      node.m_value.u32_ = *raw;
+      return;
+    case byml::NodeType::Int64:
+      node.m_type = Byml::Type::Int64;
+      node.m_value.s64_ = s64(read_long_value());
+      return;
+    case byml::NodeType::UInt64:
+      node.m_type = Byml::Type::UInt64;
+      node.m_value.u64_ = read_long_value();
+      return;
+    case byml::NodeType::Double:
+      node.m_type = Byml::Type::Double;
+      node.m_value.f64_ = util::BitCast<f64>(read_long_value());
+      return;
+    case byml::NodeType::Null:
+      node.m_type = Byml::Type::Null;
+      return;
+    default:
+      throw InvalidDataError("Invalid value node: unexpected type");
+    }
+  }
+
+  void ParseContainerChildNode(Node& node, u32 offset, byml::NodeType type) {
+    if (byml::IsContainerType(type))
+      return ParseContainerNode(node, reader.Read<u32>(offset).value());
+    return ParseValueNode(node, offset, type);
+  }
+
+  const Node* ParseArrayItems(u32 offset, u32 size) {
+    Node* items = arena.AllocateArray<Node>(size);
+    const u32 values_offset = offset + 4 + util::AlignUp(size, 4);
+    for (u32 i = 0; i < size; ++i) {
+      const auto type = reader.Read<byml::NodeType>(offset + 4 + i);
+      ParseContainerChildNode(items[i], values_offset + 4 * i, type.value());
+    }
+    return items;
+  }
+
+  const HashEntry* ParseHashEntries(u32 offset, u32 size) {
+    HashEntry* entries = arena.AllocateArray<HashEntry>(size);
+    for (u32 i = 0; i < size; ++i) {
+      const u32 entry_offset = offset + 4 + 8 * i;
+      const u32 name_idx = reader.ReadU24(entry_offset).value();
+      const auto type = reader.Read<byml::NodeType>(entry_offset + 3);
+      if (name_idx >= hash_keys.size())
+        throw std::out_of_range("Invalid string table entry index");
+      SetKey(entries[i], hash_keys[name_idx]);
+      ParseContainerChildNode(entries[i].value, entry_offset + 4, type.value());
+    }
+    // Nintendo's writer always sorts entries by key, but other tools may not.
+    if (!std::is_sorted(entries, entries + size,
+                        [](const HashEntry& a, const HashEntry& b) { return a.GetKey() < b.GetKey(); })) {
+      std::stable_sort(entries, entries + size,
+                       [](const HashEntry& a, const HashEntry& b) { return a.GetKey() < b.GetKey(); });
+    }
+    return entries;
+  }
+
+  void ParseContainerNode(Node& node, u32 offset) {
+    const auto type = reader.Read<byml::NodeType>(offset);
+    const auto num_entries = reader.ReadU24();
+    if (!type || !num_entries)
+      throw InvalidDataError("Invalid container node");
+
+    node.m_size = *num_entries;
+
+    // Containers that are referenced several times only need to be stored once
+    // since documents are immutable.
+    if (const auto it = containers.find(offset); it != containers.end()) {
+      node = it->second;
+      return;
+    }
+
+    switch (*type) {
+    case byml::NodeType::Array:
+      node.m_type = Byml::Type::Array;
+      node.SetPointer(ParseArrayItems(offset, *num_entries));
+      break;
+    case byml::NodeType::Hash:
+      node.m_type = Byml::Type::Hash;
+      node.SetPointer(ParseHashEntries(offset, *num_entries));
+      break;
+    default:
+      throw InvalidDataError("Invalid container node: must be array or hash");
+    }
+    containers.emplace(offset, node);
+  }
+
+  // Building from a Byml.
+
+  void Build(Node& node, const Byml& byml) {
+    switch (byml.GetType()) {
+    case Byml::Type::Null:
+      node.m_type = Byml::Type::Null;
+      return;
+    case Byml::Type::String:
+      return SetString(node, Intern(byml.GetString()));
+    case Byml::Type::Binary:
+      return SetBinary(node, byml.GetBinary());
+    case Byml::Type::Array: {
+      const auto& array = byml.GetArray();
+      Node* items = arena.AllocateArray<Node>(array.size());
+      for (size_t i = 0; i < array.size(); ++i)
+        Build(items[i], array[i]);
+      node.m_type = Byml::Type::Array;
+      node.m_size = u32(array.size());
+      node.SetPointer(items);
+      return;
+    }
+    case Byml::Type::Hash: {
+      const auto& hash = byml.GetHash();
+      HashEntry* entries = arena.AllocateArray<HashEntry>(hash.size());
+      size_t i = 0;
+      for (const auto& [key, value] : hash) {
+        SetKey(entries[i], Intern(key));
+        Build(entries[i].value, value);
+        ++i;
+      }
+      node.m_type = Byml::Type::Hash;
+      node.m_size = u32(hash.size());
+      node.SetPointer(entries);
+      return;
+    }
+    case Byml::Type::Bool:
+      node.m_type = Byml::Type::Bool;
+      node.m_value.b = byml.GetBool();
+      return;
+    case Byml::Type::Int:
+      node.m_type = Byml::Type::Int;
+      node.m_value.s32_ = byml.Get<Byml::Type::Int>();
+      return;
+    case Byml::Type::Float:
+      node.m_type = Byml::Type::Float;
+      node.m_value.f32_ = byml.GetFloat();
+      return;
+    case Byml::Type::UInt:
+      node.m_type = Byml::Type::UInt;
+      node.m_value.u32_ = byml.Get<Byml::Type::UInt>();
+      return;
+    case Byml::Type::Int64:
+      node.m_type = Byml::Type::Int64;
+      node.m_value.s64_ = byml.Get<Byml::Type::Int64>();
+      return;
+    case Byml::Type::UInt64:
+      node.m_type = Byml::Type::UInt64;
+      node.m_value.u64_ = byml.Get<Byml::Type::UInt64>();
+      return;
+    case Byml::Type::Double:
+      node.m_type = Byml::Type::Double;
+      node.m_value.f64_ = byml.GetDouble();
+      return;
+    }
+  }
+
+  util::MonotonicArena& arena;
+  absl::flat_hash_set<std::string_view> interned_strings;
+
+  util::BinaryReader reader;
+  std::vector<std::string_view> hash_keys;
+  std::vector<std::string_view> strings;
+  /// Offset -> container node (for binary data).
+  absl::flat_hash_map<u32, Node> containers;
+};
+
+BymlDocument BymlDocument::FromBinary(tcb::span<const u8> data) {
+  if (data.size() < sizeof(byml::ResHeader))
+    throw InvalidDataError("Invalid header");
+
+  const bool is_big_endian = data[0] == 'B' && data[1] == 'Y';
+  const bool is_little_endian = data[0] == 'Y' && data[1] == 'B';
+  if (!is_big_endian && !is_little_endian)
+    throw InvalidDataError("Invalid magic");
+
+  BymlDocument doc;
+  BymlDocumentBuilder builder{doc};
+  auto& reader = builder.reader;
+  reader = {data, is_big_endian ? util::Endianness::Big : util::Endianness::Little};
+
+  const u16 version = *reader.Read<u16>(offsetof(byml::ResHeader, version));
+  if (!byml::IsValidVersion(version))
+    throw InvalidDataError("Unexpected version");
+
+  builder.hash_keys = builder.InternTable(byml::StringTablePool(
+      reader, *reader.Read<u32>(offsetof(byml::ResHeader, hash_key_table_offset))));
+  builder.strings = builder.InternTable(byml::StringTablePool(
+      reader, *reader.Read<u32>(offsetof(byml::ResHeader, string_table_offset))));
+
+  Node* root = doc.m_arena.AllocateArray<Node>(1);
+  const u32 root_node_offset = *reader.Read<u32>(offsetof(byml::ResHeader, root_node_offset));
+  if (root_node_offset != 0)
+    builder.ParseContainerNode(*root, root_node_offset);
+  doc.m_root = root;
+  return doc;
+}
+
+BymlDocument BymlDocument::FromByml(const Byml& byml) {
+  BymlDocument doc;
+  BymlDocumentBuilder builder{doc};
+  Node* root = doc.m_arena.AllocateArray<Node>(1);
+  builder.Build(*root, byml);
+  doc.m_root = root;
+  return doc;
+}
+
+std::vector<u8> BymlDocument::ToBinary(bool big_endian, int version) const {
+  return ToByml().ToBinary(big_endian, version);
+}
+
+/// Copies a document into a single contiguous block. Shared containers and interned strings
+/// are only copied once.
+struct BymlSnapshotWriter {
+  using Node = BymlDocument::Node;
+  using HashEntry = BymlDocument::HashEntry;
+
+  struct Block {
+    const void* source;
+    Byml::Type type;
+    size_t size;
+    size_t offset;
+  };
+
+  std::vector<u8> Write(const Node& root) {
+    const size_t root_offset = Allocate(sizeof(Node), alignof(Node));
+    Layout(root);
+
+    std::vector<u8> data(sizeof(SnapshotHeader) + data_size);
+    base = data.data() + sizeof(SnapshotHeader);
+    WriteNode(root, *new (base + root_offset) Node);
+    for (const Block& block : blocks)
+      WriteBlock(block);
+
+    SnapshotHeader header{};
+    header.magic = SnapshotMagic;
+    header.byte_order_mark = SnapshotByteOrderMark;
+    header.version = SnapshotVersion;
+    header.node_size = sizeof(Node);
+    header.hash_entry_size = sizeof(HashEntry);
+    header.data_size = data_size;
+    header.checksum = util::crc32(base, data_size);
+    std::memcpy(data.data(), &header, sizeof(header));
+    return data;
+  }
+
+private:
+  size_t Allocate(size_t size, size_t alignment) {
+    const size_t offset = util::AlignUp(data_size, alignment);
+    data_size = offset + size;
+    return offset;
+  }
+
+  void AddBlock(const void* source, Byml::Type type, size_t size, size_t alignment) {
+    if (!source || offsets.contains(source))
+      return;
+    const size_t offset = Allocate(size, alignment);
+    offsets.emplace(source, offset);
+    blocks.push_back({source, type, size, offset});
+  }
+
+  void Layout(const Node& node) {
+    const void* source = node.HasPointer() ? node.GetPointer<void>() : nullptr;
+    if (!source)
+      return;
+    switch (node.m_type) {
+    case Byml::Type::String:
+      // Strings are null-terminated in the arena.
+      return AddBlock(source, node.m_type, node.m_size + 1, 1);
+    case Byml::Type::Binary:
+      return AddBlock(source, node.m_type, node.m_size, 1);
+    case Byml::Type::Array:
+      if (offsets.contains(source))
+        return;
+      AddBlock(source, node.m_type, sizeof(Node) * node.m_size, alignof(Node));
+      for (const Node& item : node.GetArray())
+        Layout(item);
+      return;
+    case Byml::Type::Hash:
+      if (offsets.contains(source))
+        return;
+      AddBlock(source, node.m_type, sizeof(HashEntry) * node.m_size, alignof(HashEntry));
+      for (const HashEntry& entry : node.GetHash()) {
+        AddBlock(entry.key_data.Get(), Byml::Type::String, entry.key_size + 1, 1);
+        Layout(entry.value);
+      }
+      return;
+    default:
+      return;
+    }
+  }
+
+  void WriteNode(const Node& source, Node& node) const {
+    node = source;
+    if (source.HasPointer())
+      node.SetPointer(Translate(source.GetPointer<void>()));
+  }
+
+  void WriteBlock(const Block& block) const {
+    u8* dest = base + block.offset;
+    switch (block.type) {
+    case Byml::Type::Array: {
+      const auto* items = static_cast<const Node*>(block.source);
+      for (size_t i = 0; i < block.size / sizeof(Node); ++i)
+        WriteNode(items[i], *new (dest + sizeof(Node) * i) Node);
+      break;
+    }
+    case Byml::Type::Hash: {
+      const auto* entries = static_cast<const HashEntry*>(block.source);
+      for (size_t i = 0; i < block.size / sizeof(HashEntry); ++i) {
+        auto* entry = new (dest + sizeof(HashEntry) * i) HashEntry;
+        entry->key_data = static_cast<const char*>(Translate(entries[i].key_data.Get()));
+        entry->key_size = entries[i].key_size;
+        WriteNode(entries[i].value, entry->value);
+      }
+      break;
+    }
+    default:
+      std::memcpy(dest, block.source, block.size);
+      break;
+    }
+  }
+
+  /// Returns the address of the copy of the specified data in the snapshot.
+  const void* Translate(const void* source) const {
+    if (!source)
+      return nullptr;
+    return base + offsets.at(source);
+  }
+
+  size_t data_size = 0;
+  u8* base = nullptr;
+  std::vector<Block> blocks;
+  absl::flat_hash_map<const void*, size_t> offsets;
+};
+
+/// Checks that the nodes of a snapshot only refer to data inside of the snapshot and that
+/// containers do not contain themselves. Containers (identified by their type, items and size)
+/// are only walked the first time they are referenced.
+struct BymlSnapshotValidator {
+  using Node = BymlDocument::Node;
+  using HashEntry = BymlDocument::HashEntry;
+
+  BymlSnapshotValidator(const u8* base, size_t size)
+      : begin{reinterpret_cast<uintptr_t>(base)}, size{size} {}
+
+  void Validate(const Node& root) {
+    CheckNode(root);
+    Enter(root);
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.next == frame.node->m_size) {
+        containers[GetKey(*frame.node)] = true;
+        stack.pop_back();
+        continue;
+      }
+      const size_t i = frame.next++;
+      const Node& child = frame.node->m_type == Byml::Type::Array ?
+                              frame.node->GetPointer<Node>()[i] :
+                              CheckKey(frame.node->GetPointer<HashEntry>()[i]).value;
+      CheckNode(child);
+      Enter(child);
+    }
+  }
+
+private:
+  struct Frame {
+    const Node* node;
+    size_t next;
+  };
+
+  using ContainerKey = std::tuple<Byml::Type, const void*, u32>;
+  static ContainerKey GetKey(const Node& node) {
+    return {node.m_type, node.GetPointer<void>(), node.m_size};
+  }
+
+  bool Contains(const void* ptr, size_t data_size, size_t alignment) const {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    if (!ptr)
+      return data_size == 0;
+    return address >= begin && address % alignment == 0 && address - begin <= size &&
+           data_size <= size - (address - begin);
+  }
+
+  /// Strings (including hash keys) are null-terminated in the arena, and the terminator is
+  /// copied when the document is snapshotted again.
+  bool ContainsString(const void* ptr, size_t length) const {
+    if (!ptr)
+      return length == 0;
+    return Contains(ptr, length + 1, 1) && static_cast<const char*>(ptr)[length] == '\0';
+  }
+
+  const HashEntry& CheckKey(const HashEntry& entry) const {
+    if (!ContainsString(entry.key_data.Get(), entry.key_size))
+      throw InvalidDataError("Invalid snapshot: invalid hash key");
+    return entry;
+  }
+
+  void CheckNode(const Node& node) const {
+    bool valid = true;
+    switch (node.m_type) {
+    case Byml::Type::String:
+      valid = ContainsString(node.GetPointer<void>(), node.m_size);
+      break;
+    case Byml::Type::Binary:
+      valid = Contains(node.GetPointer<void>(), node.m_size, 1);
+      break;
+    case Byml::Type::Array:
+      valid = Contains(node.GetPointer<void>(), sizeof(Node) * node.m_size, alignof(Node));
+      break;
+    case Byml::Type::Hash:
+      valid = Contains(node.GetPointer<void>(), sizeof(HashEntry) * node.m_size,
+                       alignof(HashEntry));
+      break;
+    case Byml::Type::Bool: {
+      // Only 0 and 1 are valid bool representations.
+      u8 value;
+      std::memcpy(&value, &node.m_value, sizeof(value));
+      valid = value <= 1;
+      break;
+    }
+    case Byml::Type::Null:
+    case Byml::Type::Int:
+    case Byml::Type::Float:
+    case Byml::Type::UInt:
+    case Byml::Type::Int64:
+    case Byml::Type::UInt64:
+    case Byml::Type::Double:
+      break;
+    default:
+      valid = false;
+      break;
+    }
+    if (!valid)
+      throw InvalidDataError("Invalid snapshot: invalid node");
+  }
+
+  void Enter(const Node& node) {
+    if ((node.m_type != Byml::Type::Array && node.m_type != Byml::Type::Hash) ||
+        node.m_size == 0) {
+      return;
+    }
+    const auto [it, inserted] = containers.try_emplace(GetKey(node), false);
+    if (inserted) {
+      stack.push_back({&node, 0});
+      return;
+    }
+    // The container is still being walked, so it contains itself.
+    if (!it->second)
+      throw InvalidDataError("Invalid snapshot: recursive container");
+  }
+
+  uintptr_t begin;
+  size_t size;
+  std::vector<Frame> stack;
+  /// Containers that have been entered, and whether they have been fully walked.
+  absl::flat_hash_map<ContainerKey, bool> containers;
+};
+
+std::vector<u8> BymlDocument::ToSnapshot() const {
+  return BymlSnapshotWriter{}.Write(GetRoot());
+}
+
+BymlDocument BymlDocument::FromSnapshot(tcb::span<const u8> data, bool verify_checksum) {
+  SnapshotHeader header;
+  if (data.size() < sizeof(header))
+    throw InvalidDataError("Invalid snapshot: too small");
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != SnapshotMagic)
+    throw InvalidDataError("Invalid snapshot: invalid magic");
+  if (header.byte_order_mark != SnapshotByteOrderMark)
+    throw InvalidDataError("Invalid snapshot: created on a platform with a different byte order");
+  if (header.version != SnapshotVersion || header.node_size != sizeof(Node) ||
+      header.hash_entry_size != sizeof(HashEntry)) {
+    throw InvalidDataError("Invalid snapshot: created by an incompatible version of oead");
+  }
+  if (header.data_size < sizeof(Node) || header.data_size > data.size() - sizeof(header))
+    throw InvalidDataError("Invalid snapshot: truncated data");
+  if (reinterpret_cast<uintptr_t>(data.data()) % alignof(Node) != 0)
+    throw InvalidDataError("Invalid snapshot: data must be 8-byte aligned");
+
+  const u8* base = data.data() + sizeof(header);
+  if (verify_checksum && util::crc32(base, header.data_size) != header.checksum)
+    throw InvalidDataError("Invalid snapshot: checksum mismatch");
+
+  BymlDocument doc;
+  doc.m_root = reinterpret_cast<const Node*>(base);
+  BymlSnapshotValidator{base, header.data_size}.Validate(*doc.m_root);
+  return doc;
+}
+
+size_t BymlDocument::Node::Size() const {
+  if (m_type == Byml::Type::Array || m_type == Byml::Type::Hash)
+    return m_size;
+  throw TypeError("Size: expected Array or Hash node");
+}
+
+tcb::span<const BymlDocument::Node> BymlDocument::Node::GetArray() const {
+  if (m_type != Byml::Type::Array)
+    throw TypeError("GetArray: expected Array");
+  return {GetPointer<Node>(), m_size};
+}
+
+tcb::span<const BymlDocument::HashEntry> BymlDocument::Node::GetHash() const {
+  if (m_type != Byml::Type::Hash)
+    throw TypeError("GetHash: expected Hash");
+  return {GetPointer<HashEntry>(), m_size};
+}
+
+const BymlDocument::Node& BymlDocument::Node::operator[](size_t index) const {
+  const auto array = GetArray();
+  if (index >= array.size())
+    throw std::out_of_range("BymlDocument: array index out of range");
+  return array[index];
+}
+
+const BymlDocument::Node* BymlDocument::Node::Find(std::string_view key) const {
+  const auto hash = GetHash();
+  const auto it = std::lower_bound(hash.begin(), hash.end(), key,
+                                   [](const HashEntry& entry, std::string_view key) {
+                                     return entry.GetKey() < key;
+                                   });
+  if (it == hash.end() || it->GetKey() != key)
+    return nullptr;
+  return &it->value;
+}
+
+const BymlDocument::Node& BymlDocument::Node::operator[](std::string_view key) const {
+  if (const Node* node = Find(key))
+    return *node;
+  throw std::out_of_range("BymlDocument: no such key: " + std::string(key));
+}
+
+std::string_view BymlDocument::Node::GetString() const {
+  if (m_type != Byml::Type::String)
+    throw TypeError("GetString: expected String");
+  return {GetPointer<char>(), m_size};
+}
+
+tcb::span<const u8> BymlDocument::Node::GetBinary() const {
+  if (m_type != Byml::Type::Binary)
+    throw TypeError("GetBinary: expected Binary");
+  return {GetPointer<u8>(), m_size};
+}
+
+Byml BymlDocument::Node::ToScalarByml() const {
+  switch (m_type) {
+  case Byml::Type::Null:
+    return Byml::Null();
+  case Byml::Type::Bool:
+    return m_value.b;
+  case Byml::Type::Int:
+    return S32(m_value.s32_);
+  case Byml::Type::Float:
+    return F32(m_value.f32_);
+  case Byml::Type::UInt:
+    return U32(m_value.u32_);
+  case Byml::Type::Int64:
+    return S64(m_value.s64_);
+  case Byml::Type::UInt64:
+    return U64(m_value.u64_);
+  case Byml::Type::Double:
+    return F64(m_value.f64_);
+  default:
+    throw TypeError("expected a scalar value");
+  }
+}
+
+bool BymlDocument::Node::GetBool() const {
+  return ToScalarByml().GetBool();
+}
+
+s32 BymlDocument::Node::GetInt() const {
+  return ToScalarByml().GetInt();
+}
+
+u32 BymlDocument::Node::GetUInt() const {
+  return ToScalarByml().GetUInt();
+}
+
+f32 BymlDocument::Node::GetFloat() const {
+  return ToScalarByml().GetFloat();
+}
+
+s64 BymlDocument::Node::GetInt64() const {
+  return ToScalarByml().GetInt64();
+}
+
+u64 BymlDocument::Node::GetUInt64() const {
+  return ToScalarByml().GetUInt64();
+}
+
+f64 BymlDocument::Node::GetDouble() const {
+  return ToScalarByml().GetDouble();
+}
+
+Byml BymlDocument::Node::ToByml() const {
+  switch (m_type) {
+  case Byml::Type::String:
+    return Byml{GetString()};
+  case Byml::Type::Binary: {
+    const auto data = GetBinary();
+    return Byml{std::vector<u8>(data.begin(), data.end())};
+  }
+  case Byml::Type::Array: {
+    Byml::Array array;
+    array.reserve(m_size);
+    for (const Node& item : GetArray())
+      array.emplace_back(item.ToByml());
+    return Byml{std::move(array)};
+  }
+  case Byml::Type::Hash: {
+    Byml::Hash hash;
+    for (const HashEntry& entry : GetHash())
+      hash.emplace_hint(hash.end(), std::string(entry.GetKey()), entry.value.ToByml());
+    return Byml{std::move(hash)};
+  }
+  default:
+    return ToScalarByml();
+  }
+}
+
+}  // namespace oead
@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+#include <string>
+
+#include <oead/byml_patch.h>
+#include <oead/byml_query.h>
+#include <oead/byml_view.h>
+#include <oead/util/binary_reader.h>
+#include <oead/util/variant_utils.h>
+#include "byml_res.h"
+
+namespace oead::byml {
+
+namespace {
+
+BymlQuery::Match FindSingleMatch(const BymlView& view, std::string_view path) {
+  auto matches = BymlQuery{path}.ExecuteWithPaths(view);
+  if (matches.size() != 1) {
+    throw std::invalid_argument("Patch: path must match exactly one node (matched " +
+                                std::to_string(matches.size()) + ")");
+  }
+  return std::move(matches[0]);
+}
+
+bool IsPatchableType(Byml::Type type) {
+  switch (type) {
+  case Byml::Type::Bool:
+  case Byml::Type::Int:
+  case Byml::Type::UInt:
+  case Byml::Type::Float:
+  case Byml::Type::Int64:
+  case Byml::Type::UInt64:
+  case Byml::Type::Double:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Overwrite the value of a node. The node must not be shared.
+bool WriteValue(tcb::span<u8> data, const BymlView& view, const BymlView::Node& node,
+                const Byml& value) {
+  // Inline values are stored in the slot itself; long values are stored at the offset
+  // that is stored in the slot.
+  util::SpanWriter writer{data, view.GetEndianness()};
+  writer.Seek(IsLongType(node.GetType()) ? node.GetRawValue() : node.GetSlotOffset());
+  switch (value.GetType()) {
+  case Byml::Type::Bool:
+    writer.Write<u32>(value.GetBool());
+    break;
+  case Byml::Type::Int:
+    writer.Write(value.GetInt());
+    break;
+  case Byml::Type::UInt:
+    writer.Write(value.GetUInt());
+    break;
+  case Byml::Type::Float:
+    writer.Write(value.GetFloat());
+    break;
+  case Byml::Type::Int64:
+    writer.Write(value.GetInt64());
+    break;
+  case Byml::Type::UInt64:
+    writer.Write(value.GetUInt64());
+    break;
+  case Byml::Type::Double:
+    writer.Write(value.GetDouble());
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+InPlacePatcher::InPlacePatcher(tcb::span<u8> data) : m_data{data}, m_view{data} {
+  // Count the references to every container and long value in a single pass.
+  // A container is only walked the first time it is referenced, so deduplicated subtrees
+  // are not walked again.
+  const BymlView::Node root = m_view.GetRoot();
+  if (root.IsNull())
+    return;
+  m_ref_counts[root.GetRawValue()] = 1;
+  std::vector<BymlView::Node> stack{root};
+  while (!stack.empty()) {
+    const BymlView::Node node = stack.back();
+    stack.pop_back();
+    const bool is_hash = node.GetType() == Byml::Type::Hash;
+    for (size_t i = 0, size = node.Size(); i < size; ++i) {
+      const BymlView::Node child = is_hash ? node.GetHashItem(i).second : node[i];
+      const bool is_container = IsContainerType(child.GetType());
+      if (!is_container && !IsLongType(child.GetType()))
+        continue;
+      if (++m_ref_counts[child.GetRawValue()] == 1 && is_container)
+        stack.push_back(child);
+    }
+  }
+}
+
+bool InPlacePatcher::IsShared(const BymlView::Node& node,
+                              const std::vector<BymlQuery::PathComponent>& path) const {
+  const auto is_shared = [&](const BymlView::Node& n) {
+    const auto it = m_ref_counts.find(n.GetRawValue());
+    return it != m_ref_counts.end() && it->second > 1;
+  };
+
+  // The value of a node can be reached through more than one path if the node or one of
+  // its parents has been deduplicated. Inline values are stored in their parent, so only
+  // the parents need to be checked for them.
+  BymlView::Node parent = m_view.GetRoot();
+  for (const auto& component : path) {
+    if (is_shared(parent))
+      return true;
+    parent = util::Match(
+        component, [&](std::string_view key) { return parent[key]; },
+        [&](size_t index) { return parent[index]; });
+  }
+  return IsLongType(node.GetType()) && is_shared(node);
+}
+
+bool InPlacePatcher::TryPatch(std::string_view path, const Byml& value) {
+  const auto match = FindSingleMatch(m_view, path);
+  const BymlView::Node& node = match.node;
+  if (node.GetType() != value.GetType() || !IsPatchableType(value.GetType()))
+    return false;
+  if (IsShared(node, match.path))
+    return false;
+  return WriteValue(m_data, m_view, node, value);
+}
+
+bool TryPatchInPlace(tcb::span<u8> data, std::string_view path, const Byml& value) {
+  return InPlacePatcher{data}.TryPatch(path, value);
+}
+
+bool Patch(std::vector<u8>& data, std::string_view path, Byml value) {
+  if (InPlacePatcher{data}.TryPatch(path, value))
+    return false;
+
+  const BymlView view{data};
+  const auto match = FindSingleMatch(view, path);
+
+  Byml root = Byml::FromBinary(data);
+  Byml* target = &root;
+  for (const auto& component : match.path) {
+    target = util::Match(
+        component,
+        [&](std::string_view key) { return &target->GetHash().find(key)->second; },
+        [&](size_t index) { return &target->GetArray()[index]; });
+  }
+  *target = std::move(value);
+  data = root.ToBinary(view.GetEndianness() == util::Endianness::Big, view.GetVersion());
+  return true;
+}
+
+}  // namespace oead::byml
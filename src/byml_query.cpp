@@ -0,0 +1,339 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <absl/strings/numbers.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <oead/byml_query.h>
+
+namespace oead {
+
+namespace {
+
+class QueryParser {
+public:
+  explicit QueryParser(std::string_view query) : m_query{query} {}
+
+  std::vector<BymlQuery::Step> Parse() {
+    std::vector<BymlQuery::Step> steps;
+    while (!AtEnd()) {
+      if (Peek() == '/') {
+        ++m_pos;
+        // A trailing slash is allowed and ignored.
+        if (AtEnd())
+          break;
+        // A key can be omitted if it is directly followed by a bracketed step.
+        if (Peek() == '[')
+          continue;
+        BymlQuery::Step step{};
+        if (Peek() == '*') {
+          ++m_pos;
+          step.kind = BymlQuery::Step::Kind::Wildcard;
+        } else {
+          step.kind = BymlQuery::Step::Kind::Key;
+          step.key = ParseKey();
+        }
+        steps.push_back(std::move(step));
+      } else if (Peek() == '[') {
+        ++m_pos;
+        steps.push_back(ParseBracketedStep());
+      } else {
+        Fail("expected '/' or '['");
+      }
+    }
+    return steps;
+  }
+
+private:
+  bool AtEnd() const { return m_pos >= m_query.size(); }
+  char Peek() const { return m_query[m_pos]; }
+
+  [[noreturn]] void Fail(std::string_view message) const {
+    throw std::invalid_argument("Invalid query (at position " + std::to_string(m_pos) +
+                                "): " + std::string(message));
+  }
+
+  void SkipSpaces() {
+    while (!AtEnd() && Peek() == ' ')
+      ++m_pos;
+  }
+
+  void Expect(char c) {
+    if (AtEnd() || Peek() != c)
+      Fail(std::string("expected '") + c + "'");
+    ++m_pos;
+  }
+
+  std::string ParseQuotedString() {
+    Expect('"');
+    std::string result;
+    while (true) {
+      if (AtEnd())
+        Fail("unterminated string");
+      const char c = m_query[m_pos++];
+      if (c == '"')
+        return result;
+      if (c == '\\') {
+        if (AtEnd())
+          Fail("unterminated string");
+        result += m_query[m_pos++];
+      } else {
+        result += c;
+      }
+    }
+  }
+
+  /// Parses a bare or quoted key. Bare keys end at '/', '[', ']', '=', '!' or a space.
+  std::string ParseKey() {
+    if (Peek() == '"')
+      return ParseQuotedString();
+    const size_t start = m_pos;
+    while (!AtEnd() && std::string_view("/[]=! ").find(Peek()) == std::string_view::npos)
+      ++m_pos;
+    if (m_pos == start)
+      Fail("expected key");
+    return std::string(m_query.substr(start, m_pos - start));
+  }
+
+  Byml ParseLiteral() {
+    if (Peek() == '"')
+      return Byml{ParseQuotedString()};
+
+    const size_t start = m_pos;
+    while (!AtEnd() && Peek() != ']' && Peek() != ' ')
+      ++m_pos;
+    const std::string_view token = m_query.substr(start, m_pos - start);
+
+    if (token == "true" || token == "false")
+      return Byml{token == "true"};
+    if (token == "null")
+      return Byml::Null();
+    if (s64 value; absl::SimpleAtoi(token, &value))
+      return Byml{S64(value)};
+    if (u64 value; absl::SimpleAtoi(token, &value))
+      return Byml{U64(value)};
+    if (f64 value; absl::SimpleAtod(token, &value))
+      return Byml{F64(value)};
+    m_pos = start;
+    Fail("invalid literal");
+  }
+
+  BymlQuery::Step ParseBracketedStep() {
+    SkipSpaces();
+    if (AtEnd())
+      Fail("unterminated '['");
+
+    BymlQuery::Step step{};
+    if (Peek() >= '0' && Peek() <= '9') {
+      const size_t start = m_pos;
+      while (!AtEnd() && Peek() >= '0' && Peek() <= '9')
+        ++m_pos;
+      step.kind = BymlQuery::Step::Kind::Index;
+      if (!absl::SimpleAtoi(m_query.substr(start, m_pos - start), &step.index))
+        Fail("invalid index");
+    } else {
+      step.key = ParseKey();
+      SkipSpaces();
+      if (m_query.substr(m_pos, 2) == "==")
+        step.kind = BymlQuery::Step::Kind::Equal;
+      else if (m_query.substr(m_pos, 2) == "!=")
+        step.kind = BymlQuery::Step::Kind::NotEqual;
+      else
+        Fail("expected '==' or '!='");
+      m_pos += 2;
+      SkipSpaces();
+      if (AtEnd())
+        Fail("expected literal");
+      step.value = ParseLiteral();
+    }
+    SkipSpaces();
+    Expect(']');
+    return step;
+  }
+
+  std::string_view m_query;
+  size_t m_pos = 0;
+};
+
+bool IntegerEquals(const BymlView::Node& node, s64 value) {
+  switch (node.GetType()) {
+  case Byml::Type::Int:
+    return node.GetInt() == value;
+  case Byml::Type::Int64:
+    return node.GetInt64() == value;
+  case Byml::Type::UInt:
+    return value >= 0 && node.GetUInt() == u64(value);
+  case Byml::Type::UInt64:
+    return value >= 0 && node.GetUInt64() == u64(value);
+  case Byml::Type::Float:
+    return node.GetFloat() == f64(value);
+  case Byml::Type::Double:
+    return node.GetDouble() == f64(value);
+  default:
+    return false;
+  }
+}
+
+bool LiteralEquals(const BymlView::Node& node, const Byml& literal) {
+  switch (literal.GetType()) {
+  case Byml::Type::Null:
+    return node.IsNull();
+  case Byml::Type::String:
+    return node.GetType() == Byml::Type::String && node.GetString() == literal.GetString();
+  case Byml::Type::Bool:
+    return node.GetType() == Byml::Type::Bool && node.GetBool() == literal.GetBool();
+  case Byml::Type::Int64:
+    return IntegerEquals(node, literal.GetInt64());
+  case Byml::Type::UInt64:
+    // Only values that do not fit in a s64 are stored as u64 literals.
+    if (node.GetType() == Byml::Type::UInt64)
+      return node.GetUInt64() == literal.GetUInt64();
+    if (node.GetType() == Byml::Type::Double)
+      return node.GetDouble() == f64(literal.GetUInt64());
+    return false;
+  case Byml::Type::Double:
+    switch (node.GetType()) {
+    case Byml::Type::Int:
+      return f64(node.GetInt()) == literal.GetDouble();
+    case Byml::Type::Int64:
+      return f64(node.GetInt64()) == literal.GetDouble();
+    case Byml::Type::UInt:
+      return f64(node.GetUInt()) == literal.GetDouble();
+    case Byml::Type::UInt64:
+      return f64(node.GetUInt64()) == literal.GetDouble();
+    case Byml::Type::Float:
+      return f64(node.GetFloat()) == literal.GetDouble();
+    case Byml::Type::Double:
+      return node.GetDouble() == literal.GetDouble();
+    default:
+      return false;
+    }
+  default:
+    return false;
+  }
+}
+
+}  // namespace
+
+BymlQuery::BymlQuery(std::string_view query) {
+  if (!query.empty() && query[0] != '/')
+    throw std::invalid_argument("Invalid query: must start with '/'");
+  m_steps = QueryParser{query}.Parse();
+}
+
+std::vector<BymlView::Node> BymlQuery::Execute(const BymlView& view) const {
+  return Execute(view.GetRoot());
+}
+
+std::vector<BymlView::Node> BymlQuery::Execute(const BymlView::Node& node) const {
+  std::vector<BymlView::Node> results;
+  Run<false>(node, [&](const BymlView::Node& match, const auto&) { results.push_back(match); });
+  return results;
+}
+
+std::vector<BymlQuery::Match> BymlQuery::ExecuteWithPaths(const BymlView& view) const {
+  std::vector<Match> results;
+  Run<true>(view.GetRoot(), [&](const BymlView::Node& match, const auto& path) {
+    results.push_back({match, path});
+  });
+  return results;
+}
+
+template <bool TrackPaths, typename Callback>
+void BymlQuery::Run(const BymlView::Node& node, Callback callback) const {
+  const BymlView& view = *node.m_view;
+
+  // Resolve keys to hash key table indices once. If a key is missing from the table,
+  // no hash can possibly contain it.
+  std::vector<std::optional<u32>> key_indices(m_steps.size());
+  for (size_t i = 0; i < m_steps.size(); ++i) {
+    if (m_steps[i].kind != Step::Kind::Wildcard && m_steps[i].kind != Step::Kind::Index)
+      key_indices[i] = view.FindHashKey(m_steps[i].key);
+  }
+
+  std::vector<PathComponent> path;
+
+  const auto match = [&](auto self, const BymlView::Node& current, size_t step_idx) -> void {
+    if (step_idx == m_steps.size()) {
+      callback(current, path);
+      return;
+    }
+
+    const Step& step = m_steps[step_idx];
+    const auto& key_index = key_indices[step_idx];
+    const Byml::Type type = current.GetType();
+    const bool is_array = type == Byml::Type::Array;
+    if (!is_array && type != Byml::Type::Hash)
+      return;
+    const u32 size = current.ReadContainerSize(type);
+
+    const auto visit_child = [&](PathComponent component, const BymlView::Node& child) {
+      if constexpr (TrackPaths)
+        path.push_back(component);
+      self(self, child, step_idx + 1);
+      if constexpr (TrackPaths)
+        path.pop_back();
+    };
+
+    const auto get_child = [&](u32 i) -> std::pair<PathComponent, BymlView::Node> {
+      if (is_array)
+        return {size_t(i), current[i]};
+      return current.GetHashItem(i);
+    };
+
+    switch (step.kind) {
+    case Step::Kind::Key:
+      if (!is_array && key_index) {
+        if (const auto child = current.FindByKeyIndex(size, *key_index))
+          visit_child(view.GetHashKey(*key_index), *child);
+      }
+      break;
+    case Step::Kind::Wildcard:
+      for (u32 i = 0; i < size; ++i) {
+        const auto [component, child] = get_child(i);
+        visit_child(component, child);
+      }
+      break;
+    case Step::Kind::Index:
+      if (is_array && step.index < size)
+        visit_child(step.index, current[step.index]);
+      break;
+    case Step::Kind::Equal:
+    case Step::Kind::NotEqual:
+      if (!key_index)
+        break;
+      for (u32 i = 0; i < size; ++i) {
+        const auto [component, child] = get_child(i);
+        if (child.GetType() != Byml::Type::Hash)
+          continue;
+        const auto value =
+            child.FindByKeyIndex(child.ReadContainerSize(Byml::Type::Hash), *key_index);
+        if (value && LiteralEquals(*value, step.value) == (step.kind == Step::Kind::Equal))
+          visit_child(component, child);
+      }
+      break;
+    }
+  };
+
+  match(match, node, 0);
+}
+
+}  // namespace oead
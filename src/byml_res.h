@@ -0,0 +1,206 @@
+/**
+ * Copyright (C) 2020 leoetlino <leo@leolam.fr>
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <oead/byml.h>
+#include <oead/errors.h>
+#include <oead/types.h>
+#include <oead/util/binary_reader.h>
+
+/// Binary format structures and helpers that are shared by the BYML parser, writer and view.
+namespace oead::byml {
+
+struct ResHeader {
+  /// “BY” (big endian) or “YB” (little endian).
+  std::array<char, 2> magic;
+  /// Format version (2 or 3).
+  u16 version;
+  /// Offset to the hash key table, relative to start (usually 0x010)
+  /// May be 0 if no hash nodes are used. Must be a string table node (0xc2).
+  u32 hash_key_table_offset;
+  /// Offset to the string table, relative to start. May be 0 if no strings are used.
+  /// Must be a string table node (0xc2).
+  u32 string_table_offset;
+  /// Offset to the root node, relative to start. May be 0 if the document is totally empty.
+  /// Must be either an array node (0xc0) or a hash node (0xc1).
+  u32 root_node_offset;
+};
+static_assert(sizeof(ResHeader) == 0x10);
+
+enum class NodeType : u8 {
+  String = 0xa0,
+  Binary = 0xa1,
+  Array = 0xc0,
+  Hash = 0xc1,
+  StringTable = 0xc2,
+  Bool = 0xd0,
+  Int = 0xd1,
+  Float = 0xd2,
+  UInt = 0xd3,
+  Int64 = 0xd4,
+  UInt64 = 0xd5,
+  Double = 0xd6,
+  Null = 0xff,
+};
+
+constexpr NodeType GetNodeType(Byml::Type type) {
+  constexpr std::array map{
+      NodeType::Null, NodeType::String, NodeType::Binary, NodeType::Array,
+      NodeType::Hash, NodeType::Bool,   NodeType::Int,    NodeType::Float,
+      NodeType::UInt, NodeType::Int64,  NodeType::UInt64, NodeType::Double,
+  };
+  return map[u8(type)];
+}
+
+/// Returns the Byml type for a node type, or std::nullopt if the node type is not a value type.
+constexpr std::optional<Byml::Type> GetBymlType(NodeType type) {
+  switch (type) {
+  case NodeType::String:
+    return Byml::Type::String;
+  case NodeType::Binary:
+    return Byml::Type::Binary;
+  case NodeType::Array:
+    return Byml::Type::Array;
+  case NodeType::Hash:
+    return Byml::Type::Hash;
+  case NodeType::Bool:
+    return Byml::Type::Bool;
+  case NodeType::Int:
+    return Byml::Type::Int;
+  case NodeType::Float:
+    return Byml::Type::Float;
+  case NodeType::UInt:
+    return Byml::Type::UInt;
+  case NodeType::Int64:
+    return Byml::Type::Int64;
+  case NodeType::UInt64:
+    return Byml::Type::UInt64;
+  case NodeType::Double:
+    return Byml::Type::Double;
+  case NodeType::Null:
+    return Byml::Type::Null;
+  default:
+    return std::nullopt;
+  }
+}
+
+template <typename T = NodeType>
+constexpr bool IsContainerType(T type) {
+  return type == T::Array || type == T::Hash;
+}
+
+template <typename T = NodeType>
+constexpr bool IsLongType(T type) {
+  return type == T::Int64 || type == T::UInt64 || type == T::Double;
+}
+
+template <typename T = NodeType>
+constexpr bool IsNonInlineType(T type) {
+  return IsContainerType(type) || IsLongType(type) || type == T::Binary;
+}
+
+constexpr bool IsValidVersion(int version) {
+  return 2 <= version && version <= 4;
+}
+
+class StringTableParser {
+public:
+  StringTableParser() = default;
+  StringTableParser(util::BinaryReader& reader, u32 offset) : m_offset{offset} {
+    if (offset == 0)
+      return;
+    const auto type = reader.Read<NodeType>(offset);
+    const auto num_entries = reader.ReadU24();
+    if (!type || *type != NodeType::StringTable || !num_entries)
+      throw InvalidDataError("Invalid string table");
+    m_size = *num_entries;
+  }
+  /// For tables that have already been validated.
+  StringTableParser(u32 offset, u32 size) : m_offset{offset}, m_size{size} {}
+
+  template <typename StringType = std::string>
+  StringType GetString(util::BinaryReader& reader, u32 idx) const {
+    if (idx >= m_size)
+      throw std::out_of_range("Invalid string table entry index");
+
+    const auto rel_offset = reader.Read<u32>(m_offset + 4 + 4 * idx);
+    // This is safe even for idx = N - 1 since the offset array has N+1 elements.
+    const auto next_rel_offset = reader.Read<u32>();
+    if (!rel_offset || !next_rel_offset)
+      throw InvalidDataError("Invalid string table: failed to read offsets");
+    if (*next_rel_offset < *rel_offset)
+      throw InvalidDataError("Invalid string table: inconsistent offsets");
+
+    const size_t max_len = *next_rel_offset - *rel_offset;
+    return reader.ReadString<StringType>(m_offset + *rel_offset, max_len);
+  }
+
+  u32 GetOffset() const { return m_offset; }
+  u32 GetSize() const { return m_size; }
+
+private:
+  u32 m_offset = 0;
+  u32 m_size = 0;
+};
+
+/// A fully decoded string table. Every entry is validated and decoded once,
+/// so that repeated references to the same string are cheap.
+class StringTablePool {
+public:
+  StringTablePool() = default;
+  StringTablePool(util::BinaryReader& reader, u32 offset) {
+    const StringTableParser parser{reader, offset};
+    if (parser.GetSize() == 0)
+      return;
+
+    // The offset array has N+1 elements (the last one is the end of the last string).
+    const auto offsets = reader.ReadArray<u32>(parser.GetSize() + 1, offset + 4);
+    if (!offsets)
+      throw InvalidDataError("Invalid string table: failed to read offsets");
+    m_strings.reserve(parser.GetSize());
+    for (u32 i = 0; i < parser.GetSize(); ++i) {
+      const u32 rel_offset = (*offsets)[i];
+      const u32 next_rel_offset = (*offsets)[i + 1];
+      if (next_rel_offset < rel_offset)
+        throw InvalidDataError("Invalid string table: inconsistent offsets");
+      m_strings.emplace_back(reader.ReadString<std::string_view>(offset + rel_offset,
+                                                                 next_rel_offset - rel_offset));
+    }
+  }
+
+  std::string_view GetString(u32 idx) const {
+    if (idx >= m_strings.size())
+      throw std::out_of_range("Invalid string table entry index");
+    return m_strings[idx];
+  }
+
+  size_t Size() const { return m_strings.size(); }
+
+private:
+  std::vector<std::string_view> m_strings;
+};
+
+}  // namespace oead::byml
@@ -23,7 +23,6 @@
 
 #include <c4/std/string.hpp>
 #include <ryml.hpp>
-#include "../lib/libyaml/include/yaml.h"
 
 #include <oead/byml.h>
 #include <oead/util/iterator_utils.h>
@@ -105,9 +104,10 @@ Byml ParseYamlNode(const c4::yml::NodeRef& node) {
   if (node.is_map()) {
     auto hash = Byml::Hash{};
     for (const auto& child : node) {
-      std::string key{yml::RymlSubstrToStrView(child.key())};
-      Byml value = ParseYamlNode(child);
-      hash.emplace(std::move(key), std::move(value));
+      // Keys are usually sorted already (ToText emits them in order), so hinting at the end
+      // avoids a full tree search for most insertions. Duplicate keys are still ignored.
+      hash.try_emplace(hash.end(), std::string(yml::RymlSubstrToStrView(child.key())),
+                       ParseYamlNode(child));
     }
     return Byml{std::move(hash)};
   }
@@ -122,20 +122,11 @@ Byml ParseYamlNode(const c4::yml::NodeRef& node) {
 }  // namespace byml
 
 Byml Byml::FromText(std::string_view yml_text) {
-  yml::InitRymlIfNeeded();
-  ryml::Tree tree = ryml::parse(yml::StrViewToRymlSubstr(yml_text));
-  return byml::ParseYamlNode(tree.rootref());
+  return byml::ParseYamlNode(yml::ParseIntoThreadLocalTree(yml_text).rootref());
 }
 
 std::string Byml::ToText() const {
-  yml::LibyamlEmitterWithStorage<std::string> emitter;
-  yaml_event_t event;
-
-  yaml_stream_start_event_initialize(&event, YAML_UTF8_ENCODING);
-  emitter.Emit(event);
-
-  yaml_document_start_event_initialize(&event, nullptr, nullptr, nullptr, 1);
-  emitter.Emit(event);
+  yml::Emitter emitter;
 
   const auto emit = [&](auto self, const Byml& node) -> void {
     util::Match(
@@ -147,22 +138,17 @@ std::string Byml::ToText() const {
           emitter.EmitString(encoded, "tag:yaml.org,2002:binary");
         },
         [&](const Array& v) {
-          yaml_event_t event;
-          const auto style = byml::ShouldUseInlineYamlStyle(v) ? YAML_FLOW_SEQUENCE_STYLE :
-                                                                 YAML_BLOCK_SEQUENCE_STYLE;
-          yaml_sequence_start_event_initialize(&event, nullptr, nullptr, 1, style);
-          emitter.Emit(event);
-
+          const auto style = byml::ShouldUseInlineYamlStyle(v) ? yml::Emitter::Style::Flow :
+                                                                 yml::Emitter::Style::Block;
+          emitter.BeginSequence({}, style);
           for (const Byml& item : v)
             self(self, item);
-
-          yaml_sequence_end_event_initialize(&event);
-          emitter.Emit(event);
+          emitter.EndSequence();
         },
         [&](const Hash& v) {
-          const auto style = byml::ShouldUseInlineYamlStyle(v) ? YAML_FLOW_MAPPING_STYLE :
-                                                                 YAML_BLOCK_MAPPING_STYLE;
-          yml::LibyamlEmitter::MappingScope scope{emitter, {}, style};
+          const auto style = byml::ShouldUseInlineYamlStyle(v) ? yml::Emitter::Style::Flow :
+                                                                 yml::Emitter::Style::Block;
+          yml::Emitter::MappingScope scope{emitter, {}, style};
 
           for (const auto& [k, v] : v) {
             emitter.EmitString(k);
@@ -172,19 +158,18 @@ std::string Byml::ToText() const {
         [&](bool v) { emitter.EmitBool(v); },  //
         [&](S32 v) { emitter.EmitInt(v); },    //
         [&](F32 v) { emitter.EmitFloat(v); },  //
-        [&](U32 v) { emitter.EmitScalar(absl::StrFormat("0x%08x", v), false, false, "!u"); },
+        [&](U32 v) {
+          char buffer[16];
+          const int size = absl::SNPrintF(buffer, sizeof(buffer), "0x%08x", v);
+          emitter.EmitScalar({buffer, size_t(size)}, false, false, "!u");
+        },
         [&](S64 v) { emitter.EmitInt(v, "!l"); },   //
         [&](U64 v) { emitter.EmitInt(v, "!ul"); },  //
         [&](F64 v) { emitter.EmitDouble(v, "!f64"); });
   };
   emit(emit, *this);
 
-  yaml_document_end_event_initialize(&event, 1);
-  emitter.Emit(event);
-
-  yaml_stream_end_event_initialize(&event);
-  emitter.Emit(event);
-  return std::move(emitter.GetOutput());
+  return emitter.Finish();
 }
 
 }  // namespace oead
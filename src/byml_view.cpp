@@ -0,0 +1,349 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <absl/container/inlined_vector.h>
+#include <cstddef>
+#include <string>
+
+#include <oead/byml_view.h>
+#include <oead/errors.h>
+#include <oead/util/align.h>
+#include <oead/util/bit_utils.h>
+#include "byml_res.h"
+
+namespace oead {
+
+BymlView::BymlView(tcb::span<const u8> data) {
+  if (data.size() < sizeof(byml::ResHeader))
+    throw InvalidDataError("Invalid header");
+
+  const bool is_big_endian = data[0] == 'B' && data[1] == 'Y';
+  const bool is_little_endian = data[0] == 'Y' && data[1] == 'B';
+  if (!is_big_endian && !is_little_endian)
+    throw InvalidDataError("Invalid magic");
+
+  m_reader = {data, is_big_endian ? util::Endianness::Big : util::Endianness::Little};
+
+  m_version = *m_reader.Read<u16>(offsetof(byml::ResHeader, version));
+  if (!byml::IsValidVersion(m_version))
+    throw InvalidDataError("Unexpected version");
+
+  m_hash_key_table_offset = *m_reader.Read<u32>(offsetof(byml::ResHeader, hash_key_table_offset));
+  m_num_hash_keys = byml::StringTableParser(m_reader, m_hash_key_table_offset).GetSize();
+  m_string_table_offset = *m_reader.Read<u32>(offsetof(byml::ResHeader, string_table_offset));
+  m_num_strings = byml::StringTableParser(m_reader, m_string_table_offset).GetSize();
+  m_root_node_offset = *m_reader.Read<u32>(offsetof(byml::ResHeader, root_node_offset));
+}
+
+BymlView::Node BymlView::GetRoot() const {
+  constexpr u32 slot_offset = offsetof(byml::ResHeader, root_node_offset);
+  if (m_root_node_offset == 0)
+    return Node{this, Byml::Type::Null, 0, slot_offset};
+
+  const auto type = Reader().Read<byml::NodeType>(m_root_node_offset);
+  if (!type || !byml::IsContainerType(*type))
+    throw InvalidDataError("Invalid root node: must be array or hash");
+  return Node{this, *byml::GetBymlType(*type), m_root_node_offset, slot_offset};
+}
+
+void BymlView::Visit(BymlVisitor& visitor) const {
+  using Action = BymlVisitor::Action;
+
+  struct Frame {
+    Node node;
+    u32 size;
+    u32 index;
+  };
+  absl::InlinedVector<Frame, 16> stack;
+
+  // Returns false if the walk should be stopped.
+  const auto visit = [&](std::string_view key, const Node& node) {
+    if (node.m_type != Byml::Type::Array && node.m_type != Byml::Type::Hash)
+      return visitor.Scalar(key, node) != Action::Stop;
+
+    const u32 size = node.ReadContainerSize(node.m_type);
+    const Action action = node.m_type == Byml::Type::Array ? visitor.BeginArray(key, size) :
+                                                             visitor.BeginHash(key, size);
+    if (action == Action::Continue)
+      stack.push_back({node, size, 0});
+    return action != Action::Stop;
+  };
+
+  if (!visit({}, GetRoot()))
+    return;
+
+  auto reader = Reader();
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    if (frame.index == frame.size) {
+      stack.pop_back();
+      if (visitor.End() == Action::Stop)
+        return;
+      continue;
+    }
+
+    // Note that visiting a child may invalidate the frame.
+    const Node parent = frame.node;
+    const u32 i = frame.index++;
+    if (parent.m_type == Byml::Type::Array) {
+      const auto raw_type = reader.Read<u8>(parent.m_raw_value + 4 + i);
+      if (!raw_type)
+        throw InvalidDataError("Invalid array node: failed to read type");
+      const u32 values_offset = parent.m_raw_value + 4 + util::AlignUp(frame.size, 4);
+      if (!visit({}, parent.ReadChild(*raw_type, values_offset + 4 * i)))
+        return;
+    } else {
+      const u32 entry_offset = parent.m_raw_value + 4 + 8 * i;
+      const auto key_index = reader.ReadU24(entry_offset);
+      const auto raw_type = reader.Read<u8>();
+      if (!key_index || !raw_type)
+        throw InvalidDataError("Invalid hash node: failed to read entry");
+      if (!visit(GetHashKey(*key_index), parent.ReadChild(*raw_type, entry_offset + 4)))
+        return;
+    }
+  }
+}
+
+std::string_view BymlView::GetHashKey(u32 index) const {
+  auto reader = Reader();
+  return byml::StringTableParser(m_hash_key_table_offset, m_num_hash_keys)
+      .GetString<std::string_view>(reader, index);
+}
+
+std::string_view BymlView::GetStringTableEntry(u32 index) const {
+  auto reader = Reader();
+  return byml::StringTableParser(m_string_table_offset, m_num_strings)
+      .GetString<std::string_view>(reader, index);
+}
+
+std::optional<u32> BymlView::FindHashKey(std::string_view key) const {
+  u32 a = 0;
+  u32 b = m_num_hash_keys;
+  while (a < b) {
+    const u32 m = a + (b - a) / 2;
+    const int cmp = GetHashKey(m).compare(key);
+    if (cmp == 0)
+      return m;
+    if (cmp < 0)
+      a = m + 1;
+    else
+      b = m;
+  }
+  return std::nullopt;
+}
+
+u32 BymlView::Node::ReadContainerSize(Byml::Type expected_type) const {
+  if (m_type != expected_type) {
+    throw TypeError(expected_type == Byml::Type::Array ? "expected Array node" :
+                                                         "expected Hash node");
+  }
+  auto reader = m_view->Reader();
+  const auto type = reader.Read<byml::NodeType>(m_raw_value);
+  const auto num_entries = reader.ReadU24();
+  if (!type || !num_entries || byml::GetBymlType(*type) != m_type)
+    throw InvalidDataError("Invalid container node");
+  return *num_entries;
+}
+
+BymlView::Node BymlView::Node::ReadChild(u8 raw_type, u32 slot_offset) const {
+  const auto type = byml::GetBymlType(byml::NodeType(raw_type));
+  if (!type)
+    throw InvalidDataError("Invalid node type");
+  const auto raw_value = m_view->Reader().Read<u32>(slot_offset);
+  if (!raw_value)
+    throw InvalidDataError("Invalid node: failed to read value");
+  return Node{m_view, *type, *raw_value, slot_offset};
+}
+
+size_t BymlView::Node::Size() const {
+  if (m_type == Byml::Type::Array || m_type == Byml::Type::Hash)
+    return ReadContainerSize(m_type);
+  throw TypeError("Size: expected Array or Hash node");
+}
+
+BymlView::Node BymlView::Node::operator[](size_t index) const {
+  const u32 size = ReadContainerSize(Byml::Type::Array);
+  if (index >= size)
+    throw std::out_of_range("BymlView: array index out of range");
+
+  const auto raw_type = m_view->Reader().Read<u8>(m_raw_value + 4 + index);
+  if (!raw_type)
+    throw InvalidDataError("Invalid array node: failed to read type");
+  const u32 values_offset = m_raw_value + 4 + util::AlignUp(size, 4);
+  return ReadChild(*raw_type, values_offset + 4 * index);
+}
+
+std::pair<std::string_view, BymlView::Node> BymlView::Node::GetHashItem(size_t index) const {
+  const u32 size = ReadContainerSize(Byml::Type::Hash);
+  if (index >= size)
+    throw std::out_of_range("BymlView: hash index out of range");
+
+  auto reader = m_view->Reader();
+  const u32 entry_offset = m_raw_value + 4 + 8 * index;
+  const auto key_index = reader.ReadU24(entry_offset);
+  const auto raw_type = reader.Read<u8>();
+  if (!key_index || !raw_type)
+    throw InvalidDataError("Invalid hash node: failed to read entry");
+  return {m_view->GetHashKey(*key_index), ReadChild(*raw_type, entry_offset + 4)};
+}
+
+std::optional<BymlView::Node> BymlView::Node::Find(std::string_view key) const {
+  const u32 size = ReadContainerSize(Byml::Type::Hash);
+  const auto key_index = m_view->FindHashKey(key);
+  if (!key_index)
+    return std::nullopt;
+  return FindByKeyIndex(size, *key_index);
+}
+
+std::optional<BymlView::Node> BymlView::Node::FindByKeyIndex(u32 size, u32 key_index) const {
+  // Entries are sorted by key index, which is the same as sorting by key.
+  auto reader = m_view->Reader();
+  u32 a = 0;
+  u32 b = size;
+  while (a < b) {
+    const u32 m = a + (b - a) / 2;
+    const u32 entry_offset = m_raw_value + 4 + 8 * m;
+    const auto entry_key_index = reader.ReadU24(entry_offset);
+    if (!entry_key_index)
+      throw InvalidDataError("Invalid hash node: failed to read entry");
+    if (*entry_key_index == key_index) {
+      const auto raw_type = reader.Read<u8>();
+      if (!raw_type)
+        throw InvalidDataError("Invalid hash node: failed to read entry");
+      return ReadChild(*raw_type, entry_offset + 4);
+    }
+    if (*entry_key_index < key_index)
+      a = m + 1;
+    else
+      b = m;
+  }
+  return std::nullopt;
+}
+
+BymlView::Node BymlView::Node::operator[](std::string_view key) const {
+  if (auto node = Find(key))
+    return *node;
+  throw std::out_of_range("BymlView: no such key: " + std::string(key));
+}
+
+std::string_view BymlView::Node::GetString() const {
+  if (m_type != Byml::Type::String)
+    throw TypeError("GetString: expected String");
+  return m_view->GetStringTableEntry(m_raw_value);
+}
+
+tcb::span<const u8> BymlView::Node::GetBinary() const {
+  if (m_type != Byml::Type::Binary)
+    throw TypeError("GetBinary: expected Binary");
+  const auto data = m_view->GetData();
+  const auto size = m_view->Reader().Read<u32>(m_raw_value);
+  if (!size || data.size() - m_raw_value - 4 < *size)
+    throw InvalidDataError("Invalid binary node");
+  return data.subspan(m_raw_value + 4, *size);
+}
+
+Byml BymlView::Node::ToScalarByml() const {
+  const auto read_long_value = [this] {
+    const auto value = m_view->Reader().Read<u64>(m_raw_value);
+    if (!value)
+      throw InvalidDataError("Invalid value node: failed to read long value");
+    return *value;
+  };
+
+  switch (m_type) {
+  case Byml::Type::Null:
+    return Byml::Null();
+  case Byml::Type::Bool:
+    return m_raw_value != 0;
+  case Byml::Type::Int:
+    return S32(m_raw_value);
+  case Byml::Type::Float:
+    return F32(util::BitCast<f32>(m_raw_value));
+  case Byml::Type::UInt:
+    return U32(m_raw_value);
+  case Byml::Type::Int64:
+    return S64(read_long_value());
+  case Byml::Type::UInt64:
+    return U64(read_long_value());
+  case Byml::Type::Double:
+    return F64(util::BitCast<f64>(read_long_value()));
+  default:
+    throw TypeError("expected a scalar value");
+  }
+}
+
+bool BymlView::Node::GetBool() const {
+  return ToScalarByml().GetBool();
+}
+
+s32 BymlView::Node::GetInt() const {
+  return ToScalarByml().GetInt();
+}
+
+u32 BymlView::Node::GetUInt() const {
+  return ToScalarByml().GetUInt();
+}
+
+f32 BymlView::Node::GetFloat() const {
+  return ToScalarByml().GetFloat();
+}
+
+s64 BymlView::Node::GetInt64() const {
+  return ToScalarByml().GetInt64();
+}
+
+u64 BymlView::Node::GetUInt64() const {
+  return ToScalarByml().GetUInt64();
+}
+
+f64 BymlView::Node::GetDouble() const {
+  return ToScalarByml().GetDouble();
+}
+
+Byml BymlView::Node::ToByml() const {
+  switch (m_type) {
+  case Byml::Type::String:
+    return Byml{GetString()};
+  case Byml::Type::Binary: {
+    const auto data = GetBinary();
+    return Byml{std::vector<u8>(data.begin(), data.end())};
+  }
+  case Byml::Type::Array: {
+    const size_t size = Size();
+    Byml::Array array;
+    array.reserve(size);
+    for (size_t i = 0; i < size; ++i)
+      array.emplace_back((*this)[i].ToByml());
+    return Byml{std::move(array)};
+  }
+  case Byml::Type::Hash: {
+    const size_t size = Size();
+    Byml::Hash hash;
+    for (size_t i = 0; i < size; ++i) {
+      auto [key, node] = GetHashItem(i);
+      hash.emplace_hint(hash.end(), std::string(key), node.ToByml());
+    }
+    return Byml{std::move(hash)};
+  }
+  default:
+    return ToScalarByml();
+  }
+}
+
+}  // namespace oead
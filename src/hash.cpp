@@ -0,0 +1,284 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cstring>
+
+#include <oead/util/hash.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OEAD_CRC32_PCLMUL
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && (defined(__clang__) || defined(__GNUC__)) &&                        \
+    (defined(__linux__) || defined(__APPLE__))
+#define OEAD_CRC32_ARMV8
+#if !defined(__ARM_FEATURE_CRC32) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC target("arch=armv8-a+crc")
+#define OEAD_CRC32_ARMV8_POP_OPTIONS
+#endif
+#include <arm_acle.h>
+#ifdef OEAD_CRC32_ARMV8_POP_OPTIONS
+#pragma GCC pop_options
+#endif
+#ifdef __linux__
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+namespace oead::util::detail {
+
+namespace {
+
+using SlicingTables = std::array<std::array<u32, 256>, 16>;
+
+/// Tables for slicing-by-16: entry [k][b] is the CRC of byte b followed by k zero bytes.
+constexpr SlicingTables MakeSlicingTables() {
+  SlicingTables tables{};
+  for (u32 i = 0; i < 256; ++i) {
+    u32 crc = i;
+    for (int j = 0; j < 8; ++j)
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    tables[0][i] = crc;
+  }
+  for (size_t k = 1; k < tables.size(); ++k) {
+    for (u32 i = 0; i < 256; ++i)
+      tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+  }
+  return tables;
+}
+
+constexpr SlicingTables s_tables = MakeSlicingTables();
+
+/// Reads a little endian u32. Compiles to a single load on little endian platforms.
+inline u32 Load32(const u8* data) {
+  return u32(data[0]) | u32(data[1]) << 8 | u32(data[2]) << 16 | u32(data[3]) << 24;
+}
+
+/// Updates a (non-inverted) CRC with slicing-by-16, then slicing-by-8, then byte by byte.
+u32 UpdateCrc32Sliced(u32 crc, const u8* data, size_t size) {
+  const auto& t = s_tables;
+  for (; size >= 16; data += 16, size -= 16) {
+    const u32 a = Load32(data) ^ crc;
+    const u32 b = Load32(data + 4);
+    const u32 c = Load32(data + 8);
+    const u32 d = Load32(data + 12);
+    crc = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^ t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24] ^
+          t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^ t[9][(b >> 16) & 0xFF] ^ t[8][b >> 24] ^
+          t[7][c & 0xFF] ^ t[6][(c >> 8) & 0xFF] ^ t[5][(c >> 16) & 0xFF] ^ t[4][c >> 24] ^
+          t[3][d & 0xFF] ^ t[2][(d >> 8) & 0xFF] ^ t[1][(d >> 16) & 0xFF] ^ t[0][d >> 24];
+  }
+  if (size >= 8) {
+    const u32 a = Load32(data) ^ crc;
+    const u32 b = Load32(data + 4);
+    crc = t[7][a & 0xFF] ^ t[6][(a >> 8) & 0xFF] ^ t[5][(a >> 16) & 0xFF] ^ t[4][a >> 24] ^
+          t[3][b & 0xFF] ^ t[2][(b >> 8) & 0xFF] ^ t[1][(b >> 16) & 0xFF] ^ t[0][b >> 24];
+    data += 8;
+    size -= 8;
+  }
+  for (; size != 0; ++data, --size)
+    crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+  return crc;
+}
+
+u32 Crc32Sliced(const void* data, size_t size) {
+  return ~UpdateCrc32Sliced(0xFFFFFFFF, static_cast<const u8*>(data), size);
+}
+
+#ifdef OEAD_CRC32_PCLMUL
+#ifdef _MSC_VER
+#define OEAD_TARGET_PCLMUL
+#else
+#define OEAD_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+
+bool HasPclmul() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  const unsigned ecx = info[2];
+#else
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return false;
+#endif
+  constexpr unsigned PclmulBit = 1 << 1;
+  constexpr unsigned Sse41Bit = 1 << 19;
+  return (ecx & PclmulBit) && (ecx & Sse41Bit);
+}
+
+OEAD_TARGET_PCLMUL inline __m128i LoadBlock(const u8* data) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+/// Folds `x` over 128 bits (with the given constants) and adds the next block.
+OEAD_TARGET_PCLMUL inline __m128i Fold(__m128i x, __m128i k, __m128i next) {
+  const __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+  return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), next), lo);
+}
+
+/// Folds 16-byte blocks with carry-less multiplications and reduces the result with a Barrett
+/// reduction ("Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction",
+/// Gopal et al.). `size` must be a multiple of 16 and at least 64.
+OEAD_TARGET_PCLMUL u32 UpdateCrc32Pclmul(u32 crc, const u8* data, size_t size) {
+  alignas(16) static constexpr u64 k1k2[] = {0x0154442bd4, 0x01c6e41596};
+  alignas(16) static constexpr u64 k3k4[] = {0x01751997d0, 0x00ccaa009e};
+  alignas(16) static constexpr u64 k5k0[] = {0x0163cd6124, 0x0000000000};
+  alignas(16) static constexpr u64 poly[] = {0x01db710641, 0x01f7011641};
+
+  __m128i x1 = _mm_xor_si128(LoadBlock(data), _mm_cvtsi32_si128(int(crc)));
+  __m128i x2 = LoadBlock(data + 0x10);
+  __m128i x3 = LoadBlock(data + 0x20);
+  __m128i x4 = LoadBlock(data + 0x30);
+  data += 64;
+  size -= 64;
+
+  // Fold 64 bytes at a time.
+  __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+  for (; size >= 64; data += 64, size -= 64) {
+    x1 = Fold(x1, k, LoadBlock(data));
+    x2 = Fold(x2, k, LoadBlock(data + 0x10));
+    x3 = Fold(x3, k, LoadBlock(data + 0x20));
+    x4 = Fold(x4, k, LoadBlock(data + 0x30));
+  }
+
+  // Fold into 128 bits, then fold the remaining 16-byte blocks.
+  k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+  x1 = Fold(x1, k, x2);
+  x1 = Fold(x1, k, x3);
+  x1 = Fold(x1, k, x4);
+  for (; size >= 16; data += 16, size -= 16)
+    x1 = Fold(x1, k, LoadBlock(data));
+
+  // Fold 128 bits to 64 bits.
+  const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+  x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00), x2);
+
+  // Barrett reduction to 32 bits.
+  k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return u32(_mm_extract_epi32(x1, 1));
+}
+
+u32 Crc32Pclmul(const void* data_, size_t size) {
+  auto* data = static_cast<const u8*>(data_);
+  u32 crc = 0xFFFFFFFF;
+  // Short inputs (such as most names) are faster to hash with tables.
+  if (size >= 64) {
+    const size_t folded_size = size & ~size_t(15);
+    crc = UpdateCrc32Pclmul(crc, data, folded_size);
+    data += folded_size;
+    size -= folded_size;
+  }
+  return ~UpdateCrc32Sliced(crc, data, size);
+}
+#endif
+
+#ifdef OEAD_CRC32_ARMV8
+#if defined(__ARM_FEATURE_CRC32)
+#define OEAD_TARGET_CRC
+#elif defined(__clang__)
+#define OEAD_TARGET_CRC __attribute__((target("crc")))
+#else
+#define OEAD_TARGET_CRC __attribute__((target("arch=armv8-a+crc")))
+#endif
+
+bool HasArmCrc32() {
+#if defined(__ARM_FEATURE_CRC32) || defined(__APPLE__)
+  return true;
+#else
+  return getauxval(AT_HWCAP) & HWCAP_CRC32;
+#endif
+}
+
+OEAD_TARGET_CRC u32 Crc32Armv8(const void* data_, size_t size) {
+  auto* data = static_cast<const u8*>(data_);
+  u32 crc = 0xFFFFFFFF;
+  for (; size >= 8; data += 8, size -= 8) {
+    u64 value;
+    std::memcpy(&value, data, sizeof(value));
+    crc = __crc32d(crc, value);
+  }
+  if (size >= 4) {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    crc = __crc32w(crc, value);
+    data += 4;
+    size -= 4;
+  }
+  for (; size != 0; ++data, --size)
+    crc = __crc32b(crc, *data);
+  return ~crc;
+}
+#endif
+
+using Crc32Fn = u32 (*)(const void* data, size_t size);
+
+/// Checks an implementation against the reference implementation.
+bool IsValidCrc32Impl(Crc32Fn fn) {
+  std::array<u8, 1024> data{};
+  u32 state = 1;
+  for (u8& byte : data) {
+    state = state * 1103515245 + 12345;
+    byte = u8(state >> 16);
+  }
+  for (size_t size : {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 63, 64, 65, 79, 127, 128, 200, 1024}) {
+    for (size_t offset : {0, 1, 3}) {
+      const size_t n = std::min(size, data.size() - offset);
+      if (fn(data.data() + offset, n) != Crc32Reference(data.data() + offset, n))
+        return false;
+    }
+  }
+  return true;
+}
+
+Crc32Fn SelectCrc32Impl() {
+#ifdef OEAD_CRC32_PCLMUL
+  if (HasPclmul() && IsValidCrc32Impl(Crc32Pclmul))
+    return Crc32Pclmul;
+#endif
+#ifdef OEAD_CRC32_ARMV8
+  if (HasArmCrc32() && IsValidCrc32Impl(Crc32Armv8))
+    return Crc32Armv8;
+#endif
+  return Crc32Sliced;
+}
+
+}  // namespace
+
+u32 Crc32Runtime(const void* data, size_t size) {
+  static const Crc32Fn s_impl = SelectCrc32Impl();
+  return s_impl(data, size);
+}
+
+}  // namespace oead::util::detail
@@ -38,8 +38,15 @@ namespace oead::aamp {
 
 /// A table of names that is used to recover original names in binary parameter archives
 /// which store only name hashes.
+///
+/// GetName and AddName may be called concurrently from several threads. The other members
+/// (names, numbered_names, AddNameReference...) are meant to be set up before the table is
+/// shared and are not thread-safe.
 struct NameTable {
   NameTable(bool with_botw_strings = false);
+  NameTable(const NameTable& other);
+  NameTable& operator=(const NameTable& other);
+  ~NameTable();
 
   /// Tries to guess the name that is associated with the given hash and index
   /// (of the parameter / object / list in its parent).
@@ -64,15 +71,35 @@ struct NameTable {
 
   /// Hash to name map. The strings are only references.
   absl::flat_hash_map<u32, std::string_view> names;
-  /// Hash to name map. The strings are owned.
-  absl::flat_hash_map<u32, std::string> owned_names;
   /// List of numbered names (i.e. names that contain a printf specifier for the index).
   std::vector<std::string_view> numbered_names;
+
+  /// Numbered names are looked up in a precomputed hash index for indices below this limit.
+  /// The index is built on first use (or loaded by LoadNumberedNameIndex) and is shared by
+  /// copies of this table, so numbered_names and this limit must not be changed afterwards.
+  int numbered_name_index_limit = 256;
+
+  /// Serialize the numbered name index (building it if necessary) so that it can be cached.
+  std::vector<u8> SaveNumberedNameIndex() const;
+  /// Use a numbered name index that was serialized by SaveNumberedNameIndex instead of
+  /// building it. Has no effect if the index has already been built.
+  /// \return false if the index was not loaded (e.g. because it is out of date).
+  /// Throws InvalidDataError if the data is corrupted.
+  bool LoadNumberedNameIndex(tcb::span<const u8> data);
+
+private:
+  struct LearnedNames;
+  struct NumberedNameIndex;
+  const NumberedNameIndex& GetNumberedNameIndex() const;
+
+  /// Names that were added by AddName (or guessed by GetName). The strings are owned.
+  std::unique_ptr<LearnedNames> m_learned_names;
+  std::shared_ptr<NumberedNameIndex> m_numbered_name_index;
 };
 
 /// Returns the default instance of the name table, which is automatically populated with
 /// Breath of the Wild strings.
-/// Initialised on first use.
+/// Initialised on first use. Names can be looked up from several threads at the same time.
 NameTable& GetDefaultNameTable();
 
 /// Parameter structure name. This is a wrapper around a CRC32 hash.
@@ -117,21 +144,29 @@ public:
     StringRef,
   };
 
-  using Value =
-      util::Variant<Type, bool, float, int, Vector2f, Vector3f, Vector4f, Color4f,
-                    std::unique_ptr<FixedSafeString<32>>, std::unique_ptr<FixedSafeString<64>>,
-                    std::unique_ptr<std::array<Curve, 1>>, std::unique_ptr<std::array<Curve, 2>>,
-                    std::unique_ptr<std::array<Curve, 3>>, std::unique_ptr<std::array<Curve, 4>>,
-                    std::unique_ptr<std::vector<int>>, std::unique_ptr<std::vector<float>>,
-                    std::unique_ptr<FixedSafeString<256>>, Quatf, U32,
-                    std::unique_ptr<std::vector<u32>>, std::unique_ptr<std::vector<u8>>,
-                    std::unique_ptr<std::string>>;
+  /// Strings that are shorter than 16 bytes are stored inline.
+  using String = CompactString<16>;
+
+  using Value = util::Variant<Type, bool, float, int, Vector2f, Vector3f, Vector4f, Color4f,
+                              FixedSafeString<32>, FixedSafeString<64>,
+                              std::unique_ptr<std::array<Curve, 1>>,
+                              std::unique_ptr<std::array<Curve, 2>>,
+                              std::unique_ptr<std::array<Curve, 3>>,
+                              std::unique_ptr<std::array<Curve, 4>>,
+                              std::unique_ptr<std::vector<int>>,
+                              std::unique_ptr<std::vector<float>>, FixedSafeString<256>, Quatf,
+                              U32, std::unique_ptr<std::vector<u32>>,
+                              std::unique_ptr<std::vector<u8>>, String>;
 
   Parameter() = default;
   Parameter(const Parameter& other) { *this = other; }
   Parameter(Parameter&& other) noexcept { *this = std::move(other); }
   template <typename T, std::enable_if_t<std::is_constructible_v<Value, T>>* = nullptr>
   Parameter(T value) : m_value{std::move(value)} {}
+  template <typename T,
+            std::enable_if_t<!std::is_constructible_v<Value, T> &&
+                             std::is_convertible_v<const T&, std::string_view>>* = nullptr>
+  Parameter(const T& value) : m_value{String(value)} {}
   Parameter(F32 value) : m_value{static_cast<f32>(value)} {}
   Parameter& operator=(const Parameter& other) = default;
   Parameter& operator=(Parameter&& other) noexcept = default;
@@ -219,7 +254,11 @@ struct ParameterIO : ParameterList {
   /// Serialize the ParameterIO to a binary parameter archive.
   std::vector<u8> ToBinary() const;
   /// Serialize the ParameterIO to a YAML representation.
-  std::string ToText() const;
+  ///
+  /// If num_threads is not 1, the lists in param_root are emitted in parallel using up to
+  /// num_threads threads (0 means one thread per hardware thread). The output is identical to
+  /// that of a serial emission.
+  std::string ToText(size_t num_threads = 1) const;
 };
 
 }  // namespace oead::aamp
@@ -0,0 +1,181 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <nonstd/span.h>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <oead/aamp.h>
+#include <oead/types.h>
+#include <oead/util/arena.h>
+
+namespace oead::aamp {
+
+/// Immutable parameter IO whose lists, objects and parameters are stored in flat tables and
+/// referred to by integer IDs.
+///
+/// Strings, curves and buffers are stored in an arena that is owned by the parameter IO, so
+/// building one requires very few allocations and destroying it is nearly free. The children
+/// of a list (or the parameters of an object) have consecutive IDs, and children are looked up
+/// by name hash in lookup tables that are sorted by hash.
+class FlatParameterIO {
+public:
+  /// Index of a list, object or parameter in the corresponding table.
+  using Id = u32;
+  /// ID of the root list (param_root).
+  static constexpr Id RootListId = 0;
+
+  struct ListEntry {
+    Name name{u32(0)};
+    /// Child lists have IDs [lists_begin, lists_begin + num_lists).
+    Id lists_begin = 0;
+    u32 num_lists = 0;
+    /// Child objects have IDs [objects_begin, objects_begin + num_objects).
+    Id objects_begin = 0;
+    u32 num_objects = 0;
+  };
+
+  struct ObjectEntry {
+    Name name{u32(0)};
+    /// Parameters have IDs [parameters_begin, parameters_begin + num_parameters).
+    Id parameters_begin = 0;
+    u32 num_parameters = 0;
+  };
+
+  class ParameterEntry {
+  public:
+    Name GetName() const { return m_name; }
+    Parameter::Type GetType() const { return m_type; }
+
+    // These getters throw a TypeError if the parameter has a different type.
+
+    bool GetBool() const;
+    f32 GetF32() const;
+    int GetInt() const;
+    u32 GetU32() const;
+    Vector2f GetVec2() const;
+    Vector3f GetVec3() const;
+    Vector4f GetVec4() const;
+    Color4f GetColor() const;
+    Quatf GetQuat() const;
+    /// Get the value of any string parameter.
+    std::string_view GetString() const;
+    /// Get the curves of a Curve1, Curve2, Curve3 or Curve4 parameter.
+    tcb::span<const Curve> GetCurves() const;
+    tcb::span<const int> GetBufferInt() const;
+    tcb::span<const f32> GetBufferF32() const;
+    tcb::span<const u32> GetBufferU32() const;
+    tcb::span<const u8> GetBufferBinary() const;
+
+    /// Convert the parameter to a Parameter.
+    Parameter ToParameter() const;
+
+  private:
+    friend struct FlatParameterIOBuilder;
+
+    template <typename T>
+    T GetValue(Parameter::Type type) const;
+    template <typename T>
+    tcb::span<const T> GetData(Parameter::Type type) const;
+
+    Name m_name{u32(0)};
+    Parameter::Type m_type = Parameter::Type::Bool;
+    /// Number of elements (curves and buffers) or bytes (strings) that are stored in the arena.
+    u32 m_size = 0;
+    union {
+      /// Scalar and vector values.
+      std::array<u8, 16> value;
+      /// Strings, curves and buffers.
+      const void* data;
+    } m_value{};
+  };
+
+  FlatParameterIO(FlatParameterIO&&) noexcept = default;
+  FlatParameterIO& operator=(FlatParameterIO&&) noexcept = default;
+
+  /// Load a parameter IO from a binary parameter archive.
+  static FlatParameterIO FromBinary(tcb::span<const u8> data);
+  /// Build a flat parameter IO from a ParameterIO.
+  static FlatParameterIO FromParameterIO(const ParameterIO& pio);
+
+  /// Convert to a ParameterIO.
+  ParameterIO ToParameterIO() const;
+  /// Serialize to a binary parameter archive.
+  std::vector<u8> ToBinary() const { return ToParameterIO().ToBinary(); }
+
+  /// Data version (see ParameterIO::version).
+  u32 GetVersion() const { return m_version; }
+  /// Data type identifier (see ParameterIO::type).
+  std::string_view GetType() const { return m_type; }
+
+  /// Get a list, object or parameter by ID. Throws std::out_of_range if the ID is invalid.
+  const ListEntry& ListAt(Id id) const;
+  const ObjectEntry& ObjectAt(Id id) const;
+  const ParameterEntry& ParameterAt(Id id) const;
+
+  tcb::span<const ListEntry> GetLists() const { return m_lists; }
+  tcb::span<const ObjectEntry> GetObjects() const { return m_objects; }
+  tcb::span<const ParameterEntry> GetParameters() const { return m_parameters; }
+
+  /// Find a child list of a list by name.
+  std::optional<Id> FindList(Id list, Name name) const;
+  /// Find a child object of a list by name.
+  std::optional<Id> FindObject(Id list, Name name) const;
+  /// Find a parameter of an object by name.
+  std::optional<Id> FindParameter(Id object, Name name) const;
+  /// Find a parameter by path (see ParameterIOView::FindParameter).
+  std::optional<Id> FindParameter(std::string_view path) const;
+
+  /// Convert a list (and all of its children) to a ParameterList.
+  ParameterList ToList(Id id) const;
+  /// Convert an object (and all of its parameters) to a ParameterObject.
+  ParameterObject ToObject(Id id) const;
+
+  /// Returns the number of bytes that are used by the arena.
+  size_t GetArenaSize() const { return m_arena.GetBytesAllocated(); }
+
+private:
+  friend struct FlatParameterIOBuilder;
+  FlatParameterIO() = default;
+
+  /// Lookup table entry. The entries for the children of a parent are stored at the same
+  /// positions as the children themselves, sorted by name hash (and then by ID).
+  struct IndexEntry {
+    u32 hash;
+    Id id;
+  };
+  using Index = std::vector<IndexEntry>;
+  static std::optional<Id> Find(const Index& index, Id begin, u32 count, Name name);
+
+  u32 m_version = 0;
+  std::string_view m_type;
+  std::vector<ListEntry> m_lists;
+  std::vector<ObjectEntry> m_objects;
+  std::vector<ParameterEntry> m_parameters;
+  Index m_list_index;
+  Index m_object_index;
+  Index m_parameter_index;
+  util::MonotonicArena m_arena;
+};
+
+}  // namespace oead::aamp
@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <nonstd/span.h>
+#include <optional>
+#include <string_view>
+
+#include <oead/aamp.h>
+#include <oead/types.h>
+#include <oead/util/binary_reader.h>
+
+namespace oead::aamp {
+
+/// Read-only view of a binary parameter archive.
+///
+/// Unlike ParameterIO::FromBinary, nothing is decoded upfront: lists, objects and parameters
+/// are read directly from the binary data when they are accessed, and strings and buffers are
+/// returned as views into the data. Children are looked up by name hash.
+/// The data must outlive the view, and the view must outlive anything obtained from it.
+class ParameterIOView {
+public:
+  class ParameterView {
+  public:
+    Name GetName() const { return m_name; }
+    Parameter::Type GetType() const { return m_type; }
+
+    // These getters throw a TypeError if the parameter has a different type.
+
+    bool GetBool() const;
+    f32 GetF32() const;
+    int GetInt() const;
+    u32 GetU32() const;
+    Vector2f GetVec2() const;
+    Vector3f GetVec3() const;
+    Vector4f GetVec4() const;
+    Color4f GetColor() const;
+    Quatf GetQuat() const;
+    /// Get the value of any string parameter.
+    std::string_view GetString() const;
+
+    // Curves and buffers are returned as spans into the data, which must be 4-byte aligned.
+    // Use ToParameter to get a copy if that is not the case.
+
+    /// Get the curves of a Curve1, Curve2, Curve3 or Curve4 parameter.
+    tcb::span<const Curve> GetCurves() const;
+    tcb::span<const int> GetBufferInt() const;
+    tcb::span<const f32> GetBufferF32() const;
+    tcb::span<const u32> GetBufferU32() const;
+    tcb::span<const u8> GetBufferBinary() const;
+
+    /// Decode the parameter.
+    Parameter ToParameter() const;
+
+  private:
+    friend class ParameterIOView;
+    ParameterView(const ParameterIOView* view, u32 offset);
+
+    void CheckType(Parameter::Type type) const;
+    template <typename T>
+    T Read(Parameter::Type type) const;
+    template <typename T>
+    tcb::span<const T> GetSpan(u32 offset, size_t size) const;
+    template <typename T>
+    tcb::span<const T> GetBuffer(Parameter::Type type) const;
+
+    const ParameterIOView* m_view;
+    u32 m_offset;
+    u32 m_data_offset;
+    Name m_name;
+    Parameter::Type m_type;
+  };
+
+  class ObjectView {
+  public:
+    Name GetName() const { return m_name; }
+    /// Returns the number of parameters.
+    size_t Size() const { return m_num_parameters; }
+    /// Get a parameter by name. Throws std::out_of_range if it does not exist.
+    ParameterView operator[](Name name) const;
+    /// Get a parameter by name, or std::nullopt if it does not exist.
+    std::optional<ParameterView> Find(Name name) const;
+    bool Contains(Name name) const { return Find(name).has_value(); }
+    /// Get a parameter by index. Throws std::out_of_range if the index is invalid.
+    ParameterView ParameterAt(size_t index) const;
+
+    /// Decode the object and all of its parameters.
+    ParameterObject ToObject() const;
+
+  private:
+    friend class ParameterIOView;
+    ObjectView(const ParameterIOView* view, u32 offset);
+
+    const ParameterIOView* m_view;
+    u32 m_offset;
+    u32 m_parameters_offset;
+    u16 m_num_parameters;
+    Name m_name;
+  };
+
+  class ListView {
+  public:
+    Name GetName() const { return m_name; }
+    size_t NumLists() const { return m_num_lists; }
+    size_t NumObjects() const { return m_num_objects; }
+
+    /// Get a child list by name. Throws std::out_of_range if it does not exist.
+    ListView List(Name name) const;
+    /// Get a child object by name. Throws std::out_of_range if it does not exist.
+    ObjectView Object(Name name) const;
+    /// Get a child list by name, or std::nullopt if it does not exist.
+    std::optional<ListView> FindList(Name name) const;
+    /// Get a child object by name, or std::nullopt if it does not exist.
+    std::optional<ObjectView> FindObject(Name name) const;
+    /// Get a child list by index. Throws std::out_of_range if the index is invalid.
+    ListView ListAt(size_t index) const;
+    /// Get a child object by index. Throws std::out_of_range if the index is invalid.
+    ObjectView ObjectAt(size_t index) const;
+
+    /// Decode the list and all of its children.
+    ParameterList ToList() const;
+
+  private:
+    friend class ParameterIOView;
+    ListView(const ParameterIOView* view, u32 offset);
+
+    const ParameterIOView* m_view;
+    u32 m_offset;
+    u32 m_lists_offset;
+    u32 m_objects_offset;
+    u16 m_num_lists;
+    u16 m_num_objects;
+    Name m_name;
+  };
+
+  /// Create a view of a binary parameter archive. Only the header is validated.
+  explicit ParameterIOView(tcb::span<const u8> data);
+
+  /// Returns the root list (param_root).
+  ListView GetRoot() const;
+  /// Data version (see ParameterIO::version).
+  u32 GetVersion() const { return m_version; }
+  /// Data type identifier (see ParameterIO::type).
+  std::string_view GetType() const { return m_type; }
+
+  /// Find a parameter by path, e.g. "General/Speed" for the Speed parameter in the General
+  /// object of the root list. All components except for the last two are list names.
+  std::optional<ParameterView> FindParameter(std::string_view path) const;
+
+  tcb::span<const u8> GetData() const { return m_reader.span(); }
+
+private:
+  template <typename T>
+  T Read(size_t offset) const;
+
+  util::BinaryReader m_reader;
+  u32 m_root_offset;
+  u32 m_version;
+  std::string_view m_type;
+};
+
+}  // namespace oead::aamp
@@ -32,6 +32,7 @@
 
 #include <oead/errors.h>
 #include <oead/types.h>
+#include <oead/util/flat_string_map.h>
 #include <oead/util/type_utils.h>
 #include <oead/util/variant_utils.h>
 
@@ -56,11 +57,20 @@ public:
   };
 
   using Null = std::nullptr_t;
-  using String = std::string;
+  /// Strings that are shorter than 8 bytes are stored inline. Strings are immutable, but they
+  /// can be reassigned and converted to std::string_view or std::string.
+  using String = CompactString<8>;
   using Array = std::vector<Byml>;
+  /// Hash (dictionary). Iteration is always in key order.
+  /// If oead is built with OEAD_BYML_FLAT_HASH, this is a sorted vector (which makes lookups
+  /// in small hashes faster) instead of a B-tree.
+#ifdef OEAD_BYML_FLAT_HASH
+  using Hash = util::FlatStringMap<Byml>;
+#else
   using Hash = absl::btree_map<std::string, Byml>;
+#endif
 
-  using Value = util::Variant<Type, Null, std::unique_ptr<String>, std::unique_ptr<std::vector<u8>>,
+  using Value = util::Variant<Type, Null, String, std::unique_ptr<std::vector<u8>>,
                               std::unique_ptr<Array>, std::unique_ptr<Hash>, bool, S32, F32, U32,
                               S64, U64, F64>;
 
@@ -69,6 +79,10 @@ public:
   Byml(Byml&& other) noexcept { *this = std::move(other); }
   template <typename T, std::enable_if_t<std::is_constructible_v<Value, T>>* = nullptr>
   Byml(T value) : m_value{std::move(value)} {}
+  template <typename T,
+            std::enable_if_t<!std::is_constructible_v<Value, T> &&
+                             std::is_convertible_v<const T&, std::string_view>>* = nullptr>
+  Byml(const T& value) : m_value{String(value)} {}
   Byml& operator=(const Byml& other) = default;
   Byml& operator=(Byml&& other) noexcept = default;
 
@@ -121,13 +135,28 @@ public:
   }
 
   /// Load a document from binary data.
-  static Byml FromBinary(tcb::span<const u8> data);
+  ///
+  /// If num_threads is not 1, containers with many children (such as the root array of a
+  /// large map unit) are parsed in parallel using up to num_threads threads (0 means one
+  /// thread per hardware thread). The result is identical to a serial parse.
+  static Byml FromBinary(tcb::span<const u8> data, size_t num_threads = 1);
   /// Load a document from YAML text.
   static Byml FromText(std::string_view yml_text);
 
   /// Serialize the document to BYML with the specified endianness and version number.
   /// This can only be done for Null, Array or Hash nodes.
-  std::vector<u8> ToBinary(bool big_endian, int version = 2) const;
+  ///
+  /// If num_threads is not 1, the children of large containers are serialized in parallel
+  /// using up to num_threads threads (0 means one thread per hardware thread).
+  /// The output is identical to that of a serial write.
+  std::vector<u8> ToBinary(bool big_endian, int version = 2, size_t num_threads = 1) const;
+  /// Serialize the document to BYML into a caller-provided buffer (e.g. a memory-mapped file).
+  /// Throws std::invalid_argument if the buffer is smaller than GetBinarySize().
+  /// Returns the number of bytes that were written.
+  size_t ToBinary(tcb::span<u8> buffer, bool big_endian, int version = 2,
+                  size_t num_threads = 1) const;
+  /// Returns the exact size of the document once serialized to BYML.
+  size_t GetBinarySize() const;
   /// Serialize the document to YAML.
   /// This can only be done for Null, Array or Hash nodes.
   std::string ToText() const;
@@ -156,4 +185,6 @@ private:
   Value m_value;
 };
 
+static_assert(sizeof(Byml) <= 0x10);
+
 }  // namespace oead
@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <oead/byml.h>
+
+namespace oead {
+
+/// A minimal set of changes that turns a document into another document.
+///
+/// Subtrees are compared using structural hashes that are computed once per container,
+/// so differing branches are told apart without being walked again. Subtrees with equal hashes
+/// are confirmed to be equal item by item, so hash collisions cannot hide a change.
+/// Array items are matched with a Myers diff; items that are replaced one-for-one are diffed
+/// recursively.
+///
+/// Diffs can be stored as BYML documents (see ToByml and FromByml).
+class BymlDiff {
+public:
+  /// A hash key or an array index.
+  using PathComponent = std::variant<std::string, size_t>;
+
+  struct Change {
+    enum class Kind {
+      /// Set a hash item (inserting it if necessary), an array item or the root node.
+      Set,
+      /// Remove a hash item.
+      Remove,
+      /// Replace `count` array items starting at `index` with the items in `value`.
+      Splice,
+    };
+    Kind kind;
+    /// Keys and indices that lead from the root node to the changed node (or to the array
+    /// for Splice). Indices refer to the original document.
+    std::vector<PathComponent> path;
+    /// New value (for Set) or array of new items (for Splice).
+    Byml value;
+    size_t index = 0;
+    size_t count = 0;
+
+    bool operator==(const Change& other) const {
+      return kind == other.kind && path == other.path && value == other.value &&
+             index == other.index && count == other.count;
+    }
+  };
+
+  BymlDiff() = default;
+  explicit BymlDiff(std::vector<Change> changes) : m_changes{std::move(changes)} {}
+
+  /// Compute the changes between two documents.
+  static BymlDiff Make(const Byml& base, const Byml& modified);
+
+  /// Apply the changes to a document, which should be (or be derived from) the base document.
+  /// Throws std::invalid_argument if a path does not exist in the document.
+  void Apply(Byml& document) const;
+
+  /// Convert the diff to an array of hashes that can be serialized like any other document.
+  Byml ToByml() const;
+  /// Load a diff that was created by ToByml. Throws InvalidDataError if the data is invalid.
+  static BymlDiff FromByml(const Byml& data);
+
+  /// Changes in document order.
+  const std::vector<Change>& GetChanges() const { return m_changes; }
+  bool IsEmpty() const { return m_changes.empty(); }
+
+  bool operator==(const BymlDiff& other) const { return m_changes == other.m_changes; }
+
+private:
+  std::vector<Change> m_changes;
+};
+
+namespace byml {
+
+/// Determines what happens when both sides of a merge modify the same node in different ways.
+enum class MergePolicy {
+  /// Keep the version of the node from `ours`.
+  PreferOurs,
+  /// Keep the version of the node from `theirs`.
+  PreferTheirs,
+  /// Throw a MergeConflictError.
+  Fail,
+};
+
+/// Thrown by Merge when a conflict is found and the policy is MergePolicy::Fail.
+struct MergeConflictError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+/// Structural 3-way merge: applies the changes from `base` to `ours` and from `base` to `theirs`.
+///
+/// Hashes are merged key by key. Arrays are merged hunk by hunk; hunks that touch the same
+/// items are merged item by item if both sides replaced items one-for-one, and are conflicts
+/// otherwise. Subtrees that only one side modified are taken as-is without being walked.
+Byml Merge(const Byml& base, const Byml& ours, const Byml& theirs,
+           MergePolicy policy = MergePolicy::PreferTheirs);
+
+}  // namespace byml
+
+}  // namespace oead
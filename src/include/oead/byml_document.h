@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <nonstd/span.h>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <oead/byml.h>
+#include <oead/types.h>
+#include <oead/util/arena.h>
+#include <oead/util/offset_ptr.h>
+
+namespace oead {
+
+/// Immutable BYML document whose nodes, strings and containers are all stored in an arena
+/// that is owned by the document.
+///
+/// Compared to Byml, building a document requires very few allocations and destroying it is
+/// nearly free. Strings are interned: every distinct string is only stored once, and containers
+/// that are shared in the binary data are shared in the document as well.
+///
+/// Nodes only refer to each other through offset pointers, so a document can be saved as a
+/// position-independent snapshot and loaded again (e.g. from a memory-mapped file) without
+/// any parsing. See ToSnapshot and FromSnapshot.
+class BymlDocument {
+public:
+  struct HashEntry;
+
+  /// A node in the document. Nodes are owned by the document and must not outlive it.
+  class Node {
+  public:
+    Node() = default;
+    Node(const Node& other) { *this = other; }
+    Node& operator=(const Node& other) {
+      m_type = other.m_type;
+      m_size = other.m_size;
+      m_value = other.m_value;
+      if (other.HasPointer())
+        SetPointer(other.GetPointer<void>());
+      return *this;
+    }
+
+    Byml::Type GetType() const { return m_type; }
+    bool IsNull() const { return m_type == Byml::Type::Null; }
+
+    /// Returns the number of items in an array or hash node.
+    size_t Size() const;
+    /// Get an array item by index. Throws std::out_of_range if the index is invalid.
+    const Node& operator[](size_t index) const;
+    /// Get a hash item by key. Throws std::out_of_range if the key does not exist.
+    const Node& operator[](std::string_view key) const;
+    /// Get a hash item by key, or nullptr if the key does not exist.
+    const Node* Find(std::string_view key) const;
+    /// Returns whether a hash node contains the specified key.
+    bool Contains(std::string_view key) const { return Find(key) != nullptr; }
+    /// Returns the items of an array node.
+    tcb::span<const Node> GetArray() const;
+    /// Returns the entries of a hash node (sorted by key).
+    tcb::span<const HashEntry> GetHash() const;
+
+    // These getters behave like the ones in Byml.
+
+    std::string_view GetString() const;
+    tcb::span<const u8> GetBinary() const;
+    bool GetBool() const;
+    s32 GetInt() const;
+    u32 GetUInt() const;
+    f32 GetFloat() const;
+    s64 GetInt64() const;
+    u64 GetUInt64() const;
+    f64 GetDouble() const;
+
+    /// Convert the node (and all of its children) to a Byml.
+    Byml ToByml() const;
+
+  private:
+    friend class BymlDocument;
+    friend struct BymlDocumentBuilder;
+    friend struct BymlSnapshotWriter;
+    friend struct BymlSnapshotValidator;
+    Byml ToScalarByml() const;
+
+    /// Returns whether the node refers to other data (strings, binary data and containers).
+    bool HasPointer() const {
+      return m_type == Byml::Type::String || m_type == Byml::Type::Binary ||
+             m_type == Byml::Type::Array || m_type == Byml::Type::Hash;
+    }
+    template <typename T>
+    const T* GetPointer() const {
+      return static_cast<const T*>(util::ResolveOffset(this, m_value.offset));
+    }
+    void SetPointer(const void* ptr) { m_value.offset = util::MakeOffset(this, ptr); }
+
+    Byml::Type m_type = Byml::Type::Null;
+    /// Number of items (for containers) or bytes (for strings and binary data).
+    u32 m_size = 0;
+    union {
+      bool b;
+      s32 s32_;
+      u32 u32_;
+      f32 f32_;
+      s64 s64_;
+      u64 u64_;
+      f64 f64_;
+      /// Offset from the node to its string, binary data, array items or hash entries.
+      u64 offset;
+    } m_value{};
+  };
+
+  struct HashEntry {
+    std::string_view GetKey() const { return {key_data.Get(), key_size}; }
+
+    util::OffsetPtr<const char> key_data;
+    u32 key_size = 0;
+    Node value;
+  };
+
+  BymlDocument(BymlDocument&&) noexcept = default;
+  BymlDocument& operator=(BymlDocument&&) noexcept = default;
+
+  /// Load a document from binary data.
+  static BymlDocument FromBinary(tcb::span<const u8> data);
+  /// Build a document from a Byml.
+  static BymlDocument FromByml(const Byml& byml);
+
+  /// Convert the document to a Byml.
+  Byml ToByml() const { return GetRoot().ToByml(); }
+  /// Serialize the document to BYML with the specified endianness and version number.
+  std::vector<u8> ToBinary(bool big_endian, int version = 2) const;
+
+  /// Save the document as a snapshot: a single relocatable block of memory that has a versioned
+  /// header and a checksum. Snapshots can only be loaded on platforms with the same byte order.
+  std::vector<u8> ToSnapshot() const;
+  /// Use a snapshot as a document without copying or parsing it. The data must be 8-byte aligned
+  /// and must outlive the document. Throws InvalidDataError if the snapshot is invalid,
+  /// was created by an incompatible version of oead or if the checksum does not match.
+  ///
+  /// Every node is checked to only refer to data inside of the snapshot (in one pass that visits
+  /// shared containers once) and strings must be null-terminated, even if the checksum is not
+  /// verified, so untrusted snapshots are safe to load.
+  static BymlDocument FromSnapshot(tcb::span<const u8> data, bool verify_checksum = true);
+
+  const Node& GetRoot() const { return *m_root; }
+
+  /// Returns the number of bytes that are used by the document arena.
+  /// This is 0 for documents that are loaded from a snapshot.
+  size_t GetArenaSize() const { return m_arena.GetBytesAllocated(); }
+
+private:
+  friend struct BymlDocumentBuilder;
+  friend struct BymlSnapshotWriter;
+  BymlDocument() = default;
+
+  util::MonotonicArena m_arena;
+  const Node* m_root = nullptr;
+};
+
+}  // namespace oead
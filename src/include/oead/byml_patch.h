@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+#include <nonstd/span.h>
+#include <string_view>
+#include <vector>
+
+#include <oead/byml.h>
+#include <oead/byml_query.h>
+#include <oead/byml_view.h>
+#include <oead/types.h>
+
+/// Functions to modify binary BYML documents without fully reserializing them.
+namespace oead::byml {
+
+/// Overwrite a scalar value in binary BYML data, without decoding or reserializing the document.
+///
+/// `path` is a BymlQuery that must match exactly one node; otherwise std::invalid_argument
+/// is thrown.
+///
+/// Patching in place is only possible if the node and the new value have the same type,
+/// which must be Bool, Int, UInt, Float, Int64, UInt64 or Double, and if the value is
+/// not shared with other nodes (because of deduplication).
+///
+/// Returns false (and leaves the data unchanged) if the value cannot be patched in place.
+/// Every call scans the document for shared values; use InPlacePatcher to patch several values.
+bool TryPatchInPlace(tcb::span<u8> data, std::string_view path, const Byml& value);
+
+/// Overwrites scalar values in binary BYML data, like TryPatchInPlace.
+///
+/// The document is scanned once when the patcher is created to find the values that are
+/// shared by several nodes, so each patch only needs to look up the path.
+/// The data must outlive the patcher and must only be modified through it.
+class InPlacePatcher {
+public:
+  explicit InPlacePatcher(tcb::span<u8> data);
+
+  /// See TryPatchInPlace.
+  bool TryPatch(std::string_view path, const Byml& value);
+
+private:
+  bool IsShared(const BymlView::Node& node,
+                const std::vector<BymlQuery::PathComponent>& path) const;
+
+  tcb::span<u8> m_data;
+  BymlView m_view;
+  /// Number of slots that refer to each container and long value, by offset.
+  absl::flat_hash_map<u32, u32> m_ref_counts;
+};
+
+/// Set the value of a node in binary BYML data. `path` must match exactly one node.
+///
+/// The data is patched in place if possible (see TryPatchInPlace). Otherwise, the document
+/// is decoded, modified and reserialized with the same endianness and version.
+/// Returns whether the document had to be reserialized.
+bool Patch(std::vector<u8>& data, std::string_view path, Byml value);
+
+}  // namespace oead::byml
@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <oead/byml.h>
+#include <oead/byml_view.h>
+
+namespace oead {
+
+/// A compiled path query that is executed directly against binary BYML data.
+///
+/// Syntax: a query is a sequence of steps, each of which starts with a slash.
+///
+/// - `/Key` selects the value of `Key` in a hash. Keys that contain special characters
+///   can be quoted: `/"Some Key"`.
+/// - `/*` selects all children of an array or a hash.
+/// - `[N]` selects the Nth item of an array.
+/// - `[key==literal]` and `[key!=literal]` select the children of an array or a hash that are
+///   hashes whose `key` item is (or is not) equal to the literal. Literals can be strings
+///   ("..."), integers, floats, true, false or null.
+///
+/// Bracketed steps can follow a key directly: `/Actors[name=="Enemy_Bokoblin_Junior"]/profile`
+/// is equivalent to `/Actors/[name=="Enemy_Bokoblin_Junior"]/profile`.
+///
+/// Nodes that cannot match are never decoded. Hash lookups use binary searches.
+class BymlQuery {
+public:
+  /// Compile a query. Throws std::invalid_argument if the query is invalid.
+  explicit BymlQuery(std::string_view query);
+
+  /// Execute the query on the root node of a document.
+  /// Returns all matching nodes, in document order.
+  std::vector<BymlView::Node> Execute(const BymlView& view) const;
+  /// Execute the query, starting at the specified node.
+  std::vector<BymlView::Node> Execute(const BymlView::Node& node) const;
+
+  /// A hash key or an array index.
+  using PathComponent = std::variant<std::string_view, size_t>;
+  struct Match {
+    BymlView::Node node;
+    /// Keys and indices that lead from the root node to the matching node.
+    std::vector<PathComponent> path;
+  };
+  /// Same as Execute, but also returns the path to every matching node.
+  /// Keys are views into the document data.
+  std::vector<Match> ExecuteWithPaths(const BymlView& view) const;
+
+  struct Step {
+    enum class Kind {
+      Key,
+      Wildcard,
+      Index,
+      Equal,
+      NotEqual,
+    };
+    Kind kind;
+    /// Key (for Key, Equal and NotEqual).
+    std::string key;
+    size_t index = 0;
+    /// Literal (for Equal and NotEqual).
+    Byml value;
+  };
+
+  const std::vector<Step>& GetSteps() const { return m_steps; }
+
+private:
+  template <bool TrackPaths, typename Callback>
+  void Run(const BymlView::Node& node, Callback callback) const;
+
+  std::vector<Step> m_steps;
+};
+
+}  // namespace oead
@@ -0,0 +1,165 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <nonstd/span.h>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include <oead/byml.h>
+#include <oead/types.h>
+#include <oead/util/binary_reader.h>
+#include <oead/util/swap.h>
+
+namespace oead {
+
+class BymlVisitor;
+
+/// Read-only view of a binary BYML document.
+///
+/// Unlike Byml::FromBinary, nothing is decoded upfront: nodes are read directly from the binary
+/// data when they are accessed, and strings are returned as views into the data.
+/// The data must outlive the view, and the view must outlive any node obtained from it.
+class BymlView {
+public:
+  /// A node in a BYML document. This is a lightweight handle that does not own any data.
+  class Node {
+  public:
+    Byml::Type GetType() const { return m_type; }
+    bool IsNull() const { return m_type == Byml::Type::Null; }
+
+    /// Returns the number of items in an array or hash node.
+    size_t Size() const;
+    /// Get an array item by index. Throws std::out_of_range if the index is invalid.
+    Node operator[](size_t index) const;
+    /// Get a hash item by key. Throws std::out_of_range if the key does not exist.
+    Node operator[](std::string_view key) const;
+    /// Get a hash item by key, or std::nullopt if the key does not exist.
+    /// Keys are looked up with a binary search (hash keys are sorted in the binary format).
+    std::optional<Node> Find(std::string_view key) const;
+    /// Returns whether a hash node contains the specified key.
+    bool Contains(std::string_view key) const { return Find(key).has_value(); }
+    /// Get a hash item by index (in key order).
+    std::pair<std::string_view, Node> GetHashItem(size_t index) const;
+
+    // These getters behave like the ones in Byml, except that strings and binary data
+    // are returned as views into the document data.
+
+    std::string_view GetString() const;
+    tcb::span<const u8> GetBinary() const;
+    bool GetBool() const;
+    s32 GetInt() const;
+    u32 GetUInt() const;
+    f32 GetFloat() const;
+    s64 GetInt64() const;
+    u64 GetUInt64() const;
+    f64 GetDouble() const;
+
+    /// Decode the node (and all of its children) into a Byml.
+    Byml ToByml() const;
+
+    /// Returns the offset of the 4-byte slot that stores the node value in the binary data.
+    /// For inline types, the slot contains the value itself; for other types, it contains
+    /// an offset to the node data.
+    u32 GetSlotOffset() const { return m_slot_offset; }
+    /// Returns the raw 4-byte value that is stored in the node slot.
+    u32 GetRawValue() const { return m_raw_value; }
+
+  private:
+    friend class BymlView;
+    friend class BymlQuery;
+    Node(const BymlView* view, Byml::Type type, u32 raw_value, u32 slot_offset)
+        : m_view{view}, m_type{type}, m_raw_value{raw_value}, m_slot_offset{slot_offset} {}
+
+    /// Reads the container header and checks the node type. Returns the number of items.
+    u32 ReadContainerSize(Byml::Type expected_type) const;
+    Node ReadChild(u8 raw_type, u32 slot_offset) const;
+    /// Find a hash item by the index of its key in the hash key table.
+    std::optional<Node> FindByKeyIndex(u32 size, u32 key_index) const;
+    Byml ToScalarByml() const;
+
+    const BymlView* m_view;
+    Byml::Type m_type;
+    u32 m_raw_value;
+    u32 m_slot_offset;
+  };
+
+  /// Create a view of a binary BYML document. Only the header and string tables are validated.
+  explicit BymlView(tcb::span<const u8> data);
+
+  /// Returns the root node (an array, a hash or null).
+  Node GetRoot() const;
+
+  /// Walk the document depth-first and report every node to the visitor (SAX-style).
+  /// Nodes are read directly from the binary data; the only allocation is a small stack
+  /// of containers that are currently open.
+  void Visit(BymlVisitor& visitor) const;
+
+  tcb::span<const u8> GetData() const { return m_reader.span(); }
+  util::Endianness GetEndianness() const { return m_reader.Endian(); }
+  int GetVersion() const { return m_version; }
+
+private:
+  friend class BymlQuery;
+  util::BinaryReader Reader() const { return m_reader; }
+  std::string_view GetHashKey(u32 index) const;
+  std::string_view GetStringTableEntry(u32 index) const;
+  /// Binary search the hash key table. Returns the index of the key, if it exists.
+  std::optional<u32> FindHashKey(std::string_view key) const;
+
+  util::BinaryReader m_reader;
+  u16 m_version;
+  u32 m_hash_key_table_offset = 0;
+  u32 m_num_hash_keys = 0;
+  u32 m_string_table_offset = 0;
+  u32 m_num_strings = 0;
+  u32 m_root_node_offset = 0;
+};
+
+/// Event handler for BymlView::Visit.
+///
+/// `key` is the key of the node in its parent hash. It is empty for the root node and
+/// for array items.
+class BymlVisitor {
+public:
+  enum class Action {
+    /// Keep walking the document.
+    Continue,
+    /// Do not visit the children of the container that was just entered.
+    /// End() will not be called for that container.
+    Skip,
+    /// Stop walking the document immediately.
+    Stop,
+  };
+
+  virtual ~BymlVisitor() = default;
+
+  virtual Action BeginArray(std::string_view /*key*/, size_t /*size*/) { return Action::Continue; }
+  virtual Action BeginHash(std::string_view /*key*/, size_t /*size*/) { return Action::Continue; }
+  /// Called for every node that is not an array or a hash.
+  virtual Action Scalar(std::string_view /*key*/, const BymlView::Node& /*node*/) {
+    return Action::Continue;
+  }
+  /// Called after all children of an array or hash have been visited.
+  virtual Action End() { return Action::Continue; }
+};
+
+}  // namespace oead
@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <absl/container/btree_map.h>
+#include <nonstd/span.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <oead/types.h>
+#include <oead/util/swap.h>
+
+namespace oead {
+class Sarc;
+}
+
+namespace oead::rstb {
+
+/// Resource size table (RSTB). Maps resource paths to the size of the heap that the game
+/// allocates for them when they are loaded.
+///
+/// Entries are normally keyed by the CRC32 of the resource path. Paths whose hash collides
+/// with another resource are stored by name instead.
+class ResourceSizeTable {
+public:
+  /// Parse a resource size table. The endianness must be specified because the format
+  /// does not contain a byte order mark (Wii U tables are big endian, Switch tables are
+  /// little endian).
+  static ResourceSizeTable FromBinary(tcb::span<const u8> data, util::Endianness endian);
+  /// Serialize the table.
+  std::vector<u8> ToBinary(util::Endianness endian) const;
+
+  /// Returns the size for a resource path, or std::nullopt if there is no entry for it.
+  std::optional<u32> GetSize(std::string_view name) const;
+  /// Add or update the size for a resource path.
+  void SetSize(std::string_view name, u32 size);
+  /// Delete the entry for a resource path (if any).
+  void DeleteEntry(std::string_view name);
+  /// Returns whether there is an entry for a resource path.
+  bool Contains(std::string_view name) const { return GetSize(name).has_value(); }
+
+  bool operator==(const ResourceSizeTable& other) const {
+    return crc_map == other.crc_map && name_map == other.name_map;
+  }
+  bool operator!=(const ResourceSizeTable& other) const { return !(*this == other); }
+
+  /// Maximum length of a name table entry, including the null terminator.
+  static constexpr size_t MaxNameLength = 128;
+
+  /// CRC32 -> size.
+  absl::btree_map<u32, u32> crc_map;
+  /// Resource path -> size. Only used for paths with colliding hashes.
+  absl::btree_map<std::string, u32> name_map;
+};
+
+/// Resource factory information for a file type.
+struct FactoryInfo {
+  /// Factory name (usually the file extension without the dot).
+  std::string_view name;
+  /// Size of the resource class on Switch.
+  u32 size_nx;
+  /// Size of the resource class on Wii U.
+  u32 size_wiiu;
+  /// Required data alignment.
+  u32 alignment;
+  /// Fixed parse size on Switch, or std::nullopt if it depends on the file contents.
+  std::optional<u32> parse_size_nx;
+  /// Fixed parse size on Wii U, or std::nullopt if it depends on the file contents.
+  std::optional<u32> parse_size_wiiu;
+  /// Multiplier that is applied to the file size.
+  float multiplier;
+  /// Constant that is added to the resource size.
+  u32 constant;
+};
+
+/// Get the resource factory information for a file extension (without the dot).
+/// Unknown extensions are handled by the default factory.
+const FactoryInfo& GetFactoryInfo(std::string_view extension);
+
+/// Returns the path that is used as a RSTB key for a resource, i.e. the path with the Yaz0
+/// "s" extension prefix removed (e.g. Actor/Pack/X.sbactorpack -> Actor/Pack/X.bactorpack).
+std::string GetCanonicalName(std::string_view name);
+
+/// Estimate the resource size for a file.
+///
+/// @param name  Resource path (with or without the Yaz0 "s" extension prefix)
+/// @param data  File data. If it is Yaz0 compressed, only the header is read.
+/// @param endian  Big endian for Wii U, little endian for Switch.
+/// @param allow_heuristics  Whether to estimate sizes for file types whose parse size depends on
+///                          the file contents. If false, std::nullopt is returned for such files.
+std::optional<u32> EstimateSize(std::string_view name, tcb::span<const u8> data,
+                                util::Endianness endian, bool allow_heuristics = false);
+
+/// Same as above, but takes the uncompressed file size instead of the file data.
+std::optional<u32> EstimateSize(std::string_view name, size_t file_size, util::Endianness endian,
+                                bool allow_heuristics = false);
+
+struct ArchiveEntry {
+  /// Canonical resource path.
+  std::string name;
+  /// Estimated resource size, or std::nullopt if it could not be estimated.
+  std::optional<u32> size;
+
+  bool operator==(const ArchiveEntry& other) const {
+    return name == other.name && size == other.size;
+  }
+};
+
+/// Estimate resource sizes for every file in an archive, including files in nested archives
+/// (which are decompressed if necessary). Files are processed in parallel.
+///
+/// @param num_threads  Number of threads to use (0 means one thread per hardware thread).
+/// \returns entries in archive order, with each nested archive followed by its own files.
+std::vector<ArchiveEntry> EstimateArchiveSizes(const Sarc& archive, util::Endianness endian,
+                                               bool allow_heuristics = false,
+                                               size_t num_threads = 0);
+
+}  // namespace oead::rstb
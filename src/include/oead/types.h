@@ -23,6 +23,11 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 #include <tuple>
 #include <utility>
@@ -188,31 +193,149 @@ struct Curve {
 };
 static_assert(sizeof(Curve) == 0x80);
 
-/// A string class with its own inline, fixed-size storage.
+/// An immutable string that takes up exactly Size bytes (a multiple of the pointer size).
+///
+/// Strings that are shorter than Size bytes are stored inline. Longer strings are stored in
+/// a single heap allocation that holds both the length and the characters.
+/// This is intended to be used for strings that are stored in variants, where a std::string
+/// would otherwise need to be boxed (which requires two allocations for long strings).
+template <size_t Size>
+class CompactString {
+public:
+  static_assert(Size >= sizeof(void*) && Size % sizeof(void*) == 0,
+                "Size must be a multiple of the pointer size");
+
+  /// Maximum length of strings that are stored inline.
+  ///
+  /// The inline representation is distinguished from a heap pointer using the least significant
+  /// bit of the pointer, which is always clear. That bit is only in the first byte on
+  /// little endian platforms; on other platforms, strings are never stored inline.
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  static constexpr size_t InlineCapacity = Size - 1;
+#else
+  static constexpr size_t InlineCapacity = 0;
+#endif
+
+  CompactString() = default;
+  explicit CompactString(std::string_view str) { Assign(str); }
+  CompactString(const CompactString& other) { Assign(other); }
+  CompactString(CompactString&& other) noexcept : m_bytes{other.m_bytes} { other.m_bytes = {}; }
+  ~CompactString() { ::operator delete(GetHeapBlock()); }
+
+  CompactString& operator=(std::string_view str) {
+    CompactString copy{str};
+    std::swap(m_bytes, copy.m_bytes);
+    return *this;
+  }
+  CompactString& operator=(const CompactString& other) { return *this = std::string_view(other); }
+  CompactString& operator=(CompactString&& other) noexcept {
+    std::swap(m_bytes, other.m_bytes);
+    return *this;
+  }
+
+  bool IsInline() const { return InlineCapacity != 0 && (u8(m_bytes[0]) & 1) != 0; }
+
+  size_t size() const {
+    if (IsInline())
+      return u8(m_bytes[0]) >> 1;
+    const char* block = GetHeapBlock();
+    if (!block)
+      return 0;
+    u32 size;
+    std::memcpy(&size, block, sizeof(size));
+    return size;
+  }
+  bool empty() const { return size() == 0; }
+  const char* data() const {
+    if (IsInline())
+      return &m_bytes[1];
+    const char* block = GetHeapBlock();
+    return block ? block + sizeof(u32) : nullptr;
+  }
+  const char* begin() const { return data(); }
+  const char* end() const { return data() + size(); }
+  char operator[](size_t i) const { return data()[i]; }
+
+  operator std::string_view() const { return {data(), size()}; }
+  /// CompactStrings are immutable; convert to a std::string to get a modifiable copy.
+  operator std::string() const { return {data(), size()}; }
+
+  friend bool operator==(const CompactString& lhs, const CompactString& rhs) {
+    return std::string_view(lhs) == std::string_view(rhs);
+  }
+  friend bool operator==(const CompactString& lhs, std::string_view rhs) {
+    return std::string_view(lhs) == rhs;
+  }
+  friend bool operator==(std::string_view lhs, const CompactString& rhs) {
+    return lhs == std::string_view(rhs);
+  }
+  friend bool operator!=(const CompactString& lhs, const CompactString& rhs) {
+    return !(lhs == rhs);
+  }
+  friend bool operator!=(const CompactString& lhs, std::string_view rhs) { return !(lhs == rhs); }
+  friend bool operator!=(std::string_view lhs, const CompactString& rhs) { return !(lhs == rhs); }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const CompactString& self) {
+    return H::combine(std::move(h), std::string_view(self));
+  }
+
+private:
+  char* GetHeapBlock() const {
+    if (IsInline())
+      return nullptr;
+    char* block;
+    std::memcpy(&block, m_bytes.data(), sizeof(block));
+    return block;
+  }
+
+  /// Must only be called when the string is empty and has no heap block.
+  void Assign(std::string_view str) {
+    if (str.empty())
+      return;
+
+    if (str.size() <= InlineCapacity) {
+      m_bytes[0] = char(str.size() << 1 | 1);
+      std::memcpy(&m_bytes[1], str.data(), str.size());
+      return;
+    }
+
+    if (str.size() > std::numeric_limits<u32>::max())
+      throw std::length_error("CompactString: string is too long");
+    const u32 size = u32(str.size());
+    char* block = static_cast<char*>(::operator new(sizeof(size) + size));
+    std::memcpy(block, &size, sizeof(size));
+    std::memcpy(block + sizeof(size), str.data(), size);
+    std::memcpy(m_bytes.data(), &block, sizeof(block));
+  }
+
+  alignas(void*) std::array<char, Size> m_bytes{};
+};
+
+/// A string class with a maximum length of N characters. Longer strings are truncated.
+///
+/// Short strings are stored inline; see CompactString.
 template <size_t N>
 struct FixedSafeString {
   FixedSafeString() = default;
   FixedSafeString(std::string_view str) { *this = str; }
 
-  auto& operator=(const FixedSafeString& other) {
-    length = other.length;
-    data = other.data;
-    return *this;
-  }
   auto& operator=(std::string_view str) {
-    data.fill(0);
-    length = std::min(str.size(), N);
-    std::copy_n(str.begin(), length, data.begin());
+    m_str = str.substr(0, N);
     return *this;
   }
 
-  operator std::string_view() const { return {data.data(), length}; }
-  bool operator==(const FixedSafeString& other) const { return Str(*this) == Str(other); }
+  operator std::string_view() const { return m_str; }
+  bool operator==(const FixedSafeString& other) const { return m_str == other.m_str; }
   bool operator!=(const FixedSafeString& other) const { return !(*this == other); }
 
+  template <typename H>
+  friend H AbslHashValue(H h, const FixedSafeString& self) {
+    return H::combine(std::move(h), self.m_str);
+  }
+
 private:
-  size_t length = 0;
-  std::array<char, N> data{};
+  CompactString<16> m_str;
 };
 
 /// Casts a string-like object to a string view.
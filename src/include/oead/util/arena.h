@@ -0,0 +1,113 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <nonstd/span.h>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <oead/types.h>
+#include <oead/util/align.h>
+
+namespace oead::util {
+
+/// A simple monotonic allocator. Memory is allocated from large blocks and is only released
+/// when the arena is destroyed, all at once. Destructors are never run, so only trivially
+/// destructible objects may be allocated.
+///
+/// Moving an arena does not invalidate pointers to memory that was allocated from it.
+class MonotonicArena {
+public:
+  explicit MonotonicArena(size_t block_size = DefaultBlockSize) : m_block_size{block_size} {}
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+  MonotonicArena(MonotonicArena&& other) noexcept = default;
+  MonotonicArena& operator=(MonotonicArena&& other) noexcept = default;
+
+  /// Allocate uninitialised memory. alignment must be a power of 2 and at most
+  /// alignof(std::max_align_t).
+  void* Allocate(size_t size, size_t alignment) {
+    size_t offset = util::AlignUp(m_block_offset, alignment);
+    if (m_blocks.empty() || offset + size > m_current_block_size) {
+      // Large allocations get their own block so that the current block can still be used.
+      if (size > m_block_size / 4) {
+        auto& block = m_blocks.emplace_back(new u8[size]);
+        m_bytes_allocated += size;
+        auto* ptr = block.get();
+        if (m_blocks.size() > 1)
+          std::swap(m_blocks[m_blocks.size() - 1], m_blocks[m_blocks.size() - 2]);
+        return ptr;
+      }
+      m_blocks.emplace_back(new u8[m_block_size]);
+      m_bytes_allocated += m_block_size;
+      m_current_block_size = m_block_size;
+      m_block_offset = 0;
+      offset = 0;
+    }
+    m_block_offset = offset + size;
+    return m_blocks.back().get() + offset;
+  }
+
+  /// Allocate an array of n value-initialised objects.
+  template <typename T>
+  T* AllocateArray(size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    if (n == 0)
+      return nullptr;
+    T* ptr = static_cast<T*>(Allocate(sizeof(T) * n, alignof(T)));
+    std::uninitialized_value_construct_n(ptr, n);
+    return ptr;
+  }
+
+  /// Copy a string into the arena. The copy is null-terminated.
+  std::string_view CopyString(std::string_view str) {
+    char* ptr = static_cast<char*>(Allocate(str.size() + 1, 1));
+    if (!str.empty())
+      std::memcpy(ptr, str.data(), str.size());
+    ptr[str.size()] = '\0';
+    return {ptr, str.size()};
+  }
+
+  /// Copy bytes into the arena.
+  tcb::span<const u8> CopyBytes(tcb::span<const u8> bytes) {
+    if (bytes.empty())
+      return {};
+    u8* ptr = static_cast<u8*>(Allocate(bytes.size(), 1));
+    std::memcpy(ptr, bytes.data(), bytes.size());
+    return {ptr, bytes.size()};
+  }
+
+  /// Returns the total size of all blocks that have been allocated.
+  size_t GetBytesAllocated() const { return m_bytes_allocated; }
+
+  static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+private:
+  std::vector<std::unique_ptr<u8[]>> m_blocks;
+  size_t m_block_size;
+  size_t m_current_block_size = 0;
+  size_t m_block_offset = 0;
+  size_t m_bytes_allocated = 0;
+};
+
+}  // namespace oead::util
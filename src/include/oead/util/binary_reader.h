@@ -23,6 +23,7 @@
 #include <cstring>
 #include <nonstd/span.h>
 #include <optional>
+#include <stdexcept>
 #include <type_traits>
 #include <vector>
 
@@ -33,6 +34,29 @@
 
 namespace oead::util {
 
+namespace detail {
+/// Copies `count` values of type T from `src` to `dst`, which do not need to be aligned.
+/// The values are byte swapped if `endian` is not the platform endianness; the loop is simple
+/// enough for compilers to vectorise it.
+template <typename T>
+void CopyArrayAndSwapIfNeeded(void* dst, const void* src, size_t count, Endianness endian) {
+  static_assert(std::is_trivially_copyable<T>());
+  if (count == 0)
+    return;
+  if (GetPlatformEndianness() == endian) {
+    std::memcpy(dst, src, sizeof(T) * count);
+    return;
+  }
+  auto* out = static_cast<u8*>(dst);
+  const auto* in = static_cast<const u8*>(src);
+  for (size_t i = 0; i < count; ++i) {
+    T value = util::BitCastPtr<T>(in + sizeof(T) * i);
+    SwapIfNeededInPlace(value, endian);
+    std::memcpy(out + sizeof(T) * i, &value, sizeof(T));
+  }
+}
+}  // namespace detail
+
 /// A simple binary data reader that automatically byteswaps and avoids undefined behaviour.
 class BinaryReader final {
 public:
@@ -61,6 +85,22 @@ public:
     return value;
   }
 
+  /// Reads `count` consecutive values with a single bounds check.
+  /// This is much faster than calling Read for every value.
+  template <typename T>
+  std::optional<std::vector<T>> ReadArray(size_t count,
+                                          std::optional<size_t> offset = std::nullopt) {
+    if (offset)
+      Seek(*offset);
+    static_assert(std::is_standard_layout<T>());
+    if (m_offset > m_data.size() || count > (m_data.size() - m_offset) / sizeof(T))
+      return std::nullopt;
+    std::vector<T> values(count);
+    detail::CopyArrayAndSwapIfNeeded<T>(values.data(), m_data.data() + m_offset, count, m_endian);
+    m_offset += sizeof(T) * count;
+    return values;
+  }
+
   template <bool Safe = true>
   std::optional<u32> ReadU24(std::optional<size_t> read_offset = std::nullopt) {
     if (read_offset)
@@ -123,6 +163,10 @@ template <typename Storage>
 class BinaryWriterBase {
 public:
   BinaryWriterBase(Endianness endian) : m_endian{endian} {}
+  /// Write to existing storage. If the storage is a span, it cannot grow and writing past
+  /// its end throws std::out_of_range.
+  BinaryWriterBase(Storage storage, Endianness endian)
+      : m_data{std::move(storage)}, m_endian{endian} {}
 
   /// Returns a std::vector<u8> with everything written so far, and resets the buffer.
   std::vector<u8> Finalize() { return std::move(m_data); }
@@ -137,7 +181,7 @@ public:
 
   void WriteBytes(tcb::span<const u8> bytes) {
     if (m_offset + bytes.size() > m_data.size())
-      m_data.resize(m_offset + bytes.size());
+      Resize(m_offset + bytes.size());
 
     std::memcpy(&m_data[m_offset], bytes.data(), bytes.size());
     m_offset += bytes.size();
@@ -150,6 +194,19 @@ public:
     WriteBytes({reinterpret_cast<const u8*>(&value), sizeof(value)});
   }
 
+  /// Writes consecutive values. The buffer is only resized once, and values are copied in bulk
+  /// if no byte swapping is needed.
+  template <typename T>
+  void WriteArray(tcb::span<const T> values) {
+    const size_t size = sizeof(T) * values.size();
+    if (m_offset + size > m_data.size())
+      Resize(m_offset + size);
+
+    detail::CopyArrayAndSwapIfNeeded<T>(m_data.data() + m_offset, values.data(), values.size(),
+                                        m_endian);
+    m_offset += size;
+  }
+
   void Write(std::string_view str) {
     WriteBytes({reinterpret_cast<const u8*>(str.data()), str.size()});
   }
@@ -183,15 +240,26 @@ public:
   void AlignUp(size_t n) { Seek(util::AlignUp(Tell(), n)); }
   void GrowBuffer() {
     if (m_offset > m_data.size())
-      m_data.resize(m_offset);
+      Resize(m_offset);
   }
 
 private:
+  static constexpr bool IsFixedSize = std::is_same_v<Storage, tcb::span<u8>>;
+
+  void Resize(size_t size) {
+    if constexpr (IsFixedSize)
+      throw std::out_of_range("BinaryWriter: write past the end of the buffer");
+    else
+      m_data.resize(size);
+  }
+
   Storage m_data;
   size_t m_offset = 0;
   Endianness m_endian;
 };
 
 using BinaryWriter = BinaryWriterBase<std::vector<u8>>;
+/// Writes to a fixed-size, caller-provided buffer.
+using SpanWriter = BinaryWriterBase<tcb::span<u8>>;
 
 }  // namespace oead::util
@@ -0,0 +1,276 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <oead/types.h>
+#include <oead/util/swap.h>
+
+namespace oead::util {
+
+/// A map from strings to values that is stored as a vector of items sorted by key.
+///
+/// This is an alternative to absl::btree_map<std::string, T> that is faster for lookups in small
+/// maps: every key has an 8-byte prefix (stored in a separate array) that is compared as a single
+/// integer, so lookups only compare full keys for the matching entry. Iteration order is the
+/// same as for a std::map. Inserting in key order is O(1); inserting at random positions is O(n).
+///
+/// Unlike std::map, keys are not const, but they must not be modified through iterators.
+template <typename T>
+class FlatStringMap {
+public:
+  using key_type = std::string;
+  using mapped_type = T;
+  using value_type = std::pair<std::string, T>;
+  using size_type = size_t;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  FlatStringMap() = default;
+  FlatStringMap(std::initializer_list<value_type> items) {
+    for (const auto& item : items)
+      emplace(item.first, item.second);
+  }
+
+  iterator begin() { return m_items.begin(); }
+  iterator end() { return m_items.end(); }
+  const_iterator begin() const { return m_items.begin(); }
+  const_iterator end() const { return m_items.end(); }
+  const_iterator cbegin() const { return m_items.cbegin(); }
+  const_iterator cend() const { return m_items.cend(); }
+
+  size_t size() const { return m_items.size(); }
+  bool empty() const { return m_items.empty(); }
+  void clear() {
+    m_items.clear();
+    m_prefixes.clear();
+  }
+  void reserve(size_t size) {
+    m_items.reserve(size);
+    m_prefixes.reserve(size);
+  }
+
+  iterator find(std::string_view key) { return begin() + FindIndex(key); }
+  const_iterator find(std::string_view key) const { return begin() + FindIndex(key); }
+  bool contains(std::string_view key) const { return FindIndex(key) != size(); }
+  size_t count(std::string_view key) const { return contains(key); }
+
+  iterator lower_bound(std::string_view key) { return begin() + LowerBound(key, Prefix(key)); }
+  const_iterator lower_bound(std::string_view key) const {
+    return begin() + LowerBound(key, Prefix(key));
+  }
+
+  T& at(std::string_view key) {
+    const auto it = find(key);
+    if (it == end())
+      throw std::out_of_range("FlatStringMap::at: no such key");
+    return it->second;
+  }
+  const T& at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == end())
+      throw std::out_of_range("FlatStringMap::at: no such key");
+    return it->second;
+  }
+  T& operator[](std::string_view key) { return try_emplace(key).first->second; }
+
+  /// Inserts a value if the key does not exist yet.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args) {
+    const u64 prefix = Prefix(key);
+    const size_t i = LowerBound(key, prefix);
+    if (i != size() && m_items[i].first == key)
+      return {begin() + i, false};
+    return {Insert(i, prefix, std::string(key), std::forward<Args>(args)...), true};
+  }
+
+  /// Same as try_emplace, but the hint is used to avoid a search if the key belongs there
+  /// (e.g. when inserting keys in order at the end).
+  template <typename... Args>
+  iterator try_emplace(const_iterator hint, std::string_view key, Args&&... args) {
+    const size_t i = hint - cbegin();
+    const u64 prefix = Prefix(key);
+    if (IsValidPosition(i, key, prefix))
+      return Insert(i, prefix, std::string(key), std::forward<Args>(args)...);
+    return try_emplace(key, std::forward<Args>(args)...).first;
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplace(K&& key, Args&&... args) {
+    std::string key_str(std::forward<K>(key));
+    const u64 prefix = Prefix(key_str);
+    const size_t i = LowerBound(key_str, prefix);
+    if (i != size() && m_items[i].first == key_str)
+      return {begin() + i, false};
+    return {Insert(i, prefix, std::move(key_str), std::forward<Args>(args)...), true};
+  }
+
+  template <typename K, typename... Args>
+  iterator emplace_hint(const_iterator hint, K&& key, Args&&... args) {
+    std::string key_str(std::forward<K>(key));
+    const size_t i = hint - cbegin();
+    const u64 prefix = Prefix(key_str);
+    if (IsValidPosition(i, key_str, prefix))
+      return Insert(i, prefix, std::move(key_str), std::forward<Args>(args)...);
+    return emplace(std::move(key_str), std::forward<Args>(args)...).first;
+  }
+
+  std::pair<iterator, bool> insert(value_type item) {
+    return emplace(std::move(item.first), std::move(item.second));
+  }
+
+  template <typename V>
+  std::pair<iterator, bool> insert_or_assign(std::string_view key, V&& value) {
+    auto result = try_emplace(key, std::forward<V>(value));
+    if (!result.second)
+      result.first->second = std::forward<V>(value);
+    return result;
+  }
+
+  iterator erase(const_iterator it) {
+    const size_t i = it - cbegin();
+    m_prefixes.erase(m_prefixes.begin() + i);
+    return m_items.erase(it);
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    m_prefixes.erase(m_prefixes.begin() + (first - cbegin()),
+                     m_prefixes.begin() + (last - cbegin()));
+    return m_items.erase(first, last);
+  }
+  size_t erase(std::string_view key) {
+    const size_t i = FindIndex(key);
+    if (i == size())
+      return 0;
+    erase(cbegin() + i);
+    return 1;
+  }
+
+  friend bool operator==(const FlatStringMap& lhs, const FlatStringMap& rhs) {
+    return lhs.m_items == rhs.m_items;
+  }
+  friend bool operator!=(const FlatStringMap& lhs, const FlatStringMap& rhs) {
+    return !(lhs == rhs);
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const FlatStringMap& self) {
+    return H::combine(H::combine_contiguous(std::move(h), self.m_items.data(), self.size()),
+                      self.size());
+  }
+
+private:
+  /// Returns the first 8 bytes of a key as a big endian integer (padded with zeroes),
+  /// so that comparing prefixes is consistent with comparing keys.
+  static u64 Prefix(std::string_view key) {
+    u64 prefix = 0;
+    if (key.size() >= sizeof(prefix)) {
+      std::memcpy(&prefix, key.data(), sizeof(prefix));
+      return SwapIfNeeded(prefix, Endianness::Big);
+    }
+    for (size_t i = 0; i < key.size(); ++i)
+      prefix |= u64(u8(key[i])) << (56 - 8 * i);
+    return prefix;
+  }
+
+  /// Returns whether a key is equal to the key of the specified item,
+  /// assuming that both keys have the same prefix.
+  bool KeyEquals(size_t i, std::string_view key) const {
+    const std::string& other = m_items[i].first;
+    if (other.size() != key.size())
+      return false;
+    return key.size() <= sizeof(u64) ||
+           std::memcmp(other.data() + sizeof(u64), key.data() + sizeof(u64),
+                       key.size() - sizeof(u64)) == 0;
+  }
+
+  /// Returns the index of the first item whose prefix is not less than the specified prefix.
+  size_t PrefixLowerBound(u64 prefix) const {
+    if (size() > LinearSearchMaxSize)
+      return std::lower_bound(m_prefixes.begin(), m_prefixes.end(), prefix) - m_prefixes.begin();
+    // Branchless (and vectorizable) since the prefixes are sorted.
+    size_t i = 0;
+    for (const u64 other : m_prefixes)
+      i += other < prefix;
+    return i;
+  }
+
+  size_t LowerBound(std::string_view key, u64 prefix) const {
+    size_t i = PrefixLowerBound(prefix);
+    // Keys that are at most 8 bytes long are fully described by their prefix
+    // (except for trailing null characters), so this loop rarely runs more than once.
+    while (i != size() && m_prefixes[i] == prefix && std::string_view(m_items[i].first) < key)
+      ++i;
+    return i;
+  }
+
+  size_t FindIndex(std::string_view key) const {
+    const u64 prefix = Prefix(key);
+    for (size_t i = PrefixLowerBound(prefix); i != size() && m_prefixes[i] == prefix; ++i) {
+      if (KeyEquals(i, key))
+        return i;
+    }
+    return size();
+  }
+
+  /// Returns whether a new key can be inserted at position i without breaking the ordering.
+  bool IsValidPosition(size_t i, std::string_view key, u64 prefix) const {
+    const auto less = [](u64 a, std::string_view a_key, u64 b, std::string_view b_key) {
+      return a < b || (a == b && a_key < b_key);
+    };
+    if (i > size())
+      return false;
+    if (i != 0 && !less(m_prefixes[i - 1], m_items[i - 1].first, prefix, key))
+      return false;
+    if (i != size() && !less(prefix, key, m_prefixes[i], m_items[i].first))
+      return false;
+    return true;
+  }
+
+  template <typename... Args>
+  iterator Insert(size_t i, u64 prefix, std::string&& key, Args&&... args) {
+    const auto it =
+        m_items.emplace(begin() + i, std::piecewise_construct,
+                        std::forward_as_tuple(std::move(key)),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+    try {
+      m_prefixes.insert(m_prefixes.begin() + i, prefix);
+    } catch (...) {
+      m_items.erase(it);
+      throw;
+    }
+    return it;
+  }
+
+  static constexpr size_t LinearSearchMaxSize = 8;
+
+  std::vector<value_type> m_items;
+  std::vector<u64> m_prefixes;
+};
+
+}  // namespace oead::util
@@ -19,14 +19,26 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string_view>
 
 #include <oead/types.h>
 
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define OEAD_HAS_IS_CONSTANT_EVALUATED
+#endif
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define OEAD_HAS_IS_CONSTANT_EVALUATED
+#endif
+
 namespace oead::util {
 
-template <typename CharType = u8>
-constexpr u32 crc32(const CharType* data, std::size_t size) {
+namespace detail {
+/// Bit-at-a-time CRC32. This is the reference implementation, and is used for constant
+/// expressions (such as aamp::Name literals).
+template <typename CharType>
+constexpr u32 Crc32Reference(const CharType* data, std::size_t size) {
   u32 crc = 0xFFFFFFFF;
   for (std::size_t i = 0; i < size; ++i) {
     crc ^= u8(data[i]);
@@ -38,6 +50,25 @@ constexpr u32 crc32(const CharType* data, std::size_t size) {
   return ~crc;
 }
 
+/// Table-based or hardware-accelerated CRC32. The fastest implementation that is supported
+/// by the CPU is selected (and checked against the reference implementation) on first use.
+u32 Crc32Runtime(const void* data, std::size_t size);
+}  // namespace detail
+
+/// Computes the CRC32 (as used by zlib) of some data.
+///
+/// In constant expressions, this uses the reference implementation. At runtime, it dispatches
+/// to slicing-by-16 tables, PCLMULQDQ folding (x86-64) or CRC32 instructions (ARMv8).
+template <typename CharType = u8>
+constexpr u32 crc32(const CharType* data, std::size_t size) {
+  static_assert(sizeof(CharType) == 1);
+#ifdef OEAD_HAS_IS_CONSTANT_EVALUATED
+  if (!__builtin_is_constant_evaluated())
+    return detail::Crc32Runtime(data, size);
+#endif
+  return detail::Crc32Reference(data, size);
+}
+
 constexpr u32 crc32(std::string_view str) {
   return crc32<char>(str.data(), str.size());
 }
@@ -0,0 +1,65 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <oead/types.h>
+
+namespace oead::util {
+
+/// Returns the offset from `from` to `to`, or 0 if `to` is null.
+inline u64 MakeOffset(const void* from, const void* to) {
+  if (!to)
+    return 0;
+  return u64(reinterpret_cast<uintptr_t>(to) - reinterpret_cast<uintptr_t>(from));
+}
+
+/// Inverse of MakeOffset.
+inline const void* ResolveOffset(const void* from, u64 offset) {
+  if (offset == 0)
+    return nullptr;
+  return reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(from) + uintptr_t(offset));
+}
+
+/// A pointer that is stored as an offset from its own address.
+///
+/// Data structures that only use offset pointers are position-independent: a block of memory
+/// that contains all of them can be written to a file and mapped at any address. Copying an
+/// offset pointer rebases it, so it still points to the same object.
+template <typename T>
+class OffsetPtr {
+public:
+  OffsetPtr() = default;
+  OffsetPtr(T* ptr) { *this = ptr; }
+  OffsetPtr(const OffsetPtr& other) { *this = other.Get(); }
+  OffsetPtr& operator=(const OffsetPtr& other) { return *this = other.Get(); }
+  OffsetPtr& operator=(T* ptr) {
+    m_offset = MakeOffset(this, ptr);
+    return *this;
+  }
+
+  T* Get() const { return static_cast<T*>(const_cast<void*>(ResolveOffset(this, m_offset))); }
+
+private:
+  u64 m_offset = 0;
+};
+
+}  // namespace oead::util
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace oead::util {
+
+/// Returns the number of worker threads to use if the caller did not specify any.
+inline size_t GetDefaultNumThreads() {
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+/// Calls fn(i) for every i in [0, count) using up to num_threads threads
+/// (0 means one thread per hardware thread). Work items are handed out dynamically,
+/// so fn may be called in any order and from any thread, including the calling thread.
+///
+/// If any call throws, the remaining items are skipped and the first exception is rethrown
+/// once all threads have stopped.
+template <typename Fn>
+void ParallelFor(size_t count, Fn fn, size_t num_threads = 0) {
+  if (num_threads == 0)
+    num_threads = GetDefaultNumThreads();
+  num_threads = std::min(num_threads, count);
+
+  if (num_threads <= 1) {
+    for (size_t i = 0; i < count; ++i)
+      fn(i);
+    return;
+  }
+
+  std::atomic<size_t> next_index{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr exception;
+  std::mutex exception_mutex;
+
+  const auto worker = [&] {
+    while (!failed.load(std::memory_order_relaxed)) {
+      const size_t i = next_index.fetch_add(1, std::memory_order_relaxed);
+      if (i >= count)
+        return;
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard lock{exception_mutex};
+        if (!exception)
+          exception = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (size_t i = 0; i < num_threads - 1; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+}  // namespace oead::util
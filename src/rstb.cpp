@@ -0,0 +1,338 @@
+/**
+ * Copyright (C) 2020 leoetlino
+ *
+ * This file is part of oead.
+ *
+ * oead is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * oead is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with oead.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include <cmrc/cmrc.hpp>
+
+#include <oead/errors.h>
+#include <oead/rstb.h>
+#include <oead/sarc.h>
+#include <oead/util/align.h>
+#include <oead/util/binary_reader.h>
+#include <oead/util/hash.h>
+#include <oead/util/magic_utils.h>
+#include <oead/util/parallel.h>
+#include <oead/util/string_utils.h>
+#include <oead/yaz0.h>
+
+CMRC_DECLARE(oead::res);
+
+namespace oead::rstb {
+
+namespace {
+
+constexpr auto RstbMagic = util::MakeMagic("RSTB");
+constexpr auto SarcMagic = util::MakeMagic("SARC");
+
+struct ResHeader {
+  std::array<char, 4> magic;
+  u32 num_crc_entries;
+  u32 num_name_entries;
+  OEAD_DEFINE_FIELDS(ResHeader, magic, num_crc_entries, num_name_entries);
+};
+static_assert(sizeof(ResHeader) == 0xC);
+
+struct ResCrcEntry {
+  u32 crc32;
+  u32 size;
+  OEAD_DEFINE_FIELDS(ResCrcEntry, crc32, size);
+};
+static_assert(sizeof(ResCrcEntry) == 0x8);
+
+constexpr size_t NameEntrySize = ResourceSizeTable::MaxNameLength + sizeof(u32);
+
+/// Size of the resource unit (res::ResourceUnit) that is allocated for every resource.
+constexpr u32 ResourceUnitSizeNx = 0x168;
+constexpr u32 ResourceUnitSizeWiiU = 0xe4;
+
+}  // namespace
+
+ResourceSizeTable ResourceSizeTable::FromBinary(tcb::span<const u8> data,
+                                                util::Endianness endian) {
+  util::BinaryReader reader{data, endian};
+  ResourceSizeTable table;
+
+  size_t num_crc_entries = data.size() / sizeof(ResCrcEntry);
+  size_t num_name_entries = 0;
+  // Very old tables do not have any header or name table.
+  const auto header = reader.Read<ResHeader>();
+  if (header && header->magic == RstbMagic) {
+    num_crc_entries = header->num_crc_entries;
+    num_name_entries = header->num_name_entries;
+  } else {
+    reader.Seek(0);
+    if (data.size() % sizeof(ResCrcEntry) != 0)
+      throw InvalidDataError("Invalid RSTB size");
+  }
+
+  const size_t expected_size =
+      reader.Tell() + sizeof(ResCrcEntry) * num_crc_entries + NameEntrySize * num_name_entries;
+  if (data.size() < expected_size)
+    throw InvalidDataError("RSTB is truncated");
+
+  for (size_t i = 0; i < num_crc_entries; ++i) {
+    const auto entry = *reader.Read<ResCrcEntry>();
+    table.crc_map.insert_or_assign(entry.crc32, entry.size);
+  }
+
+  for (size_t i = 0; i < num_name_entries; ++i) {
+    const size_t offset = reader.Tell();
+    auto name = reader.ReadString(offset, MaxNameLength);
+    const u32 size = *reader.Read<u32>(offset + MaxNameLength);
+    table.name_map.insert_or_assign(std::move(name), size);
+  }
+
+  return table;
+}
+
+std::vector<u8> ResourceSizeTable::ToBinary(util::Endianness endian) const {
+  util::BinaryWriter writer{endian};
+  writer.Buffer().reserve(sizeof(ResHeader) + sizeof(ResCrcEntry) * crc_map.size() +
+                          NameEntrySize * name_map.size());
+
+  ResHeader header{};
+  header.magic = RstbMagic;
+  header.num_crc_entries = crc_map.size();
+  header.num_name_entries = name_map.size();
+  writer.Write(header);
+
+  // The game performs a binary search on the CRC table, so entries must be sorted by hash.
+  for (const auto& [crc, size] : crc_map)
+    writer.Write(ResCrcEntry{crc, size});
+
+  for (const auto& [name, size] : name_map) {
+    if (name.size() >= MaxNameLength)
+      throw std::invalid_argument("RSTB name is too long: " + name);
+    const size_t offset = writer.Tell();
+    writer.Write(name);
+    writer.Seek(offset + MaxNameLength);
+    writer.GrowBuffer();
+    writer.Write<u32>(size);
+  }
+
+  return writer.Finalize();
+}
+
+std::optional<u32> ResourceSizeTable::GetSize(std::string_view name) const {
+  if (const auto it = name_map.find(name); it != name_map.end())
+    return it->second;
+  if (const auto it = crc_map.find(util::crc32(name)); it != crc_map.end())
+    return it->second;
+  return std::nullopt;
+}
+
+void ResourceSizeTable::SetSize(std::string_view name, u32 size) {
+  if (const auto it = name_map.find(name); it != name_map.end()) {
+    it->second = size;
+    return;
+  }
+  crc_map.insert_or_assign(util::crc32(name), size);
+}
+
+void ResourceSizeTable::DeleteEntry(std::string_view name) {
+  if (name_map.erase(std::string(name)) != 0)
+    return;
+  crc_map.erase(util::crc32(name));
+}
+
+static std::optional<u32> ParseFactoryNumber(std::string_view field) {
+  if (field == "complex")
+    return std::nullopt;
+  const std::string str{field};
+  char* end = nullptr;
+  const auto value = std::strtoul(str.c_str(), &end, 0);
+  if (end == str.c_str() || *end != '\0')
+    throw std::logic_error("Invalid number in factory info: " + str);
+  return static_cast<u32>(value);
+}
+
+static const auto& GetFactoryInfoMap() {
+  static auto map = [] {
+    absl::flat_hash_map<std::string_view, FactoryInfo> map;
+    const auto fs = cmrc::oead::res::get_filesystem();
+    const auto info_tsv_file = fs.open("data/botw_resource_factory_info.tsv");
+    bool is_header = true;
+    const auto parse_line = [&](std::string_view line) {
+      if (std::exchange(is_header, false))
+        return;
+
+      const std::vector<std::string_view> fields = absl::StrSplit(line, '\t');
+      if (fields.size() < 9)
+        throw std::logic_error("Invalid factory info line: " + std::string(line));
+
+      FactoryInfo info{};
+      info.size_nx = ParseFactoryNumber(fields[1]).value();
+      info.size_wiiu = ParseFactoryNumber(fields[2]).value();
+      info.alignment = ParseFactoryNumber(fields[3]).value();
+      info.parse_size_nx = ParseFactoryNumber(fields[4]);
+      info.parse_size_wiiu = ParseFactoryNumber(fields[5]);
+      if (!absl::SimpleAtof(fields[7], &info.multiplier))
+        throw std::logic_error("Invalid multiplier in factory info: " + std::string(line));
+      info.constant = ParseFactoryNumber(fields[8]).value();
+
+      // Some rows describe several factories ("hks, lua"), and factories may handle more
+      // than one extension.
+      for (const std::string_view name : absl::StrSplit(fields[0], ", ")) {
+        info.name = name;
+        map.insert_or_assign(name, info);
+      }
+      for (const std::string_view ext : absl::StrSplit(fields[6], ", ", absl::SkipEmpty()))
+        map.insert_or_assign(ext, info);
+    };
+    util::SplitStringByLine({info_tsv_file.begin(), info_tsv_file.size()}, parse_line);
+    return map;
+  }();
+  return map;
+}
+
+static const FactoryInfo* FindFactoryInfo(std::string_view extension) {
+  const auto& map = GetFactoryInfoMap();
+  const auto it = map.find(extension);
+  return it == map.end() ? nullptr : &it->second;
+}
+
+const FactoryInfo& GetFactoryInfo(std::string_view extension) {
+  if (const auto* info = FindFactoryInfo(extension))
+    return *info;
+  return *FindFactoryInfo("*");
+}
+
+/// Returns the full extension (everything after the first dot in the file name, e.g. Tex1.bfres)
+/// and the last extension.
+static std::pair<std::string_view, std::string_view> GetExtensions(std::string_view name) {
+  const auto slash_pos = name.rfind('/');
+  const auto file_name = slash_pos == std::string_view::npos ? name : name.substr(slash_pos + 1);
+  const auto first_dot_pos = file_name.find('.');
+  const auto last_dot_pos = file_name.rfind('.');
+  if (first_dot_pos == std::string_view::npos)
+    return {};
+  return {file_name.substr(first_dot_pos + 1), file_name.substr(last_dot_pos + 1)};
+}
+
+std::string GetCanonicalName(std::string_view name) {
+  std::string canonical_name{name};
+  const auto [full_ext, ext] = GetExtensions(name);
+  if (ext.size() > 1 && ext[0] == 's' && !FindFactoryInfo(ext) && FindFactoryInfo(ext.substr(1)))
+    canonical_name.erase(canonical_name.size() - ext.size(), 1);
+  return canonical_name;
+}
+
+std::optional<u32> EstimateSize(std::string_view name, size_t file_size, util::Endianness endian,
+                                bool allow_heuristics) {
+  const std::string canonical_name = GetCanonicalName(name);
+  const auto [full_ext, ext] = GetExtensions(canonical_name);
+  const FactoryInfo* info = FindFactoryInfo(full_ext);
+  if (!info)
+    info = &GetFactoryInfo(ext);
+
+  const bool wiiu = endian == util::Endianness::Big;
+  const std::optional<u32> parse_size = wiiu ? info->parse_size_wiiu : info->parse_size_nx;
+  if (!parse_size && !allow_heuristics)
+    return std::nullopt;
+
+  const u64 rounded_size = util::AlignUp<u64>(file_size, 32);
+  u64 size = static_cast<u64>(rounded_size * double(info->multiplier)) + info->constant;
+  size += wiiu ? ResourceUnitSizeWiiU : ResourceUnitSizeNx;
+  size += wiiu ? info->size_wiiu : info->size_nx;
+  size += parse_size.value_or(0);
+
+  if (size > std::numeric_limits<u32>::max())
+    return std::nullopt;
+  return static_cast<u32>(size);
+}
+
+std::optional<u32> EstimateSize(std::string_view name, tcb::span<const u8> data,
+                                util::Endianness endian, bool allow_heuristics) {
+  const auto header = yaz0::GetHeader(data);
+  const size_t file_size = header ? header->uncompressed_size : data.size();
+  return EstimateSize(name, file_size, endian, allow_heuristics);
+}
+
+static bool IsSarc(tcb::span<const u8> data) {
+  return data.size() >= SarcMagic.size() &&
+         std::memcmp(data.data(), SarcMagic.data(), SarcMagic.size()) == 0;
+}
+
+/// Checks whether Yaz0 compressed data contains an archive without decompressing it.
+/// Nothing can be copied from the (empty) output buffer at the start of the stream,
+/// so the first four chunks are always literal bytes.
+static bool IsYaz0CompressedSarc(tcb::span<const u8> data) {
+  constexpr size_t GroupHeaderOffset = sizeof(yaz0::Header);
+  if (data.size() < GroupHeaderOffset + 1 + SarcMagic.size())
+    return false;
+  return (data[GroupHeaderOffset] & 0xF0) == 0xF0 && IsSarc(data.subspan(GroupHeaderOffset + 1));
+}
+
+static void EstimateFileSizes(const Sarc::File& file, util::Endianness endian,
+                              bool allow_heuristics, std::vector<ArchiveEntry>& entries) {
+  // Files that are not referenced by name cannot be loaded by the resource system.
+  if (file.name.empty())
+    return;
+
+  entries.push_back({GetCanonicalName(file.name),
+                     EstimateSize(file.name, file.data, endian, allow_heuristics)});
+
+  // Only nested archives need to be decompressed; other files are sized using the Yaz0 header.
+  std::vector<u8> decompressed;
+  tcb::span<const u8> data = file.data;
+  if (yaz0::GetHeader(data)) {
+    if (!IsYaz0CompressedSarc(data))
+      return;
+    decompressed = yaz0::Decompress(data);
+    data = decompressed;
+  }
+  if (!IsSarc(data))
+    return;
+
+  const Sarc archive{data};
+  for (const Sarc::File& child : archive.GetFiles())
+    EstimateFileSizes(child, endian, allow_heuristics, entries);
+}
+
+std::vector<ArchiveEntry> EstimateArchiveSizes(const Sarc& archive, util::Endianness endian,
+                                               bool allow_heuristics, size_t num_threads) {
+  // Sarc is not thread-safe (its reader keeps track of the current offset),
+  // so look up all files before dispatching work.
+  std::vector<Sarc::File> files;
+  files.reserve(archive.GetNumFiles());
+  for (const Sarc::File& file : archive.GetFiles())
+    files.push_back(file);
+
+  std::vector<std::vector<ArchiveEntry>> results(files.size());
+  util::ParallelFor(
+      files.size(),
+      [&](size_t i) { EstimateFileSizes(files[i], endian, allow_heuristics, results[i]); },
+      num_threads);
+
+  std::vector<ArchiveEntry> entries;
+  for (auto& result : results)
+    std::move(result.begin(), result.end(), std::back_inserter(entries));
+  return entries;
+}
+
+}  // namespace oead::rstb
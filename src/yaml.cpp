@@ -19,6 +19,8 @@
 
 #include "yaml.h"
 
+#include <algorithm>
+#include <array>
 #include <absl/strings/match.h>
 #include <absl/strings/numbers.h>
 #include <absl/strings/str_format.h>
@@ -31,22 +33,6 @@
 
 namespace oead::yml {
 
-using namespace std::string_view_literals;
-
-std::string FormatFloat(float value) {
-  std::string repr = absl::StrFormat("%.9g", value);
-  if (!absl::StrContains(repr, ".") && !absl::StrContains(repr, "e"))
-    repr += ".0"sv;
-  return repr;
-}
-
-std::string FormatDouble(double value) {
-  std::string repr = absl::StrFormat("%.17g", value);
-  if (!absl::StrContains(repr, ".") && !absl::StrContains(repr, "e"))
-    repr += ".0"sv;
-  return repr;
-}
-
 static bool IsInfinity(std::string_view input) {
   return util::IsAnyOf(input, ".inf", ".Inf", ".INF") ||
          util::IsAnyOf(input, "+.inf", "+.Inf", "+.INF");
@@ -79,6 +65,60 @@ static std::optional<TagBasedType> GetTagBasedType(const std::string_view tag,
   return std::nullopt;
 }
 
+/// Equivalent to checking that std::strtoull(value, &end, 0) consumed the entire string,
+/// but does not require a null-terminated string and avoids locale-aware libc code.
+static std::optional<u64> ParseInteger(const std::string_view value) {
+  size_t i = 0;
+  while (i < value.size() && util::IsAnyOf(value[i], ' ', '\t', '\n', '\v', '\f', '\r'))
+    ++i;
+
+  bool negative = false;
+  if (i < value.size() && (value[i] == '+' || value[i] == '-')) {
+    negative = value[i] == '-';
+    ++i;
+  }
+
+  const auto digit_value = [](char c) -> int {
+    if (c >= '0' && c <= '9')
+      return c - '0';
+    if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+    return 16;
+  };
+
+  int base = 10;
+  if (i < value.size() && value[i] == '0') {
+    // A "0x" prefix is only consumed if it is followed by a hex digit.
+    if (i + 2 < value.size() && (value[i + 1] == 'x' || value[i + 1] == 'X') &&
+        digit_value(value[i + 2]) < 16) {
+      base = 16;
+      i += 2;
+    } else {
+      base = 8;
+    }
+  }
+
+  const size_t digits_start = i;
+  u64 result = 0;
+  bool overflow = false;
+  for (; i < value.size(); ++i) {
+    const int digit = digit_value(value[i]);
+    if (digit >= base)
+      break;
+    if (result > (std::numeric_limits<u64>::max() - digit) / base)
+      overflow = true;
+    result = result * base + digit;
+  }
+
+  if (i == digits_start || i != value.size())
+    return std::nullopt;
+  if (overflow)
+    return std::numeric_limits<u64>::max();
+  return negative ? u64(-result) : result;
+}
+
 // Deliberately not compliant to the YAML 1.2 standard to get rid of unused features
 // that harm performance.
 Scalar ParseScalar(const std::string_view tag, const std::string_view value, bool is_quoted,
@@ -106,10 +146,8 @@ Scalar ParseScalar(const std::string_view tag, const std::string_view value, boo
 
   // Integer conversions. Not YAML 1.2 compliant: base 8 is not supported as it's not useful.
   if (tag_type == TagBasedType::Int || (!tag_type && !value.empty() && !is_quoted)) {
-    char* int_str_end = nullptr;
-    const u64 maybe_u64 = std::strtoull(value.data(), &int_str_end, 0);
-    if (value.data() + value.size() == int_str_end)
-      return maybe_u64;
+    if (const auto maybe_u64 = ParseInteger(value))
+      return *maybe_u64;
     if (tag_type == TagBasedType::Int)
       throw ParseError("Failed to parse value that was explicitly marked as integer");
   }
@@ -134,12 +172,8 @@ bool StringNeedsQuotes(const std::string_view value) {
       return true;
   }
 
-  if (!value.empty()) {
-    char* int_str_end = nullptr;
-    std::strtoull(value.data(), &int_str_end, 0);
-    if (value.data() + value.size() == int_str_end)
-      return true;
-  }
+  if (ParseInteger(value))
+    return true;
 
   if (value == "null")
     return true;
@@ -181,21 +215,905 @@ void InitRymlIfNeeded() {
   });
 }
 
-LibyamlEmitter::LibyamlEmitter() {
-  yaml_emitter_initialize(&m_emitter);
-  yaml_emitter_set_unicode(&m_emitter, 1);
-  yaml_emitter_set_width(&m_emitter, 120);
+ryml::Tree& ParseIntoThreadLocalTree(std::string_view text) {
+  InitRymlIfNeeded();
+  static thread_local ryml::Tree s_tree;
+  s_tree.clear();
+  s_tree.clear_arena();
+  ryml::parse(StrViewToRymlSubstr(text), &s_tree);
+  return s_tree;
 }
 
-LibyamlEmitter::~LibyamlEmitter() {
-  yaml_emitter_delete(&m_emitter);
+// The emitter below follows the structure of libyaml's emitter (emitter.c) so that the output
+// stays identical. Features that oead does not use (anchors, aliases, block scalars,
+// directives, explicit document markers and canonical output) are left out.
+
+namespace {
+
+constexpr int BestIndent = 2;
+constexpr int BestWidth = 120;
+
+u8 At(std::string_view str, size_t pos) {
+  return pos < str.size() ? u8(str[pos]) : 0;
 }
 
-void LibyamlEmitter::Emit(yaml_event_t& event, bool ignore_errors) {
-  if (!yaml_emitter_emit(&m_emitter, &event) && !ignore_errors) {
-    throw std::runtime_error("Emit failed: " +
-                             std::string(m_emitter.problem ? m_emitter.problem : "unknown"));
+size_t CharWidth(u8 c) {
+  if ((c & 0x80) == 0x00)
+    return 1;
+  if ((c & 0xE0) == 0xC0)
+    return 2;
+  if ((c & 0xF0) == 0xE0)
+    return 3;
+  if ((c & 0xF8) == 0xF0)
+    return 4;
+  // Invalid lead byte. Treat it as a single byte to guarantee progress.
+  return 1;
+}
+
+constexpr char HexDigits[] = "0123456789ABCDEF";
+
+/// Returns the short escape sequence for a character in double-quoted scalars, or 0 if none.
+char GetEscapeCharacter(u32 code_point) {
+  switch (code_point) {
+  case 0x00:
+    return '0';
+  case 0x07:
+    return 'a';
+  case 0x08:
+    return 'b';
+  case 0x09:
+    return 't';
+  case 0x0A:
+    return 'n';
+  case 0x0B:
+    return 'v';
+  case 0x0C:
+    return 'f';
+  case 0x0D:
+    return 'r';
+  case 0x1B:
+    return 'e';
+  case 0x22:
+    return '"';
+  case 0x5C:
+    return '\\';
+  case 0x85:
+    return 'N';
+  case 0xA0:
+    return '_';
+  case 0x2028:
+    return 'L';
+  case 0x2029:
+    return 'P';
+  default:
+    return 0;
   }
 }
 
+/// Appends ".0" to a formatted number if it would otherwise look like an integer.
+/// The buffer must have room for two more characters.
+std::string_view AddDecimalPointIfNeeded(char* buffer, int size) {
+  const std::string_view repr{buffer, size_t(size)};
+  if (!absl::StrContains(repr, ".") && !absl::StrContains(repr, "e")) {
+    buffer[size++] = '.';
+    buffer[size++] = '0';
+  }
+  return {buffer, size_t(size)};
+}
+
+bool IsAlpha(u8 c) {
+  return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+         c == '_' || c == '-';
+}
+
+bool IsPrintable(std::string_view str, size_t pos) {
+  const u8 c = At(str, pos);
+  if (c < 0x80)
+    return c == 0x0A || (c >= 0x20 && c <= 0x7E);
+  const u8 c1 = At(str, pos + 1);
+  const u8 c2 = At(str, pos + 2);
+  return c == 0x0A || (c >= 0x20 && c <= 0x7E) || (c == 0xC2 && c1 >= 0xA0) ||
+         (c > 0xC2 && c < 0xED) || (c == 0xED && c1 < 0xA0) || c == 0xEE ||
+         (c == 0xEF && !(c1 == 0xBB && c2 == 0xBF) && !(c1 == 0xBF && (c2 == 0xBE || c2 == 0xBF)));
+}
+
+bool IsBom(std::string_view str, size_t pos) {
+  return At(str, pos) == 0xEF && At(str, pos + 1) == 0xBB && At(str, pos + 2) == 0xBF;
+}
+
+bool IsBreak(std::string_view str, size_t pos) {
+  const u8 c = At(str, pos);
+  if (c < 0x80)
+    return c == '\r' || c == '\n';
+  return (c == 0xC2 && At(str, pos + 1) == 0x85) ||
+         (c == 0xE2 && At(str, pos + 1) == 0x80 &&
+          (At(str, pos + 2) == 0xA8 || At(str, pos + 2) == 0xA9));
+}
+
+bool IsSpace(std::string_view str, size_t pos) {
+  return At(str, pos) == ' ';
+}
+
+bool IsBlankZ(std::string_view str, size_t pos) {
+  const u8 c = At(str, pos);
+  return c == ' ' || c == '\t' || c == '\0' || IsBreak(str, pos);
+}
+
+/// Characters that never affect how a scalar can be written.
+constexpr auto SimpleCharacters = [] {
+  std::array<bool, 256> table{};
+  for (int c = '0'; c <= '9'; ++c)
+    table[c] = true;
+  for (int c = 'A'; c <= 'Z'; ++c)
+    table[c] = true;
+  for (int c = 'a'; c <= 'z'; ++c)
+    table[c] = true;
+  table['_'] = table['.'] = table['-'] = table['/'] = true;
+  return table;
+}();
+
+/// Returns whether a scalar only contains simple characters and does not start with
+/// an indicator, in which case it can be written in any style.
+bool IsSimpleScalar(std::string_view value) {
+  if (value.empty())
+    return false;
+  // A leading dash is only an indicator if it is followed by a space or part of "---".
+  const u8 first = value[0];
+  if (first == '.' || (first == '-' && (value.size() == 1 || value[1] == '-')))
+    return false;
+  return std::all_of(value.begin(), value.end(), [](char c) { return SimpleCharacters[u8(c)]; });
+}
+
+size_t CountChars(std::string_view str) {
+  return std::count_if(str.begin(), str.end(), [](char c) { return (u8(c) & 0xC0) != 0x80; });
+}
+
+}  // namespace
+
+void Emitter::EmitScalar(std::string_view value, bool plain_implicit, bool quoted_implicit,
+                         std::string_view tag) {
+  Event event{Event::Type::Scalar};
+  event.tag = tag;
+  event.value = value;
+  event.plain_implicit = plain_implicit;
+  event.quoted_implicit = quoted_implicit;
+  event.scalar_style = value.empty() ? ScalarStyle::SingleQuoted : ScalarStyle::Any;
+  Push(event);
+}
+
+void Emitter::EmitFloat(float v, std::string_view tag) {
+  char buffer[32];
+  const int size = absl::SNPrintF(buffer, sizeof(buffer), "%.9g", v);
+  EmitScalar(AddDecimalPointIfNeeded(buffer, size), true, false, tag);
+}
+
+void Emitter::EmitDouble(double v, std::string_view tag) {
+  char buffer[40];
+  const int size = absl::SNPrintF(buffer, sizeof(buffer), "%.17g", v);
+  EmitScalar(AddDecimalPointIfNeeded(buffer, size), false, false, tag);
+}
+
+void Emitter::BeginSequence(std::string_view tag, Style style) {
+  Event event{Event::Type::SequenceStart};
+  event.tag = tag;
+  event.style = style;
+  Push(event);
+}
+
+void Emitter::EndSequence() {
+  Push(Event{Event::Type::SequenceEnd});
+}
+
+void Emitter::BeginMapping(std::string_view tag, Style style) {
+  Event event{Event::Type::MappingStart};
+  event.tag = tag;
+  event.style = style;
+  Push(event);
+}
+
+void Emitter::EndMapping() {
+  Push(Event{Event::Type::MappingEnd});
+}
+
+Emitter Emitter::Fork() {
+  if (m_pending_start) {
+    // The collection is not empty, so its start event can be processed now.
+    const Event start = *m_pending_start;
+    m_pending_start.reset();
+    m_next_is_end = false;
+    Process(start);
+  }
+  if (!util::IsAnyOf(m_state, State::BlockSequenceFirstItem, State::BlockSequenceItem,
+                     State::BlockMappingFirstKey, State::BlockMappingKey)) {
+    throw std::logic_error("Emitter: can only fork in a block collection");
+  }
+  // Every item of a block collection starts with an indent. If something has already been
+  // written on the current line, that indent is always a line break followed by spaces,
+  // no matter what the rest of the line contains.
+  if (m_indention)
+    throw std::logic_error("Emitter: can only fork after a line with content");
+
+  std::string output = std::move(m_output);
+  m_output.clear();
+  Emitter fork{*this};
+  m_output = std::move(output);
+  return fork;
+}
+
+void Emitter::Join(Emitter&& fork) {
+  if (m_pending_start || m_indention || fork.m_pending_start ||
+      fork.m_states.size() != m_states.size()) {
+    throw std::logic_error("Emitter: cannot join an incomplete fork");
+  }
+  std::string output = std::move(m_output);
+  output += fork.m_output;
+  *this = std::move(fork);
+  m_output = std::move(output);
+}
+
+std::string Emitter::Finish() {
+  if (m_state != State::DocumentEnd || m_pending_start)
+    throw std::logic_error("Emitter: document is incomplete");
+  WriteIndent();
+  return std::move(m_output);
+}
+
+void Emitter::Push(const Event& event) {
+  if (m_pending_start) {
+    const Event start = *m_pending_start;
+    m_pending_start.reset();
+    m_next_is_end =
+        util::IsAnyOf(event.type, Event::Type::SequenceEnd, Event::Type::MappingEnd);
+    Process(start);
+  }
+
+  if (util::IsAnyOf(event.type, Event::Type::SequenceStart, Event::Type::MappingStart))
+    m_pending_start = event;
+  else
+    Process(event);
+}
+
+void Emitter::Process(const Event& event) {
+  AnalyzeEvent(event);
+  switch (m_state) {
+  case State::DocumentContent:
+    m_states.push_back(State::DocumentEnd);
+    return EmitNode(event, false, false);
+  case State::DocumentEnd:
+    throw std::logic_error("Emitter: expected nothing after the root node");
+  case State::FlowSequenceFirstItem:
+    return EmitFlowSequenceItem(event, true);
+  case State::FlowSequenceItem:
+    return EmitFlowSequenceItem(event, false);
+  case State::FlowMappingFirstKey:
+    return EmitFlowMappingKey(event, true);
+  case State::FlowMappingKey:
+    return EmitFlowMappingKey(event, false);
+  case State::FlowMappingSimpleValue:
+    return EmitFlowMappingValue(event, true);
+  case State::FlowMappingValue:
+    return EmitFlowMappingValue(event, false);
+  case State::BlockSequenceFirstItem:
+    return EmitBlockSequenceItem(event, true);
+  case State::BlockSequenceItem:
+    return EmitBlockSequenceItem(event, false);
+  case State::BlockMappingFirstKey:
+    return EmitBlockMappingKey(event, true);
+  case State::BlockMappingKey:
+    return EmitBlockMappingKey(event, false);
+  case State::BlockMappingSimpleValue:
+    return EmitBlockMappingValue(event, true);
+  case State::BlockMappingValue:
+    return EmitBlockMappingValue(event, false);
+  }
+}
+
+void Emitter::AnalyzeEvent(const Event& event) {
+  m_tag_handle = {};
+  m_tag_suffix = {};
+  m_scalar = {};
+  switch (event.type) {
+  case Event::Type::Scalar:
+    if (!event.tag.empty() && !event.plain_implicit && !event.quoted_implicit)
+      AnalyzeTag(event.tag);
+    AnalyzeScalar(event.value);
+    break;
+  case Event::Type::SequenceStart:
+  case Event::Type::MappingStart:
+    if (!event.tag.empty())
+      AnalyzeTag(event.tag);
+    break;
+  default:
+    break;
+  }
+}
+
+void Emitter::AnalyzeTag(std::string_view tag) {
+  // Default tag directives, in the order in which libyaml checks them.
+  static constexpr std::pair<std::string_view, std::string_view> TagDirectives[] = {
+      {"!", "!"},
+      {"!!", "tag:yaml.org,2002:"},
+  };
+  for (const auto& [handle, prefix] : TagDirectives) {
+    if (prefix.size() < tag.size() && tag.substr(0, prefix.size()) == prefix) {
+      m_tag_handle = handle;
+      m_tag_suffix = tag.substr(prefix.size());
+      return;
+    }
+  }
+  m_tag_suffix = tag;
+}
+
+void Emitter::AnalyzeScalar(std::string_view value) {
+  m_scalar = value;
+  auto& data = m_scalar_analysis;
+
+  if (IsSimpleScalar(value)) {
+    data.multiline = false;
+    data.flow_plain_allowed = true;
+    data.block_plain_allowed = true;
+    data.single_quoted_allowed = true;
+    return;
+  }
+
+  if (value.empty()) {
+    data.multiline = false;
+    data.flow_plain_allowed = false;
+    data.block_plain_allowed = true;
+    data.single_quoted_allowed = true;
+    return;
+  }
+
+  bool block_indicators = false;
+  bool flow_indicators = false;
+  bool line_breaks = false;
+  bool special_characters = false;
+  bool leading_space = false;
+  bool leading_break = false;
+  bool trailing_space = false;
+  bool trailing_break = false;
+  bool break_space = false;
+  bool space_break = false;
+  bool previous_space = false;
+  bool previous_break = false;
+
+  if (value.substr(0, 3) == "---" || value.substr(0, 3) == "...") {
+    block_indicators = true;
+    flow_indicators = true;
+  }
+
+  bool preceded_by_whitespace = true;
+  bool followed_by_whitespace = IsBlankZ(value, CharWidth(At(value, 0)));
+
+  for (size_t pos = 0; pos < value.size();) {
+    const char c = value[pos];
+    if (pos == 0) {
+      if (util::IsAnyOf(c, '#', ',', '[', ']', '{', '}', '&', '*', '!', '|', '>', '\'', '"', '%',
+                        '@', '`')) {
+        flow_indicators = true;
+        block_indicators = true;
+      }
+      if (c == '?' || c == ':') {
+        flow_indicators = true;
+        if (followed_by_whitespace)
+          block_indicators = true;
+      }
+      if (c == '-' && followed_by_whitespace) {
+        flow_indicators = true;
+        block_indicators = true;
+      }
+    } else {
+      if (util::IsAnyOf(c, ',', '?', '[', ']', '{', '}'))
+        flow_indicators = true;
+      if (c == ':') {
+        flow_indicators = true;
+        if (followed_by_whitespace)
+          block_indicators = true;
+      }
+      if (c == '#' && preceded_by_whitespace) {
+        flow_indicators = true;
+        block_indicators = true;
+      }
+    }
+
+    if (!IsPrintable(value, pos))
+      special_characters = true;
+
+    const size_t width = CharWidth(u8(c));
+    if (IsSpace(value, pos)) {
+      if (pos == 0)
+        leading_space = true;
+      if (pos + width == value.size())
+        trailing_space = true;
+      if (previous_break)
+        break_space = true;
+      previous_space = true;
+      previous_break = false;
+    } else if (IsBreak(value, pos)) {
+      line_breaks = true;
+      if (pos == 0)
+        leading_break = true;
+      if (pos + width == value.size())
+        trailing_break = true;
+      if (previous_space)
+        space_break = true;
+      previous_space = false;
+      previous_break = true;
+    } else {
+      previous_space = false;
+      previous_break = false;
+    }
+
+    preceded_by_whitespace = IsBlankZ(value, pos);
+    pos += width;
+    if (pos < value.size())
+      followed_by_whitespace = IsBlankZ(value, pos + CharWidth(At(value, pos)));
+  }
+
+  data.multiline = line_breaks;
+  data.flow_plain_allowed = true;
+  data.block_plain_allowed = true;
+  data.single_quoted_allowed = true;
+
+  if (leading_space || leading_break || trailing_space || trailing_break || line_breaks) {
+    data.flow_plain_allowed = false;
+    data.block_plain_allowed = false;
+  }
+  if (break_space || space_break || special_characters) {
+    data.flow_plain_allowed = false;
+    data.block_plain_allowed = false;
+    data.single_quoted_allowed = false;
+  }
+  if (flow_indicators)
+    data.flow_plain_allowed = false;
+  if (block_indicators)
+    data.block_plain_allowed = false;
+}
+
+void Emitter::EmitNode(const Event& event, bool mapping, bool simple_key) {
+  m_mapping_context = mapping;
+  m_simple_key_context = simple_key;
+
+  switch (event.type) {
+  case Event::Type::Scalar:
+    return EmitScalarNode(event);
+  case Event::Type::SequenceStart:
+    WriteTag();
+    if (m_flow_level || event.style == Style::Flow || m_next_is_end)
+      m_state = State::FlowSequenceFirstItem;
+    else
+      m_state = State::BlockSequenceFirstItem;
+    return;
+  case Event::Type::MappingStart:
+    WriteTag();
+    if (m_flow_level || event.style == Style::Flow || m_next_is_end)
+      m_state = State::FlowMappingFirstKey;
+    else
+      m_state = State::BlockMappingFirstKey;
+    return;
+  default:
+    throw std::logic_error("Emitter: expected a node");
+  }
+}
+
+void Emitter::EmitScalarNode(const Event& event) {
+  SelectScalarStyle(event);
+  WriteTag();
+  IncreaseIndent(true, false);
+  const bool allow_breaks = !m_simple_key_context;
+  switch (m_scalar_style) {
+  case ScalarStyle::Plain:
+    WritePlainScalar(m_scalar, allow_breaks);
+    break;
+  case ScalarStyle::SingleQuoted:
+    WriteSingleQuotedScalar(m_scalar, allow_breaks);
+    break;
+  default:
+    WriteDoubleQuotedScalar(m_scalar, allow_breaks);
+    break;
+  }
+  PopIndent();
+  PopState();
+}
+
+void Emitter::EmitFlowSequenceItem(const Event& event, bool first) {
+  if (first) {
+    WriteIndicator("[", true, true, false);
+    IncreaseIndent(true, false);
+    ++m_flow_level;
+  }
+
+  if (event.type == Event::Type::SequenceEnd) {
+    --m_flow_level;
+    PopIndent();
+    WriteIndicator("]", false, false, false);
+    PopState();
+    return;
+  }
+
+  if (!first)
+    WriteIndicator(",", false, false, false);
+  if (m_column > BestWidth)
+    WriteIndent();
+  m_states.push_back(State::FlowSequenceItem);
+  EmitNode(event, false, false);
+}
+
+void Emitter::EmitFlowMappingKey(const Event& event, bool first) {
+  if (first) {
+    WriteIndicator("{", true, true, false);
+    IncreaseIndent(true, false);
+    ++m_flow_level;
+  }
+
+  if (event.type == Event::Type::MappingEnd) {
+    --m_flow_level;
+    PopIndent();
+    WriteIndicator("}", false, false, false);
+    PopState();
+    return;
+  }
+
+  if (!first)
+    WriteIndicator(",", false, false, false);
+  if (m_column > BestWidth)
+    WriteIndent();
+  if (CheckSimpleKey(event)) {
+    m_states.push_back(State::FlowMappingSimpleValue);
+    EmitNode(event, true, true);
+  } else {
+    WriteIndicator("?", true, false, false);
+    m_states.push_back(State::FlowMappingValue);
+    EmitNode(event, true, false);
+  }
+}
+
+void Emitter::EmitFlowMappingValue(const Event& event, bool simple) {
+  if (simple) {
+    WriteIndicator(":", false, false, false);
+  } else {
+    if (m_column > BestWidth)
+      WriteIndent();
+    WriteIndicator(":", true, false, false);
+  }
+  m_states.push_back(State::FlowMappingKey);
+  EmitNode(event, true, false);
+}
+
+void Emitter::EmitBlockSequenceItem(const Event& event, bool first) {
+  if (first)
+    IncreaseIndent(false, m_mapping_context && !m_indention);
+
+  if (event.type == Event::Type::SequenceEnd) {
+    PopIndent();
+    PopState();
+    return;
+  }
+
+  WriteIndent();
+  WriteIndicator("-", true, false, true);
+  m_states.push_back(State::BlockSequenceItem);
+  EmitNode(event, false, false);
+}
+
+void Emitter::EmitBlockMappingKey(const Event& event, bool first) {
+  if (first)
+    IncreaseIndent(false, false);
+
+  if (event.type == Event::Type::MappingEnd) {
+    PopIndent();
+    PopState();
+    return;
+  }
+
+  WriteIndent();
+  if (CheckSimpleKey(event)) {
+    m_states.push_back(State::BlockMappingSimpleValue);
+    EmitNode(event, true, true);
+  } else {
+    WriteIndicator("?", true, false, true);
+    m_states.push_back(State::BlockMappingValue);
+    EmitNode(event, true, false);
+  }
+}
+
+void Emitter::EmitBlockMappingValue(const Event& event, bool simple) {
+  if (simple) {
+    WriteIndicator(":", false, false, false);
+  } else {
+    WriteIndent();
+    WriteIndicator(":", true, false, true);
+  }
+  m_states.push_back(State::BlockMappingKey);
+  EmitNode(event, true, false);
+}
+
+bool Emitter::CheckSimpleKey(const Event& event) const {
+  size_t length = m_tag_handle.size() + m_tag_suffix.size();
+  switch (event.type) {
+  case Event::Type::Scalar:
+    if (m_scalar_analysis.multiline)
+      return false;
+    length += m_scalar.size();
+    break;
+  case Event::Type::SequenceStart:
+  case Event::Type::MappingStart:
+    if (!m_next_is_end)
+      return false;
+    break;
+  default:
+    return false;
+  }
+  return length <= 128;
+}
+
+void Emitter::SelectScalarStyle(const Event& event) {
+  const bool no_tag = m_tag_handle.empty() && m_tag_suffix.empty();
+  if (no_tag && !event.plain_implicit && !event.quoted_implicit)
+    throw std::invalid_argument("Emitter: neither tag nor implicit flags are specified");
+
+  const auto& data = m_scalar_analysis;
+  ScalarStyle style = event.scalar_style;
+  if (style == ScalarStyle::Any)
+    style = ScalarStyle::Plain;
+
+  if (m_simple_key_context && data.multiline)
+    style = ScalarStyle::DoubleQuoted;
+
+  if (style == ScalarStyle::Plain) {
+    if ((m_flow_level && !data.flow_plain_allowed) ||
+        (!m_flow_level && !data.block_plain_allowed)) {
+      style = ScalarStyle::SingleQuoted;
+    }
+    if (m_scalar.empty() && (m_flow_level || m_simple_key_context))
+      style = ScalarStyle::SingleQuoted;
+    if (no_tag && !event.plain_implicit)
+      style = ScalarStyle::SingleQuoted;
+  }
+
+  if (style == ScalarStyle::SingleQuoted && !data.single_quoted_allowed)
+    style = ScalarStyle::DoubleQuoted;
+
+  if (no_tag && !event.quoted_implicit && style != ScalarStyle::Plain)
+    m_tag_handle = "!";
+
+  m_scalar_style = style;
+}
+
+void Emitter::IncreaseIndent(bool flow, bool indentless) {
+  m_indents.push_back(m_indent);
+  if (m_indent < 0)
+    m_indent = flow ? BestIndent : 0;
+  else if (!indentless)
+    m_indent += BestIndent;
+}
+
+void Emitter::PopIndent() {
+  m_indent = m_indents.back();
+  m_indents.pop_back();
+}
+
+void Emitter::PopState() {
+  m_state = m_states.back();
+  m_states.pop_back();
+}
+
+void Emitter::Put(char c) {
+  m_output += c;
+  ++m_column;
+}
+
+void Emitter::PutBreak() {
+  m_output += '\n';
+  m_column = 0;
+}
+
+size_t Emitter::WriteChar(std::string_view str, size_t pos) {
+  const size_t width = std::min(CharWidth(At(str, pos)), str.size() - pos);
+  m_output.append(str.data() + pos, width);
+  ++m_column;
+  return width;
+}
+
+void Emitter::WriteRun(std::string_view str) {
+  m_output += str;
+  m_column += CountChars(str);
+}
+
+void Emitter::WriteIndent() {
+  const int indent = std::max(m_indent, 0);
+  if (!m_indention || m_column > indent || (m_column == indent && !m_whitespace))
+    PutBreak();
+  if (m_column < indent) {
+    m_output.append(indent - m_column, ' ');
+    m_column = indent;
+  }
+  m_whitespace = true;
+  m_indention = true;
+}
+
+void Emitter::WriteIndicator(std::string_view indicator, bool need_whitespace,
+                             bool is_whitespace, bool is_indention) {
+  if (need_whitespace && !m_whitespace)
+    Put(' ');
+  m_output += indicator;
+  m_column += indicator.size();
+  m_whitespace = is_whitespace;
+  m_indention = m_indention && is_indention;
+}
+
+void Emitter::WriteTag() {
+  if (m_tag_handle.empty() && m_tag_suffix.empty())
+    return;
+
+  if (m_tag_handle.empty()) {
+    WriteIndicator("!<", true, false, false);
+  } else {
+    if (!m_whitespace)
+      Put(' ');
+    m_output += m_tag_handle;
+    m_column += m_tag_handle.size();
+  }
+
+  for (size_t pos = 0; pos < m_tag_suffix.size();) {
+    const u8 c = m_tag_suffix[pos];
+    if (IsAlpha(c) || util::IsAnyOf(c, ';', '/', '?', ':', '@', '&', '=', '+', '$', ',', '_', '.',
+                                    '~', '*', '\'', '(', ')', '[', ']')) {
+      pos += WriteChar(m_tag_suffix, pos);
+      continue;
+    }
+    const size_t width = std::min(CharWidth(c), m_tag_suffix.size() - pos);
+    for (size_t i = 0; i < width; ++i) {
+      const u8 octet = m_tag_suffix[pos++];
+      Put('%');
+      Put(HexDigits[octet >> 4]);
+      Put(HexDigits[octet & 0xF]);
+    }
+  }
+
+  if (m_tag_handle.empty())
+    WriteIndicator(">", false, false, false);
+  m_whitespace = false;
+  m_indention = false;
+}
+
+void Emitter::WritePlainScalar(std::string_view value, bool allow_breaks) {
+  if (!m_whitespace)
+    Put(' ');
+
+  bool spaces = false;
+  for (size_t pos = 0; pos < value.size();) {
+    if (IsSpace(value, pos)) {
+      if (allow_breaks && !spaces && m_column > BestWidth && !IsSpace(value, pos + 1)) {
+        WriteIndent();
+        ++pos;
+      } else {
+        pos += WriteChar(value, pos);
+      }
+      spaces = true;
+    } else {
+      // Plain scalars cannot contain line breaks, so everything up to the next space
+      // can be written at once.
+      const size_t end = std::min(value.find(' ', pos), value.size());
+      WriteRun(value.substr(pos, end - pos));
+      pos = end;
+      m_indention = false;
+      spaces = false;
+    }
+  }
+
+  m_whitespace = false;
+  m_indention = false;
+}
+
+void Emitter::WriteSingleQuotedScalar(std::string_view value, bool allow_breaks) {
+  WriteIndicator("'", true, false, false);
+
+  bool spaces = false;
+  bool breaks = false;
+  for (size_t pos = 0; pos < value.size();) {
+    if (IsSpace(value, pos)) {
+      if (allow_breaks && !spaces && m_column > BestWidth && pos != 0 &&
+          pos != value.size() - 1 && !IsSpace(value, pos + 1)) {
+        WriteIndent();
+        ++pos;
+      } else {
+        pos += WriteChar(value, pos);
+      }
+      spaces = true;
+    } else if (IsBreak(value, pos)) {
+      if (!breaks && value[pos] == '\n')
+        PutBreak();
+      if (value[pos] == '\n') {
+        PutBreak();
+        ++pos;
+      } else {
+        pos += WriteChar(value, pos);
+        m_column = 0;
+      }
+      m_indention = true;
+      breaks = true;
+    } else {
+      if (breaks)
+        WriteIndent();
+      if (value[pos] == '\'') {
+        Put('\'');
+        pos += WriteChar(value, pos);
+      } else {
+        // Write characters that need no special handling in bulk. Line breaks other than
+        // \r and \n start with 0xC2 or 0xE2.
+        const size_t end =
+            std::min(value.find_first_of(std::string_view(" '\r\n\xC2\xE2", 6), pos + 1),
+                     value.size());
+        WriteRun(value.substr(pos, end - pos));
+        pos = end;
+      }
+      m_indention = false;
+      spaces = false;
+      breaks = false;
+    }
+  }
+
+  if (breaks)
+    WriteIndent();
+  WriteIndicator("'", false, false, false);
+  m_whitespace = false;
+  m_indention = false;
+}
+
+void Emitter::WriteDoubleQuotedScalar(std::string_view value, bool allow_breaks) {
+  WriteIndicator("\"", true, false, false);
+
+  bool spaces = false;
+  for (size_t pos = 0; pos < value.size();) {
+    const u8 c = value[pos];
+    if (!IsPrintable(value, pos) || IsBom(value, pos) || IsBreak(value, pos) || c == '"' ||
+        c == '\\') {
+      const size_t width = std::min(CharWidth(c), value.size() - pos);
+      u32 code_point = width == 1 ? c : width == 2 ? c & 0x1F : width == 3 ? c & 0x0F : c & 0x07;
+      for (size_t k = 1; k < width; ++k)
+        code_point = (code_point << 6) + (u8(value[pos + k]) & 0x3F);
+      pos += width;
+
+      Put('\\');
+      if (const char escape = GetEscapeCharacter(code_point)) {
+        Put(escape);
+      } else {
+        int num_digits;
+        if (code_point <= 0xFF) {
+          Put('x');
+          num_digits = 2;
+        } else if (code_point <= 0xFFFF) {
+          Put('u');
+          num_digits = 4;
+        } else {
+          Put('U');
+          num_digits = 8;
+        }
+        for (int k = (num_digits - 1) * 4; k >= 0; k -= 4)
+          Put(HexDigits[(code_point >> k) & 0xF]);
+      }
+      spaces = false;
+    } else if (IsSpace(value, pos)) {
+      if (allow_breaks && !spaces && m_column > BestWidth && pos != 0 &&
+          pos != value.size() - 1) {
+        WriteIndent();
+        if (IsSpace(value, pos + 1))
+          Put('\\');
+        ++pos;
+      } else {
+        pos += WriteChar(value, pos);
+      }
+      spaces = true;
+    } else {
+      pos += WriteChar(value, pos);
+      spaces = false;
+    }
+  }
+
+  WriteIndicator("\"", false, false, false);
+  m_whitespace = false;
+  m_indention = false;
+}
+
 }  // namespace oead::yml
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <charconv>
+#include <iterator>
 #include <nonstd/span.h>
 #include <optional>
 #include <stdexcept>
@@ -26,6 +28,7 @@
 #include <string_view>
 #include <tuple>
 #include <variant>
+#include <vector>
 
 #include <c4/std/string.hpp>
 #include <ryml.hpp>
@@ -36,9 +39,6 @@
 
 namespace oead::yml {
 
-std::string FormatFloat(float value);
-std::string FormatDouble(double value);
-
 using Scalar = std::variant<std::nullptr_t, bool, u64, double, std::string>;
 
 bool StringNeedsQuotes(std::string_view value);
@@ -59,6 +59,11 @@ Scalar ParseScalarKey(const ryml::NodeRef& node, TagRecognizer recognizer);
 
 void InitRymlIfNeeded();
 
+/// Parses YAML into a thread-local tree that is reused across calls, so that the node buffer
+/// and the arena are only reallocated when a larger document is parsed.
+/// The returned tree is only valid until the next call on the same thread.
+ryml::Tree& ParseIntoThreadLocalTree(std::string_view text);
+
 inline std::string_view RymlSubstrToStrView(c4::csubstr str) {
   return {str.data(), str.size()};
 }
@@ -118,50 +123,51 @@ private:
   yaml_parser_t m_parser;
 };
 
-class LibyamlEmitter {
+/// Emits YAML documents directly into a string.
+///
+/// Only the subset of YAML that oead needs is supported: block and flow collections, tags,
+/// and plain, single-quoted or double-quoted scalars. For that subset, the output is identical
+/// to what libyaml generates (with unicode output enabled and a line width of 120).
+class Emitter {
 public:
-  LibyamlEmitter();
-  ~LibyamlEmitter();
-  LibyamlEmitter(const LibyamlEmitter&) = delete;
-  LibyamlEmitter& operator=(const LibyamlEmitter&) = delete;
-  operator yaml_emitter_t*() { return &m_emitter; }
+  enum class Style {
+    Block,
+    Flow,
+  };
 
-  void Emit(yaml_event_t& event, bool ignore_errors = false);
+  Emitter() = default;
+  Emitter& operator=(const Emitter&) = delete;
+  Emitter(Emitter&&) = default;
+  Emitter& operator=(Emitter&&) = default;
 
   void EmitScalar(std::string_view value, bool plain_implicit, bool quoted_implicit,
-                  std::string_view tag = {}) {
-    yaml_event_t event;
-    const auto style = value.empty() ? YAML_SINGLE_QUOTED_SCALAR_STYLE : YAML_ANY_SCALAR_STYLE;
-    yaml_scalar_event_initialize(&event, nullptr, tag.empty() ? nullptr : (const u8*)tag.data(),
-                                 (const u8*)value.data(), value.size(), plain_implicit,
-                                 quoted_implicit, style);
-    Emit(event);
-  }
+                  std::string_view tag = {});
 
   void EmitNull() { EmitScalar("null", true, false); }
-  void EmitBool(bool v, std::string_view tag = "!!bool") {
-    EmitScalar(v ? "true" : "false", true, false, tag);
-  }
-  void EmitFloat(float v, std::string_view tag = "!!float") {
-    EmitScalar(FormatFloat(v), true, false, tag);
-  }
-  void EmitDouble(double v, std::string_view tag = "!f64") {
-    EmitScalar(FormatDouble(v), false, false, tag);
-  }
+  void EmitBool(bool v) { EmitScalar(v ? "true" : "false", true, false); }
+  void EmitFloat(float v, std::string_view tag = "!!float");
+  void EmitDouble(double v, std::string_view tag = "!f64");
   template <typename T = int>
   void EmitInt(T v, std::string_view tag = "!!int") {
-    EmitScalar(std::to_string(v), tag == "!!int", false, tag);
+    char buffer[24];
+    const auto result = std::to_chars(std::begin(buffer), std::end(buffer),
+                                      static_cast<typename NumberType<T>::type>(v));
+    EmitScalar({buffer, size_t(result.ptr - buffer)}, tag == "!!int", false, tag);
   }
   void EmitString(std::string_view v, std::string_view tag) { EmitScalar(v, false, false, tag); }
   void EmitString(std::string_view v) { EmitScalar(v, !StringNeedsQuotes(v), true); }
 
+  /// Starts a sequence or a mapping. An empty tag means that the collection is untagged.
+  /// The tag must stay valid until the next call to the emitter.
+  void BeginSequence(std::string_view tag, Style style);
+  void EndSequence();
+  void BeginMapping(std::string_view tag, Style style);
+  void EndMapping();
+
   /// Emits an inline sequence of bools, ints or floats.
   template <typename T>
   void EmitSimpleSequence(tcb::span<const T> sequence, std::string_view sequence_tag = {}) {
-    yaml_event_t event;
-    yaml_sequence_start_event_initialize(&event, nullptr, (const u8*)sequence_tag.data(),
-                                         sequence_tag.empty(), YAML_FLOW_SEQUENCE_STYLE);
-    Emit(event);
+    BeginSequence(sequence_tag, Style::Flow);
     for (const T& v : sequence) {
       if constexpr (std::is_same_v<T, bool>)
         EmitBool(v);
@@ -174,8 +180,7 @@ public:
       else
         static_assert(util::AlwaysFalse<T>(), "Unsupported type!");
     }
-    yaml_sequence_end_event_initialize(&event);
-    Emit(event);
+    EndSequence();
   }
 
   template <typename T>
@@ -189,48 +194,144 @@ public:
   }
 
   struct MappingScope {
-    MappingScope(LibyamlEmitter& emitter_, std::string_view tag, yaml_mapping_style_t style)
-        : emitter{emitter_} {
-      yaml_event_t event;
-      yaml_mapping_start_event_initialize(&event, nullptr, (const u8*)tag.data(),
-                                          tag.empty() ? 1 : 0, style);
-      emitter.Emit(event);
+    MappingScope(Emitter& emitter_, std::string_view tag, Style style) : emitter{emitter_} {
+      emitter.BeginMapping(tag, style);
     }
-
     ~MappingScope() {
-      yaml_event_t event;
-      yaml_mapping_end_event_initialize(&event);
       // Ignore errors here because this shouldn't throw...
-      emitter.Emit(event, true);
+      try {
+        emitter.EndMapping();
+      } catch (...) {
+      }
     }
 
   private:
-    LibyamlEmitter& emitter;
+    Emitter& emitter;
   };
 
-protected:
-  yaml_emitter_t m_emitter;
-};
+  /// Returns an emitter that continues from the current state with an empty output.
+  ///
+  /// This allows items of the current block collection to be emitted on other threads:
+  /// each item is emitted with its own fork and the forks are joined in order.
+  /// The collection must have been started and must not be empty.
+  Emitter Fork();
+  /// Appends the output of a fork that contains exactly one item of the current collection.
+  /// The result is identical to emitting the item with this emitter.
+  void Join(Emitter&& fork);
 
-template <typename Container>
-class LibyamlEmitterWithStorage : public LibyamlEmitter {
-public:
-  LibyamlEmitterWithStorage() : LibyamlEmitter{} {
-    const auto write_handler = [](void* userdata, u8* buffer, size_t size) {
-      auto* self = static_cast<LibyamlEmitterWithStorage*>(userdata);
-      self->m_output.insert(self->m_output.end(), (char*)buffer, (char*)buffer + size);
-      return 1;
-    };
-    yaml_emitter_set_output(&m_emitter, write_handler, this);
-  }
+  /// Ends the document and returns the output.
+  std::string Finish();
+
+private:
+  enum class ScalarStyle {
+    Any,
+    Plain,
+    SingleQuoted,
+    DoubleQuoted,
+  };
 
-  ~LibyamlEmitterWithStorage() = default;
+  enum class State {
+    DocumentContent,
+    DocumentEnd,
+    FlowSequenceFirstItem,
+    FlowSequenceItem,
+    FlowMappingFirstKey,
+    FlowMappingKey,
+    FlowMappingSimpleValue,
+    FlowMappingValue,
+    BlockSequenceFirstItem,
+    BlockSequenceItem,
+    BlockMappingFirstKey,
+    BlockMappingKey,
+    BlockMappingSimpleValue,
+    BlockMappingValue,
+  };
+
+  struct Event {
+    enum class Type {
+      Scalar,
+      SequenceStart,
+      SequenceEnd,
+      MappingStart,
+      MappingEnd,
+    };
+    explicit Event(Type type_) : type{type_} {}
+
+    Type type;
+    std::string_view tag;
+    std::string_view value;
+    bool plain_implicit = false;
+    bool quoted_implicit = false;
+    ScalarStyle scalar_style = ScalarStyle::Any;
+    Style style = Style::Block;
+  };
 
-  Container& GetOutput() { return m_output; }
-  const Container& GetOutput() const { return m_output; }
+  struct ScalarAnalysis {
+    bool multiline = false;
+    bool flow_plain_allowed = false;
+    bool block_plain_allowed = false;
+    bool single_quoted_allowed = false;
+  };
 
-private:
-  Container m_output;
+  void Push(const Event& event);
+  void Process(const Event& event);
+  void AnalyzeEvent(const Event& event);
+  void AnalyzeTag(std::string_view tag);
+  void AnalyzeScalar(std::string_view value);
+
+  void EmitNode(const Event& event, bool mapping, bool simple_key);
+  void EmitScalarNode(const Event& event);
+  void EmitFlowSequenceItem(const Event& event, bool first);
+  void EmitFlowMappingKey(const Event& event, bool first);
+  void EmitFlowMappingValue(const Event& event, bool simple);
+  void EmitBlockSequenceItem(const Event& event, bool first);
+  void EmitBlockMappingKey(const Event& event, bool first);
+  void EmitBlockMappingValue(const Event& event, bool simple);
+  bool CheckSimpleKey(const Event& event) const;
+  void SelectScalarStyle(const Event& event);
+  void IncreaseIndent(bool flow, bool indentless);
+  void PopIndent();
+  void PopState();
+
+  void Put(char c);
+  void PutBreak();
+  /// Writes the UTF-8 character at the specified position and returns its size.
+  size_t WriteChar(std::string_view str, size_t pos);
+  /// Writes characters that do not need any special handling.
+  void WriteRun(std::string_view str);
+  void WriteIndent();
+  void WriteIndicator(std::string_view indicator, bool need_whitespace, bool is_whitespace,
+                      bool is_indention);
+  void WriteTag();
+  void WritePlainScalar(std::string_view value, bool allow_breaks);
+  void WriteSingleQuotedScalar(std::string_view value, bool allow_breaks);
+  void WriteDoubleQuotedScalar(std::string_view value, bool allow_breaks);
+
+  /// Only used by Fork, because copying the output is almost never desirable.
+  Emitter(const Emitter&) = default;
+
+  std::string m_output;
+  State m_state = State::DocumentContent;
+  std::vector<State> m_states;
+  std::vector<int> m_indents;
+  /// Start events are only processed once the next event is known,
+  /// because empty collections are always emitted in flow style.
+  std::optional<Event> m_pending_start;
+  bool m_next_is_end = false;
+
+  int m_indent = -1;
+  int m_flow_level = 0;
+  bool m_mapping_context = false;
+  bool m_simple_key_context = false;
+  int m_column = 0;
+  bool m_whitespace = true;
+  bool m_indention = true;
+
+  std::string_view m_tag_handle;
+  std::string_view m_tag_suffix;
+  std::string_view m_scalar;
+  ScalarAnalysis m_scalar_analysis;
+  ScalarStyle m_scalar_style = ScalarStyle::Any;
 };
 
 }  // namespace oead::yml
@@ -0,0 +1,94 @@
+import pytest
+import oead
+
+from utils import check_aamp_param_data, make_test_cases_aamp, make_test_cases_aamp_curves
+
+cases, data = make_test_cases_aamp()
+curve_cases, curve_data = make_test_cases_aamp_curves()
+
+
+def check_list(plist, flat, list_id):
+    entry = flat.list_at(list_id)
+    assert entry.num_lists == len(plist.lists)
+    assert entry.num_objects == len(plist.objects)
+    for i, (name, obj) in enumerate(plist.objects.items()):
+        obj_id = flat.find_object(list_id, name)
+        assert obj_id == entry.objects_begin + i
+        assert flat.object_at(obj_id).num_parameters == len(obj.params)
+        for key, param in obj.params.items():
+            param_id = flat.find_parameter(obj_id, key)
+            assert flat.parameter_at(param_id).type() == param.type()
+            assert flat.parameter_at(param_id).to_parameter() == param
+            check_aamp_param_data(flat.parameter_at(param_id), param)
+        assert flat.to_object(obj_id) == obj
+    for i, (name, child) in enumerate(plist.lists.items()):
+        child_id = flat.find_list(list_id, name)
+        assert child_id == entry.lists_begin + i
+        check_list(child, flat, child_id)
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_flat_from_binary(file):
+    pio = oead.aamp.ParameterIO.from_binary(data[file])
+    flat = oead.aamp.FlatParameterIO.from_binary(data[file])
+    assert flat.version == pio.version
+    assert flat.type == pio.type
+    assert flat.to_parameter_io() == pio
+    check_list(pio, flat, oead.aamp.FlatParameterIO.ROOT_LIST_ID)
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_flat_from_parameter_io(file):
+    pio = oead.aamp.ParameterIO.from_binary(data[file])
+    flat = oead.aamp.FlatParameterIO.from_parameter_io(pio)
+    assert flat.to_parameter_io() == pio
+    assert flat.to_binary() == data[file]
+
+
+@pytest.mark.parametrize("file", curve_cases)
+def test_aamp_flat_curves(file):
+    pio = oead.aamp.ParameterIO.from_binary(curve_data[file])
+    flat = oead.aamp.FlatParameterIO.from_binary(curve_data[file])
+    check_list(pio, flat, oead.aamp.FlatParameterIO.ROOT_LIST_ID)
+
+
+def test_aamp_flat_buffers():
+    text = """!io
+version: 0
+type: xml
+param_root: !list
+  objects:
+    Buffers: !obj
+      int: !buffer_int [1, -2, 3]
+      f32: !buffer_f32 [0.5, -1.5]
+      u32: !buffer_u32 [4, 5, 6, 7]
+      binary: !buffer_binary [8, 9, 10]
+      empty: !buffer_int []
+  lists: {}
+"""
+    pio = oead.aamp.ParameterIO.from_text(text)
+    flat = oead.aamp.FlatParameterIO.from_parameter_io(pio)
+    check_list(pio, flat, oead.aamp.FlatParameterIO.ROOT_LIST_ID)
+    assert len(flat.parameter_at(flat.find_parameter("Buffers/empty")).get_buffer_int()) == 0
+    buffer = flat.parameter_at(flat.find_parameter("Buffers/int")).get_buffer_int()
+    del flat
+    # The memoryview keeps the arena alive.
+    assert list(buffer.cast("i")) == [1, -2, 3]
+
+
+def test_aamp_flat_lookup():
+    flat = oead.aamp.FlatParameterIO.from_binary(data["Lizalfos_Ice.baiprog"])
+    pio = oead.aamp.ParameterIO.from_binary(data["Lizalfos_Ice.baiprog"])
+    class_name = pio.lists["AI"].lists["AI_0"].objects["Def"].params["ClassName"]
+    param_id = flat.find_parameter("AI/AI_0/Def/ClassName")
+    assert flat.parameter_at(param_id).get_string() == str(class_name.v)
+    assert flat.find_parameter("AI/AI_0/Def/__nonexistent__") is None
+    with pytest.raises(oead.TypeError):
+        flat.parameter_at(param_id).get_int()
+    with pytest.raises(IndexError):
+        flat.list_at(flat.num_lists())
+
+
+def test_aamp_flat_invalid():
+    with pytest.raises(oead.InvalidDataError):
+        oead.aamp.FlatParameterIO.from_binary(data["Lizalfos_Ice.baiprog"][:0x100])
@@ -0,0 +1,62 @@
+import binascii
+import oead
+import pytest
+import random
+import struct
+
+
+def crc32(name):
+    return binascii.crc32(name.encode())
+
+
+def test_aamp_name_hashes():
+    rng = random.Random(0)
+    for length in list(range(300)) + [1000, 4096]:
+        name = "".join(rng.choice("abcdefghijklmnopqrstuvwxyz_0123456789") for _ in range(length))
+        assert oead.aamp.Name(name).hash == crc32(name)
+
+
+def test_aamp_name_table_init(benchmark):
+    benchmark.group = "NameTable(True)"
+    benchmark(oead.aamp.NameTable, True)
+
+
+def test_aamp_numbered_names():
+    table = oead.aamp.NameTable(True)
+    assert table.get_name(crc32("Check_10"), 9, 0) == "Check_10"
+    assert table.get_name(crc32("Check_10"), 8, 0) is None
+    # Indices beyond the index limit are still found.
+    table = oead.aamp.NameTable(True)
+    table.numbered_name_index_limit = 16
+    assert table.get_name(crc32("Value500"), 500, 0) == "Value500"
+
+
+def test_aamp_numbered_name_index_cache(tmp_path):
+    cache = tmp_path / "numbered_names.bin"
+    cache.write_bytes(oead.aamp.NameTable(True).save_numbered_name_index())
+
+    table = oead.aamp.NameTable(True)
+    assert table.load_numbered_name_index(cache.read_bytes())
+    assert table.get_name(crc32("State_3"), 2, 0) == "State_3"
+
+    stale = oead.aamp.NameTable(True)
+    stale.numbered_name_index_limit = 10
+    assert not stale.load_numbered_name_index(cache.read_bytes())
+
+    corrupted = bytearray(cache.read_bytes())
+    corrupted[-1] ^= 1
+    with pytest.raises(oead.InvalidDataError):
+        oead.aamp.NameTable(True).load_numbered_name_index(bytes(corrupted))
+
+
+def test_aamp_numbered_name_index_cache_invalid_format():
+    cache = bytearray(oead.aamp.NameTable(True).save_numbered_name_index())
+    entries = cache[0x20:]
+    used = {struct.unpack_from("<I", entries, i + 4)[0] for i in range(0, len(entries), 12)}
+    # Names that are not valid format strings have no entries.
+    invalid = next(i for i in range(max(used)) if i not in used)
+    struct.pack_into("<I", entries, 4, invalid)
+    cache[0x20:] = entries
+    struct.pack_into("<I", cache, 0x18, binascii.crc32(entries))
+    with pytest.raises(oead.InvalidDataError):
+        oead.aamp.NameTable(True).load_numbered_name_index(bytes(cache))
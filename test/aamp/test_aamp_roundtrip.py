@@ -46,3 +46,62 @@ def test_aamp_roundtrip_types():
 
     bin_serialized = data.to_binary()
     assert data == oead.aamp.ParameterIO.from_binary(bin_serialized)
+
+
+def test_aamp_roundtrip_string_lengths():
+    # Cover both inline and heap-allocated strings, as well as truncation.
+    lengths = (0, 1, 7, 8, 15, 16, 17, 31, 32, 33, 64, 65, 255, 256, 300)
+    obj = oead.aamp.ParameterObject()
+    for length in lengths:
+        s = "a" * length
+        obj.params[f"Str32_{length}"] = oead.aamp.Parameter(oead.FixedSafeString32(s))
+        obj.params[f"Str256_{length}"] = oead.aamp.Parameter(oead.FixedSafeString256(s))
+        obj.params[f"StrRef_{length}"] = oead.aamp.Parameter(s)
+    pio = oead.aamp.ParameterIO()
+    pio.objects["Strings"] = obj
+
+    for data in (oead.aamp.ParameterIO.from_binary(pio.to_binary()),
+                 oead.aamp.ParameterIO.from_text(pio.to_text())):
+        assert data == pio
+        params = data.objects["Strings"].params
+        for length in lengths:
+            assert str(params[f"Str32_{length}"].v) == "a" * min(length, 32)
+            assert str(params[f"Str256_{length}"].v) == "a" * min(length, 256)
+            assert params[f"StrRef_{length}"].v == "a" * length
+
+
+def make_buffer_pio(params):
+    lines = ["!io", "version: 0", "type: xml", "param_root: !list", "  objects:",
+             "    Buffers: !obj"]
+    lines += [f"      {name}: !{tag} [{values}]" for name, tag, values in params]
+    lines.append("  lists: {}")
+    return oead.aamp.ParameterIO.from_text("\n".join(lines) + "\n")
+
+
+def test_aamp_roundtrip_buffer_sizes():
+    # Buffers are read and written in bulk, so cover empty, small and large buffers.
+    # Each buffer is written to its own parameter IO so that no data is deduplicated.
+    for size in (0, 1, 3, 4, 17, 1000):
+        ints = ", ".join(str(i % 256) for i in range(size))
+        floats = ", ".join(f"{i % 256}.5" for i in range(size))
+        for tag, values in (("buffer_int", ints), ("buffer_u32", ints), ("buffer_binary", ints),
+                            ("buffer_f32", floats)):
+            pio = make_buffer_pio([("buffer", tag, values)])
+            data = oead.aamp.ParameterIO.from_binary(pio.to_binary())
+            assert data == pio
+            if tag == "buffer_u32":
+                buffer = data.objects["Buffers"].params["buffer"].v
+                assert list(buffer) == [i % 256 for i in range(size)]
+
+
+def test_aamp_roundtrip_identical_buffers():
+    # Identical buffers share their data, including the buffer size.
+    pio = make_buffer_pio([
+        ("int", "buffer_int", "1, 2, 3"),
+        ("u32", "buffer_u32", "1, 2, 3"),
+        ("empty_int", "buffer_int", ""),
+        ("empty_u32", "buffer_u32", ""),
+    ])
+    data = oead.aamp.ParameterIO.from_binary(pio.to_binary())
+    assert data == pio
+    assert list(data.objects["Buffers"].params["u32"].v) == [1, 2, 3]
@@ -0,0 +1,48 @@
+from concurrent.futures import ThreadPoolExecutor
+import oead
+import pytest
+
+from utils import make_test_cases_aamp
+
+cases, data = make_test_cases_aamp()
+pios = [oead.aamp.ParameterIO.from_binary(data[file]) for file in cases]
+
+
+def to_text_all(pios, num_threads):
+    if num_threads == 1:
+        return [pio.to_text() for pio in pios]
+    with ThreadPoolExecutor(num_threads) as executor:
+        return list(executor.map(lambda pio: pio.to_text(), pios))
+
+
+def test_aamp_to_text_threads():
+    # Names that are guessed during a conversion are remembered by the default name table and
+    # may be used by later conversions, so the expected text is generated after a warm-up.
+    to_text_all(pios, 1)
+    expected = to_text_all(pios, 1)
+    for _ in range(10):
+        assert to_text_all(pios * 4, 16) == expected * 4
+
+
+def test_aamp_to_text_single_thread(benchmark):
+    benchmark.group = "aamp to_text (all files)"
+    benchmark(to_text_all, pios, 1)
+
+
+def test_aamp_to_text_multi_thread(benchmark):
+    benchmark.group = "aamp to_text (all files)"
+    benchmark(to_text_all, pios, 8)
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_to_text_parallel_lists(file):
+    pio = oead.aamp.ParameterIO.from_binary(data[file])
+    assert pio.to_text(num_threads=4) == pio.to_text()
+
+
+@pytest.mark.parametrize("file", cases)
+@pytest.mark.parametrize("num_threads", [1, 0])
+def test_aamp_to_text_parallel_lists_benchmark(benchmark, file, num_threads):
+    benchmark.group = "aamp to_text: " + file
+    pio = oead.aamp.ParameterIO.from_binary(data[file])
+    benchmark(pio.to_text, num_threads=num_threads)
@@ -0,0 +1,79 @@
+import pytest
+import oead
+
+from utils import check_aamp_param_data, make_test_cases_aamp, make_test_cases_aamp_curves
+
+cases, data = make_test_cases_aamp()
+curve_cases, curve_data = make_test_cases_aamp_curves()
+
+
+def check_list(plist, view):
+    assert view.num_lists() == len(plist.lists)
+    assert view.num_objects() == len(plist.objects)
+    for i, (name, obj) in enumerate(plist.objects.items()):
+        obj_view = view.object(name)
+        assert view.object_at(i).name() == name
+        assert len(obj_view) == len(obj.params)
+        for key, param in obj.params.items():
+            assert key in obj_view
+            assert obj_view[key].type() == param.type()
+            assert obj_view[key].to_parameter() == param
+            check_aamp_param_data(obj_view[key], param)
+        assert obj_view.to_object() == obj
+    for i, (name, child) in enumerate(plist.lists.items()):
+        assert view.list_at(i).name() == name
+        check_list(child, view.list(name))
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_view(file):
+    pio = oead.aamp.ParameterIO.from_binary(data[file])
+    view = oead.aamp.ParameterIOView(data[file])
+    assert view.version == pio.version
+    assert view.type == pio.type
+    check_list(pio, view.get_root())
+
+
+@pytest.mark.parametrize("file", curve_cases)
+def test_aamp_view_curves(file):
+    pio = oead.aamp.ParameterIO.from_binary(curve_data[file])
+    check_list(pio, oead.aamp.ParameterIOView(curve_data[file]).get_root())
+
+
+def test_aamp_view_buffers():
+    text = """!io
+version: 0
+type: xml
+param_root: !list
+  objects:
+    Buffers: !obj
+      int: !buffer_int [1, -2, 3]
+      f32: !buffer_f32 [0.5, -1.5]
+      u32: !buffer_u32 [4, 5, 6, 7]
+      binary: !buffer_binary [8, 9, 10]
+      empty: !buffer_int []
+  lists: {}
+"""
+    data = oead.aamp.ParameterIO.from_text(text).to_binary()
+    obj = oead.aamp.ParameterIOView(data).get_root().object("Buffers")
+    assert list(obj["int"].get_buffer_int().cast("i")) == [1, -2, 3]
+    assert list(obj["f32"].get_buffer_f32().cast("f")) == [0.5, -1.5]
+    assert list(obj["u32"].get_buffer_u32().cast("I")) == [4, 5, 6, 7]
+    assert bytes(obj["binary"].get_buffer_binary()) == bytes([8, 9, 10])
+    assert len(obj["empty"].get_buffer_int()) == 0
+    with pytest.raises(oead.TypeError):
+        obj["int"].get_buffer_u32()
+
+
+def test_aamp_view_lookup():
+    view = oead.aamp.ParameterIOView(data["Lizalfos_Ice.baiprog"])
+    pio = oead.aamp.ParameterIO.from_binary(data["Lizalfos_Ice.baiprog"])
+    class_name = pio.lists["AI"].lists["AI_0"].objects["Def"].params["ClassName"]
+    param = view.find_parameter("AI/AI_0/Def/ClassName")
+    assert param.get_string() == str(class_name.v)
+    with pytest.raises(oead.TypeError):
+        param.get_int()
+    assert view.find_parameter("AI/AI_0/Def/__nonexistent__") is None
+    assert view.get_root().find_list("__nonexistent__") is None
+    with pytest.raises(IndexError):
+        view.get_root().object("__nonexistent__")
@@ -0,0 +1,25 @@
+import pytest
+import oead
+
+from utils import make_test_cases_aamp
+
+cases, data = make_test_cases_aamp()
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_from_bin_pio(benchmark, file):
+    benchmark.group = "from_bin (flat): " + file
+    benchmark(oead.aamp.ParameterIO.from_binary, data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_from_bin_flat(benchmark, file):
+    benchmark.group = "from_bin (flat): " + file
+    benchmark(oead.aamp.FlatParameterIO.from_binary, data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_flat_to_parameter_io(benchmark, file):
+    benchmark.group = "flat to_parameter_io: " + file
+    flat = oead.aamp.FlatParameterIO.from_binary(data[file])
+    benchmark(flat.to_parameter_io)
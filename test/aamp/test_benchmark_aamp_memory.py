@@ -0,0 +1,16 @@
+import pytest
+import oead
+
+from utils import make_test_cases_aamp, measure_heap
+
+cases, data = make_test_cases_aamp()
+
+
+@pytest.mark.parametrize("file", cases)
+def test_memory_pio(benchmark, file):
+    benchmark.group = "memory: " + file
+    allocations, size = measure_heap("import oead", "oead.aamp.ParameterIO.from_binary(data)",
+                                     data[file])
+    benchmark.extra_info["allocations"] = allocations
+    benchmark.extra_info["heap_bytes"] = size
+    benchmark(oead.aamp.ParameterIO.from_binary, data[file])
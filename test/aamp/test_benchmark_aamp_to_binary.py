@@ -0,0 +1,13 @@
+import pytest
+import oead
+
+from utils import make_test_cases_aamp
+
+cases, data = make_test_cases_aamp()
+
+
+@pytest.mark.parametrize("file", cases)
+def test_aamp_to_bin_oead(benchmark, file):
+    benchmark.group = "to_bin: " + file
+    pio = oead.aamp.ParameterIO.from_binary(data[file])
+    assert benchmark(pio.to_binary) == data[file]
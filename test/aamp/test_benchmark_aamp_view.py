@@ -0,0 +1,36 @@
+import pytest
+import oead
+
+from utils import make_test_cases_aamp
+
+cases, data = make_test_cases_aamp()
+
+
+def find_last_parameter(pio):
+    objects = list(pio.objects.items())
+    if not objects or not len(objects[-1][1].params):
+        pytest.skip("no parameters in the root list")
+    name, obj = objects[-1]
+    return name, list(obj.params.keys())[-1]
+
+
+def lookup_from_binary(data, obj, param):
+    return oead.aamp.ParameterIO.from_binary(data).objects[obj].params[param]
+
+
+def lookup_view(data, obj, param):
+    return oead.aamp.ParameterIOView(data).get_root().object(obj)[param].type()
+
+
+@pytest.mark.parametrize("file", cases)
+def test_lookup_from_binary(benchmark, file):
+    benchmark.group = "aamp lookup: " + file
+    obj, param = find_last_parameter(oead.aamp.ParameterIO.from_binary(data[file]))
+    benchmark(lookup_from_binary, data[file], obj, param)
+
+
+@pytest.mark.parametrize("file", cases)
+def test_lookup_view(benchmark, file):
+    benchmark.group = "aamp lookup: " + file
+    obj, param = find_last_parameter(oead.aamp.ParameterIO.from_binary(data[file]))
+    benchmark(lookup_view, data[file], obj, param)
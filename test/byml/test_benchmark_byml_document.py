@@ -0,0 +1,25 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/*.byml")
+
+
+@pytest.mark.parametrize("file", cases)
+def test_parse_byml(benchmark, file):
+    benchmark.group = "parse+free: " + file
+    benchmark(lambda: oead.byml.from_binary(data[file]))
+
+
+@pytest.mark.parametrize("file", cases)
+def test_parse_document(benchmark, file):
+    benchmark.group = "parse+free: " + file
+    benchmark(lambda: oead.byml.Document.from_binary(data[file]))
+
+
+@pytest.mark.parametrize("file", cases)
+def test_document_to_byml(benchmark, file):
+    benchmark.group = "document to byml: " + file
+    doc = oead.byml.Document.from_binary(data[file])
+    benchmark(doc.to_byml)
@@ -21,3 +21,9 @@ def test_parse_byml(benchmark, file):
 def test_parse_oead(benchmark, file):
     benchmark.group = "parse: " + file
     benchmark(oead.byml.from_binary, data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_parse_oead_parallel(benchmark, file):
+    benchmark.group = "parse: " + file
+    benchmark(oead.byml.from_binary, data[file], num_threads=0)
@@ -0,0 +1,33 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/ActorInfo.product.byml")
+
+
+def lookup_keys(actors):
+    n = 0
+    for actor in actors:
+        n += "instSize" in actor
+        n += "NonExistentKey" in actor
+        n += len(actor["name"])
+    return n
+
+
+def insert_keys(actors):
+    return [oead.byml.Hash(dict(actor)) for actor in actors]
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_hash_lookup(benchmark, file):
+    benchmark.group = "hash_lookup: " + file
+    actors = oead.byml.from_binary(data[file])["Actors"]
+    benchmark(lookup_keys, actors)
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_hash_insert(benchmark, file):
+    benchmark.group = "hash_insert: " + file
+    actors = oead.byml.from_binary(data[file])["Actors"]
+    benchmark(insert_keys, actors)
@@ -0,0 +1,25 @@
+import pytest
+import oead
+
+from utils import make_test_cases, measure_heap
+
+cases, data = make_test_cases("byml/files/*.byml")
+
+
+@pytest.mark.parametrize("file", cases)
+def test_memory_byml(benchmark, file):
+    benchmark.group = "memory: " + file
+    allocations, size = measure_heap("import oead", "oead.byml.from_binary(data)", data[file])
+    benchmark.extra_info["allocations"] = allocations
+    benchmark.extra_info["heap_bytes"] = size
+    benchmark(oead.byml.from_binary, data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_memory_document(benchmark, file):
+    benchmark.group = "memory: " + file
+    allocations, size = measure_heap("import oead", "oead.byml.Document.from_binary(data)",
+                                     data[file])
+    benchmark.extra_info["allocations"] = allocations
+    benchmark.extra_info["heap_bytes"] = size
+    benchmark(oead.byml.Document.from_binary, data[file])
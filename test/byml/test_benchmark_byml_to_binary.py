@@ -29,3 +29,14 @@ def test_to_bin_oead(benchmark, file):
     benchmark.group = "to bin: " + file
     instance = oead.byml.from_binary(data[file])
     benchmark(oead_to_bin, instance)
+
+
+def oead_to_bin_parallel(instance):
+    return oead.byml.to_binary(instance, big_endian=False, version=2, num_threads=0)
+
+
+@pytest.mark.parametrize("file", cases)
+def test_to_bin_oead_parallel(benchmark, file):
+    benchmark.group = "to bin: " + file
+    instance = oead.byml.from_binary(data[file])
+    benchmark(oead_to_bin_parallel, instance)
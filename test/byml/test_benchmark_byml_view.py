@@ -0,0 +1,57 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/ActorInfo.product.byml")
+
+
+def lookup_from_binary(data):
+    return oead.byml.from_binary(data)["Actors"][100]["name"]
+
+
+def lookup_view(data):
+    return oead.byml.View(data).get_root()["Actors"][100]["name"].get_string()
+
+
+class HashCounter(oead.byml.Visitor):
+    def __init__(self):
+        super().__init__()
+        self.count = 0
+
+    def begin_hash(self, key, size):
+        self.count += 1
+
+
+def count_from_binary(data):
+    return len(oead.byml.from_binary(data)["Actors"])
+
+
+def count_visit(data):
+    counter = HashCounter()
+    oead.byml.View(data).visit(counter)
+    return counter.count
+
+
+@pytest.mark.parametrize("file", cases)
+def test_lookup_from_binary(benchmark, file):
+    benchmark.group = "lookup: " + file
+    benchmark(lookup_from_binary, data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_lookup_view(benchmark, file):
+    benchmark.group = "lookup: " + file
+    benchmark(lookup_view, data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_scan_from_binary(benchmark, file):
+    benchmark.group = "scan: " + file
+    benchmark(count_from_binary, data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_scan_visit(benchmark, file):
+    benchmark.group = "scan: " + file
+    benchmark(count_visit, data[file])
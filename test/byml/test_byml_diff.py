@@ -0,0 +1,68 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/ActorInfo.product.byml")
+
+
+def make_actor(name):
+    return oead.byml.Hash({"name": name})
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_diff_roundtrip(file):
+    base = oead.byml.from_binary(data[file])
+    modified = oead.byml.from_binary(data[file])
+    actors = modified["Actors"]
+    actors[10]["instSize"] = 1
+    actors.insert(100, make_actor("NewActor"))
+    del actors[2000]
+    modified["NewKey"] = oead.byml.Array([1, 2])
+
+    diff = oead.byml.Diff.make(base, modified)
+    assert len(diff) == 4
+    assert diff.apply(base) == modified
+    assert len(oead.byml.Diff.make(base, base)) == 0
+
+    binary = oead.byml.to_binary(diff.to_byml(), big_endian=False)
+    loaded = oead.byml.Diff.from_byml(oead.byml.from_binary(binary))
+    assert loaded == diff
+    assert loaded.apply(base) == modified
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_merge(file):
+    base = oead.byml.from_binary(data[file])
+    ours = oead.byml.from_binary(data[file])
+    theirs = oead.byml.from_binary(data[file])
+    ours["Actors"][10]["instSize"] = 1
+    ours["Actors"].insert(100, make_actor("OurActor"))
+    theirs["Actors"][10]["name"] = "Renamed"
+    theirs["Actors"].insert(5000, make_actor("TheirActor"))
+
+    merged = oead.byml.merge(base, ours, theirs, oead.byml.MergePolicy.Fail)
+    actors = merged["Actors"]
+    assert len(actors) == len(base["Actors"]) + 2
+    assert actors[10]["instSize"] == 1 and actors[10]["name"] == "Renamed"
+    assert actors[100]["name"] == "OurActor"
+    assert actors[5001]["name"] == "TheirActor"
+
+
+def test_byml_merge_conflicts():
+    base = oead.byml.Hash({"a": 1, "b": oead.byml.Array([1, 2, 3]), "c": "x"})
+    ours = oead.byml.Hash({"a": 2, "b": oead.byml.Array([1, 4, 3]), "c": "x"})
+    theirs = oead.byml.Hash({"a": 3, "b": oead.byml.Array([1, 2, 3, 5])})
+
+    with pytest.raises(oead.byml.MergeConflictError):
+        oead.byml.merge(base, ours, theirs, oead.byml.MergePolicy.Fail)
+
+    merged = oead.byml.merge(base, ours, theirs, oead.byml.MergePolicy.PreferOurs)
+    assert merged == oead.byml.Hash({"a": 2, "b": oead.byml.Array([1, 4, 3, 5])})
+    merged = oead.byml.merge(base, ours, theirs, oead.byml.MergePolicy.PreferTheirs)
+    assert merged == oead.byml.Hash({"a": 3, "b": oead.byml.Array([1, 4, 3, 5])})
+
+    # Removing a value that the other side modified is a conflict too.
+    del theirs["a"]
+    merged = oead.byml.merge(base, ours, theirs, oead.byml.MergePolicy.PreferTheirs)
+    assert "a" not in merged
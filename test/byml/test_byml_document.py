@@ -0,0 +1,77 @@
+import struct
+
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/*.byml")
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_document_from_binary(file):
+    doc = oead.byml.Document.from_binary(data[file])
+    assert doc.to_byml() == oead.byml.from_binary(data[file])
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_document_from_byml(file):
+    byml = oead.byml.from_binary(data[file])
+    doc = oead.byml.Document.from_byml(byml)
+    assert doc.to_byml() == byml
+    assert oead.byml.from_binary(doc.to_binary(big_endian=False)) == byml
+
+
+def test_byml_document_lookup():
+    doc = oead.byml.Document.from_binary(data["ActorInfo.product.byml"])
+    actors = doc.get_root()["Actors"]
+    assert actors[0]["name"].get_string() == "EnemyFortressMgrTag"
+    assert actors[0].find("__nonexistent_key__") is None
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_document_snapshot(file):
+    doc = oead.byml.Document.from_binary(data[file])
+    snapshot = doc.to_snapshot()
+    loaded = oead.byml.Document.from_snapshot(snapshot)
+    assert loaded.to_byml() == oead.byml.from_binary(data[file])
+    assert loaded.get_arena_size() == 0
+    assert loaded.to_snapshot() == snapshot
+
+
+def test_byml_document_snapshot_invalid():
+    snapshot = bytearray(oead.byml.Document.from_binary(data["ActorInfo.product.byml"]).to_snapshot())
+    snapshot[len(snapshot) // 2] ^= 1
+    with pytest.raises(oead.InvalidDataError):
+        oead.byml.Document.from_snapshot(snapshot)
+    with pytest.raises(oead.InvalidDataError):
+        oead.byml.Document.from_snapshot(snapshot[:16])
+
+
+def test_byml_document_snapshot_invalid_nodes():
+    doc = oead.byml.Document.from_byml(oead.byml.Hash({"a": oead.byml.Array([1, 2]), "s": "str"}))
+    snapshot = doc.to_snapshot()
+    # The root node follows the 32-byte header: type (u32), size (u32) and offset (u64).
+    # Nodes are checked even if the checksum is not verified.
+    for fmt, pos, value in (("=I", 0x20, 100), ("=I", 0x24, 0xffff), ("=Q", 0x28, 1),
+                            ("=Q", 0x28, 1 << 40), ("=Q", 0x28, (1 << 64) - 0x100)):
+        corrupted = bytearray(snapshot)
+        struct.pack_into(fmt, corrupted, pos, value)
+        with pytest.raises(oead.InvalidDataError):
+            oead.byml.Document.from_snapshot(corrupted, verify_checksum=False)
+
+
+def test_byml_document_snapshot_unterminated_strings():
+    doc = oead.byml.Document.from_byml(oead.byml.Hash({"key": "value"}))
+    snapshot = doc.to_snapshot()
+    # Strings and hash keys must be null-terminated inside the document data.
+    for string in (b"key", b"value"):
+        corrupted = bytearray(snapshot)
+        corrupted[snapshot.index(string + b"\0") + len(string)] = ord("x")
+        with pytest.raises(oead.InvalidDataError):
+            oead.byml.Document.from_snapshot(corrupted, verify_checksum=False)
+    # The document data size (header offset 0x10) ends right before the terminator.
+    corrupted = bytearray(snapshot)
+    struct.pack_into("=Q", corrupted, 0x10, snapshot.index(b"value\0") + len(b"value") - 0x20)
+    with pytest.raises(oead.InvalidDataError):
+        oead.byml.Document.from_snapshot(corrupted, verify_checksum=False)
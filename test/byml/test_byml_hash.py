@@ -0,0 +1,63 @@
+import random
+
+import pytest
+import oead
+
+# Keys that share prefixes, differ only after the first 8 bytes or in trailing null characters,
+# and contain non-ASCII characters (which must be compared as unsigned bytes).
+KEYS = ["", "a", "a\0", "ab", "B", "abcdefgg", "abcdefgh", "abcdefgh\0", "abcdefghi",
+        "abcdefgi", "abcdefghij", "\xe9t\xe9", "z" * 20, "z" * 21]
+MISSING_KEYS = ["abcdefg", "abcdefghh", "a\0\0", "z" * 19, "\xe9"]
+
+
+def make_keys(n):
+    return KEYS + [f"key_{i:04}" for i in range(n)]
+
+
+@pytest.mark.parametrize("num_extra_keys", [0, 100])
+def test_byml_hash_order(num_extra_keys):
+    keys = make_keys(num_extra_keys)
+    random.Random(0).shuffle(keys)
+    h = oead.byml.Hash()
+    for i, key in enumerate(keys):
+        h[key] = i
+    assert list(h.keys()) == sorted(keys)
+    for i, key in enumerate(keys):
+        assert key in h
+        assert h[key] == i
+    for key in MISSING_KEYS:
+        assert key not in h
+        assert h.get(key, None) is None
+
+
+@pytest.mark.parametrize("num_extra_keys", [0, 100])
+def test_byml_hash_erase(num_extra_keys):
+    keys = make_keys(num_extra_keys)
+    h = oead.byml.Hash({key: i for i, key in enumerate(keys)})
+    erased = keys[::3]
+    for key in erased:
+        del h[key]
+    remaining = [key for key in keys if key not in erased]
+    assert list(h.keys()) == sorted(remaining)
+    for key in erased:
+        assert key not in h
+    for key in remaining:
+        assert h[key] == keys.index(key)
+
+    # Keys can be inserted again after being erased.
+    for key in erased:
+        h[key] = -1
+    assert list(h.keys()) == sorted(keys)
+
+
+def test_byml_hash_unsorted_text():
+    # Keys are inserted in document order, which is not sorted here.
+    keys = [key for key in make_keys(20) if "\0" not in key]
+    random.Random(1).shuffle(keys)
+    text = "".join(f"'{key}': {i}\n" for i, key in enumerate(keys))
+    h = oead.byml.from_text(text)
+    assert list(h.keys()) == sorted(keys)
+    assert h == oead.byml.Hash({key: i for i, key in enumerate(keys)})
+
+    # Parsing binary documents inserts keys in order.
+    assert oead.byml.from_binary(oead.byml.to_binary(h, big_endian=False)) == h
@@ -0,0 +1,75 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/ActorInfo.product.byml")
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_patch_in_place(file):
+    buffer = bytearray(data[file])
+    path = '/Actors[name=="Armor_066_Lower"]/instSize'
+    assert oead.byml.try_patch_in_place(buffer, path, 12345)
+
+    doc = oead.byml.from_binary(data[file])
+    for actor in doc["Actors"]:
+        if actor["name"] == "Armor_066_Lower":
+            actor["instSize"] = 12345
+    assert oead.byml.from_binary(buffer) == doc
+    assert oead.byml.from_binary(oead.byml.patch(data[file], path, 12345)) == doc
+
+
+def make_shared_document():
+    item = oead.byml.Hash({"a": 1, "b": oead.S64(5)})
+    return oead.byml.Hash({"items": oead.byml.Array([item, item]), "s": "x"})
+
+
+@pytest.mark.parametrize("big_endian", [False, True])
+def test_byml_patch_shared(big_endian):
+    doc = make_shared_document()
+    binary = oead.byml.to_binary(doc, big_endian=big_endian, version=3)
+
+    # Both items are deduplicated, so they cannot be patched in place.
+    buffer = bytearray(binary)
+    assert not oead.byml.try_patch_in_place(buffer, "/items[0]/a", 2)
+    assert buffer == binary
+    assert not oead.byml.try_patch_in_place(buffer, "/items[0]/b", oead.S64(6))
+
+    patched = oead.byml.patch(binary, "/items[0]/a", 2)
+    doc["items"][0]["a"] = 2
+    assert oead.byml.from_binary(patched) == doc
+    assert patched[:2] == (b"BY" if big_endian else b"YB")
+
+    # Changing the type of a value requires a rewrite too.
+    patched = oead.byml.patch(patched, "/s", 3)
+    doc["s"] = 3
+    assert oead.byml.from_binary(patched) == doc
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_patch_in_place_many(file):
+    buffer = bytearray(data[file])
+    patcher = oead.byml.InPlacePatcher(buffer)
+    doc = oead.byml.from_binary(data[file])
+    actors = doc["Actors"]
+    for i in range(100):
+        if "instSize" in actors[i] and type(actors[i]["instSize"]) is int:
+            assert patcher.try_patch(f"/Actors[{i}]/instSize", i)
+            actors[i]["instSize"] = i
+    assert oead.byml.from_binary(buffer) == doc
+
+
+def test_byml_patch_shared_many():
+    buffer = bytearray(oead.byml.to_binary(make_shared_document(), big_endian=False))
+    patcher = oead.byml.InPlacePatcher(buffer)
+    for path, value in (("/items[0]/a", 2), ("/items[1]/a", 2), ("/items[1]/b", oead.S64(6))):
+        assert not patcher.try_patch(path, value)
+
+
+def test_byml_patch_invalid_path():
+    binary = oead.byml.to_binary(make_shared_document(), big_endian=False)
+    with pytest.raises(ValueError):
+        oead.byml.patch(binary, "/items/*/a", 2)
+    with pytest.raises(ValueError):
+        oead.byml.patch(binary, "/nonexistent", 2)
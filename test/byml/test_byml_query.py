@@ -0,0 +1,48 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/ActorInfo.product.byml")
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_query_wildcard(file):
+    doc = oead.byml.from_binary(data[file])
+    view = oead.byml.View(data[file])
+    names = oead.byml.Query("/Actors/*/name").execute(view)
+    assert [node.get_string() for node in names] == [actor["name"] for actor in doc["Actors"]]
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_query_filter(file):
+    doc = oead.byml.from_binary(data[file])
+    view = oead.byml.View(data[file])
+
+    result = oead.byml.Query('/Actors[name=="Armor_066_Lower"]/profile').execute(view)
+    expected = [a["profile"] for a in doc["Actors"] if a["name"] == "Armor_066_Lower"]
+    assert [node.to_byml() for node in result] == expected
+
+    result = oead.byml.Query('/Actors[name!="Armor_066_Lower"]').execute(view)
+    assert len(result) == len(doc["Actors"]) - 1
+
+    size = int(doc["Actors"][0]["instSize"])
+    result = oead.byml.Query(f"/Actors[instSize == {size}]/name").execute(view)
+    assert result[0].get_string() == doc["Actors"][0]["name"]
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_query_index(file):
+    doc = oead.byml.from_binary(data[file])
+    view = oead.byml.View(data[file])
+    actors = oead.byml.Query("/Actors").execute(view)[0]
+    result = oead.byml.Query('/[1]/"name"').execute(actors)
+    assert [node.get_string() for node in result] == [doc["Actors"][1]["name"]]
+    assert oead.byml.Query("/Actors[100000]").execute(view) == []
+    assert oead.byml.Query("/NonExistentKey/*").execute(view) == []
+
+
+@pytest.mark.parametrize("query", ["Actors", "/Actors[name=", "/Actors[name=x]", '/"Actors'])
+def test_byml_query_invalid(query):
+    with pytest.raises(ValueError):
+        oead.byml.Query(query)
@@ -23,6 +23,44 @@ def test_byml_roundtrip_bin_big_endian(file):
     assert data == data2
 
 
+@pytest.mark.parametrize("file", cases_bin)
+def test_byml_from_binary_parallel(file):
+    data = oead.byml.from_binary(data_bin[file])
+    assert oead.byml.from_binary(data_bin[file], num_threads=4) == data
+
+
+@pytest.mark.parametrize("file", cases_bin)
+def test_byml_to_binary_parallel(file):
+    data = oead.byml.from_binary(data_bin[file])
+    for big_endian in (False, True):
+        serialized = oead.byml.to_binary(data, big_endian=big_endian, version=2)
+        assert oead.byml.to_binary(data, big_endian, 2, num_threads=4) == serialized
+
+
+@pytest.mark.parametrize("file", cases_bin)
+def test_byml_to_binary_into(file):
+    data = oead.byml.from_binary(data_bin[file])
+    serialized = oead.byml.to_binary(data, big_endian=True, version=3)
+    assert oead.byml.get_binary_size(data) == len(serialized)
+
+    buffer = bytearray(len(serialized) + 4)
+    size = oead.byml.to_binary_into(data, buffer, big_endian=True, version=3)
+    assert size == len(serialized)
+    assert buffer[:size] == serialized
+
+    with pytest.raises(ValueError):
+        oead.byml.to_binary_into(data, bytearray(len(serialized) - 1), big_endian=True)
+
+
+def test_byml_roundtrip_binary_last():
+    # The document ends with a 1-byte binary node, which must not be followed by padding.
+    data = oead.byml.from_text("a: !!binary AQ==\n")
+    serialized = oead.byml.to_binary(data, big_endian=False, version=4)
+    assert len(serialized) == 0x31
+    assert oead.byml.get_binary_size(data) == len(serialized)
+    assert oead.byml.from_binary(serialized) == data
+
+
 @pytest.mark.parametrize("file", cases_text)
 def test_byml_roundtrip_text(file):
     data = oead.byml.from_text(data_text[file])
@@ -31,6 +69,61 @@ def test_byml_roundtrip_text(file):
     assert data == data2
 
 
+def test_byml_from_text_scalars():
+    data = oead.byml.from_text("""
+a: 0x10
+b: -5
+c: !u 0xffffffff
+d: !l -9000000000
+e: !ul 18446744073709551615
+f: 1.5
+g: '12'
+h: 12a
+i: true
+j: null
+""")
+    assert data["a"] == 16
+    assert data["b"] == -5
+    assert data["c"] == oead.U32(0xffffffff)
+    assert data["d"] == oead.S64(-9000000000)
+    assert data["e"] == oead.U64(18446744073709551615)
+    assert data["f"] == oead.F32(1.5)
+    assert data["g"] == "12"
+    assert data["h"] == "12a"
+    assert data["i"] is True
+    assert data["j"] is None
+
+
+def test_byml_from_text_repeated():
+    # Parse documents of different sizes in a row to check that reused parser state
+    # does not leak between calls.
+    large = data_text[cases_text[0]]
+    expected = oead.byml.from_text(large)
+    assert oead.byml.from_text("{a: 1}") == oead.byml.Hash({"a": 1})
+    assert oead.byml.from_text(large) == expected
+    assert oead.byml.from_text("[1, 2]") == oead.byml.Array([1, 2])
+
+
+def test_byml_to_text_strings():
+    # Strings that must be quoted or escaped to be read back as the same string.
+    strings = ["", " a", "a ", "-", "- a", "--", "...", ".5", "0x10", "12", "true", "null",
+               "a: b", "a #b", "#", "[a]", "{a}", "'a'", "\"a\"", "a\nb", "a\tb", "\x01",
+               "é", "\u3042", "a" * 200 + " " + "b" * 200]
+    data = oead.byml.Hash({s: oead.byml.Array([s]) for s in strings})
+    assert oead.byml.from_text(oead.byml.to_text(data)) == data
+    assert oead.byml.to_text(oead.byml.Hash({"a": oead.byml.Array([])})) == "a: []\n"
+
+
+def test_byml_roundtrip_string_lengths():
+    # Cover both inline and heap-allocated strings.
+    strings = ["a" * n for n in range(40)] + ["\u3042" * n for n in range(5)]
+    data = oead.byml.Hash({str(i): s for i, s in enumerate(strings)})
+    for big_endian in (False, True):
+        data2 = oead.byml.from_binary(oead.byml.to_binary(data, big_endian=big_endian))
+        assert data2 == data
+        assert [data2[str(i)] for i in range(len(strings))] == strings
+
+
 @pytest.mark.parametrize("file", cases_bin)
 def test_byml_roundtrip_bin_to_text(file):
     data = oead.byml.from_binary(data_bin[file])
@@ -0,0 +1,139 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, data = make_test_cases("byml/files/*.byml")
+
+
+def check_node(value, node):
+    if isinstance(value, oead.byml.Hash):
+        assert node.get_type() == oead.byml.Type.Hash
+        assert node.keys() == list(value.keys())
+        for key, item in value.items():
+            assert key in node
+            check_node(item, node[key])
+        assert "__nonexistent_key__" not in node
+    elif isinstance(value, oead.byml.Array):
+        assert node.get_type() == oead.byml.Type.Array
+        assert len(node) == len(value)
+        for i, item in enumerate(value):
+            check_node(item, node[i])
+    else:
+        assert node.to_byml() == value
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_view(file):
+    doc = oead.byml.from_binary(data[file])
+    view = oead.byml.View(data[file])
+    root = view.get_root()
+    assert root.to_byml() == doc
+    check_node(doc, root)
+
+
+def test_byml_view_lookup():
+    view = oead.byml.View(data["ActorInfo.product.byml"])
+    actors = view.get_root()["Actors"]
+    assert actors[0]["name"].get_string() == "EnemyFortressMgrTag"
+    with pytest.raises(IndexError):
+        actors[len(actors)]
+    with pytest.raises(IndexError):
+        actors[0]["__nonexistent_key__"]
+
+
+def test_byml_view_truncated_hash_entry():
+    data = oead.byml.to_binary(oead.byml.Hash({"a": 1}), big_endian=False, version=2)
+    # Cut the root hash entry off after its key index.
+    view = oead.byml.View(data[:-5])
+    with pytest.raises(oead.InvalidDataError):
+        view.get_root()["a"]
+
+
+
+class Collector(oead.byml.Visitor):
+    """Rebuilds a document from visitor events."""
+
+    def __init__(self):
+        super().__init__()
+        self.stack = []
+        self.result = None
+
+    def add(self, key, value):
+        if not self.stack:
+            self.result = value
+        elif isinstance(self.stack[-1][1], oead.byml.Array):
+            self.stack[-1][1].append(value)
+        else:
+            self.stack[-1][1][key] = value
+
+    def begin_array(self, key, size):
+        self.stack.append((key, oead.byml.Array()))
+
+    def begin_hash(self, key, size):
+        self.stack.append((key, oead.byml.Hash()))
+
+    def scalar(self, key, node):
+        self.add(key, node.to_byml())
+
+    def end(self):
+        self.add(*self.stack.pop())
+
+
+@pytest.mark.parametrize("file", cases)
+def test_byml_view_visit(file):
+    doc = oead.byml.from_binary(data[file])
+    collector = Collector()
+    oead.byml.View(data[file]).visit(collector)
+    assert collector.result == doc
+
+
+class NameCollector(oead.byml.Visitor):
+    def __init__(self, skip=None, limit=None):
+        super().__init__()
+        self.skip = skip
+        self.limit = limit
+        self.names = []
+
+    def begin_array(self, key, size):
+        if key == self.skip:
+            return oead.byml.Visitor.Action.Skip
+
+    def scalar(self, key, node):
+        if key == "name":
+            self.names.append(node.get_string())
+            if len(self.names) == self.limit:
+                return oead.byml.Visitor.Action.Stop
+
+
+def test_byml_view_visit_skip_and_stop():
+    view = oead.byml.View(data["ActorInfo.product.byml"])
+
+    visitor = NameCollector(skip="Actors")
+    view.visit(visitor)
+    assert visitor.names == []
+
+    visitor = NameCollector(limit=3)
+    view.visit(visitor)
+    assert len(visitor.names) == 3
+    assert visitor.names[0] == "EnemyFortressMgrTag"
+
+
+class NodeCollector(oead.byml.Visitor):
+    def __init__(self):
+        super().__init__()
+        self.nodes = []
+
+    def scalar(self, key, node):
+        self.nodes.append(node)
+
+
+def test_byml_view_visit_keeps_view_alive():
+    doc = oead.byml.Hash({"a": 1, "b": "string", "c": oead.S64(5)})
+    collector = NodeCollector()
+    # Neither the view nor the data are referenced after visiting.
+    oead.byml.View(bytes(oead.byml.to_binary(doc, big_endian=False))).visit(collector)
+    a, b, c = collector.nodes
+    assert a.get_int() == 1
+    assert b.get_string() == "string"
+    assert c.get_int64() == 5
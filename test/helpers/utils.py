@@ -1,4 +1,7 @@
 from pathlib import Path
+import struct
+
+import oead
 import pytest
 
 
@@ -34,3 +37,93 @@ def make_test_cases_aamp():
         Path("aamp") / "files" / "AIProgram" / "Player_Link.baiprog",
         Path("aamp") / "files" / "AIProgram" / "Horse.baiprog",
     ])
+
+
+def make_test_cases_aamp_curves():
+    return make_test_cases_from_file_list([
+        Path("aamp") / "files" / "common.bagllmap",
+        Path("aamp") / "files" / "master_field.baglccr",
+    ])
+
+
+AAMP_CURVE_TYPES = (
+    oead.aamp.Parameter.Type.Curve1,
+    oead.aamp.Parameter.Type.Curve2,
+    oead.aamp.Parameter.Type.Curve3,
+    oead.aamp.Parameter.Type.Curve4,
+)
+AAMP_BUFFER_GETTERS = {
+    oead.aamp.Parameter.Type.BufferInt: "get_buffer_int",
+    oead.aamp.Parameter.Type.BufferF32: "get_buffer_f32",
+    oead.aamp.Parameter.Type.BufferU32: "get_buffer_u32",
+    oead.aamp.Parameter.Type.BufferBinary: "get_buffer_binary",
+}
+
+
+def check_aamp_param_data(param_view, param):
+    if param.type() in AAMP_CURVE_TYPES:
+        # Each curve is stored as two u32 followed by 30 floats.
+        raw = bytes(param_view.get_curves())
+        assert len(raw) == 0x80 * len(param.v)
+        for i, curve in enumerate(param.v):
+            a, b, *floats = struct.unpack_from("<2I30f", raw, 0x80 * i)
+            assert (a, b) == (curve.a, curve.b)
+            assert floats == list(curve.floats)
+    elif param.type() in AAMP_BUFFER_GETTERS:
+        assert bytes(getattr(param_view, AAMP_BUFFER_GETTERS[param.type()])()) == bytes(param.v)
+
+
+
+_HEAP_SCRIPT = """
+import ctypes, sys
+{setup}
+data = sys.stdin.buffer.read()
+# libc.so.6 exports a no-op mtrace, so look the functions up in the debug library itself.
+debug_lib = ctypes.CDLL({debug_lib!r})
+dlvsym = ctypes.CDLL(None).dlvsym
+dlvsym.restype = ctypes.c_void_p
+dlvsym.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p]
+mtrace, muntrace = (ctypes.CFUNCTYPE(None)(dlvsym(debug_lib._handle, name, b"GLIBC_2.2.5"))
+                    for name in (b"mtrace", b"muntrace"))
+mtrace()
+result = {statement}
+muntrace()
+"""
+
+
+def measure_heap(setup, statement, data):
+    """Runs `statement` (which can use `data`) in a new interpreter with glibc malloc tracing.
+
+    Returns the number of allocations and the number of bytes that are still allocated
+    while the result is alive. Skips the test if malloc tracing is unavailable.
+    """
+    import ctypes.util
+    import os
+    import subprocess
+    import sys
+    import tempfile
+
+    debug_lib = ctypes.util.find_library("c_malloc_debug")
+    if not sys.platform.startswith("linux") or debug_lib is None:
+        pytest.skip("glibc malloc tracing is unavailable")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        trace_path = os.path.join(tmp, "trace")
+        env = dict(os.environ, MALLOC_TRACE=trace_path, LD_PRELOAD=debug_lib)
+        script = _HEAP_SCRIPT.format(setup=setup, statement=statement, debug_lib=debug_lib)
+        subprocess.run([sys.executable, "-c", script], input=data, env=env, check=True)
+        with open(trace_path) as f:
+            lines = f.read().splitlines()
+
+    # Allocations are logged as "@ caller + address size" (realloc: "<" and then ">") and
+    # frees as "@ caller - address".
+    allocations = 0
+    live = dict()
+    for line in lines:
+        fields = line.split()
+        if len(fields) >= 4 and fields[-3] in ("+", ">"):
+            allocations += 1
+            live[fields[-2]] = int(fields[-1], 16)
+        elif len(fields) >= 3 and fields[-2] in ("-", "<"):
+            live.pop(fields[-1], None)
+    return allocations, sum(live.values())
@@ -0,0 +1,81 @@
+import pytest
+import oead
+
+from utils import make_test_cases
+
+cases, cases_data = make_test_cases("sarc/files/*.sarc")
+
+
+def test_canonical_name():
+    assert oead.rstb.get_canonical_name("Actor/Pack/Enemy_Lizalfos.sbactorpack") == "Actor/Pack/Enemy_Lizalfos.bactorpack"
+    assert oead.rstb.get_canonical_name("Model/Enemy_Lizalfos.Tex1.sbfres") == "Model/Enemy_Lizalfos.Tex1.bfres"
+    assert oead.rstb.get_canonical_name("Pack/Bootup.pack") == "Pack/Bootup.pack"
+
+
+def test_estimate_yaz0():
+    data = bytes(range(256)) * 64
+    name = "Actor/Physics/Test.bphysics"
+    assert oead.rstb.estimate_size(name, data, oead.Endianness.Little) is None
+    size = oead.rstb.estimate_size(name, data, oead.Endianness.Little, allow_heuristics=True)
+    assert size is not None
+    assert oead.rstb.estimate_size("Actor/Physics/Test.sbphysics", oead.yaz0.compress(data), oead.Endianness.Little, allow_heuristics=True) == size
+
+
+@pytest.mark.parametrize("file", cases)
+def test_estimate_archive_sizes(file):
+    arc = oead.Sarc(cases_data[file])
+    entries = oead.rstb.estimate_archive_sizes(arc, oead.Endianness.Little, allow_heuristics=True)
+    assert [e.name for e in entries] == [oead.rstb.get_canonical_name(f.name) for f in arc.get_files()]
+    sequential = oead.rstb.estimate_archive_sizes(arc, oead.Endianness.Little, allow_heuristics=True, num_threads=1)
+    assert [(e.name, e.size) for e in entries] == [(e.name, e.size) for e in sequential]
+
+
+def test_estimate_archive_sizes_nested():
+    endian = oead.Endianness.Little
+    inner_writer = oead.SarcWriter(endian)
+    inner_writer.files["Actor/Physics/Nested.bphysics"] = bytes(range(256)) * 16
+    inner_writer.files["Actor/ModelList/Nested.bmodellist"] = bytes(range(128)) * 8
+    inner_data = inner_writer.write()[1]
+    inner = oead.Sarc(inner_data)
+    inner_entries = [(oead.rstb.get_canonical_name(f.name),
+                      oead.rstb.estimate_size(f.name, f.data, endian, allow_heuristics=True))
+                     for f in inner.get_files()]
+    assert dict(inner_entries)["Actor/Physics/Nested.bphysics"] is not None
+
+    writer = oead.SarcWriter(endian)
+    writer.files["Pack/Nested.pack"] = inner_data
+    writer.files["Actor/Pack/Nested.sbactorpack"] = oead.yaz0.compress(inner_data)
+    writer.files["Actor/Physics/Outer.bphysics"] = bytes(range(256)) * 4
+    arc = oead.Sarc(writer.write()[1])
+
+    expected = []
+    for f in arc.get_files():
+        expected.append((oead.rstb.get_canonical_name(f.name),
+                         oead.rstb.estimate_size(f.name, f.data, endian, allow_heuristics=True)))
+        if f.name.endswith("pack"):
+            expected += inner_entries
+
+    entries = oead.rstb.estimate_archive_sizes(arc, endian, allow_heuristics=True)
+    assert [(e.name, e.size) for e in entries] == expected
+    assert sum(e.name == "Actor/Physics/Nested.bphysics" for e in entries) == 2
+    sequential = oead.rstb.estimate_archive_sizes(arc, endian, allow_heuristics=True, num_threads=1)
+    assert [(e.name, e.size) for e in sequential] == expected
+
+
+@pytest.mark.parametrize("file", cases)
+@pytest.mark.parametrize("endian", [oead.Endianness.Big, oead.Endianness.Little])
+def test_rstb_roundtrip(file, endian):
+    arc = oead.Sarc(cases_data[file])
+    table = oead.rstb.ResourceSizeTable()
+    for entry in oead.rstb.estimate_archive_sizes(arc, endian, allow_heuristics=True):
+        table.set_size(entry.name, entry.size)
+    table.name_map["Actor/Pack/Collision.bactorpack"] = 0x1234
+
+    table2 = oead.rstb.ResourceSizeTable.from_binary(table.to_binary(endian), endian)
+    assert table == table2
+    assert table2.get_size("Actor/Pack/Collision.bactorpack") == 0x1234
+    for f in arc.get_files():
+        assert oead.rstb.get_canonical_name(f.name) in table2
+
+    table2.delete_entry("Actor/Pack/Collision.bactorpack")
+    assert "Actor/Pack/Collision.bactorpack" not in table2